@@ -272,6 +272,16 @@ class Base(TreeNodeObject):
             self.name = self.__class__.__name__
         return self.name
 
+    def tno_get_tooltip(self, node):
+        """Gets the tooltip to display for a specified object.  Shows
+        the execution statistics when the pipeline is being profiled.
+        """
+        from mayavi.core.profiler import get_profile
+        stats = get_profile(self)
+        if stats is None:
+            return super(Base, self).tno_get_tooltip(node)
+        return str(stats)
+
     def tno_get_view(self, node):
         """Gets the View to use when editing an object.
         """
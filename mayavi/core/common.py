@@ -10,6 +10,8 @@ messages etc.
 import sys
 import traceback
 import logging
+import threading
+import Queue
 
 # Enthought library imports.
 from apptools.persistence.state_pickler import create_instance
@@ -144,3 +146,84 @@ def handle_children_state(children, kids):
     # Now set the children in one shot.
     children[:] = m_children
 
+
+def cpu_count():
+    """Returns the number of processors, 1 if it is not known."""
+    try:
+        import multiprocessing
+        return multiprocessing.cpu_count()
+    except (ImportError, NotImplementedError):
+        return 1
+
+
+def parallel_map(func, items, n_threads=0, new_state=None, cancel=None,
+                 progress=None, interval=0.1):
+    """Returns `[func(x) for x in items]` computed on a pool of up to
+    `n_threads` worker threads, all the processors if zero.  This only
+    speeds up functions spending their time without the Python global
+    interpreter lock, like numpy operations on large arrays or the
+    decoding of files by a VTK built to release the lock.
+
+    If `new_state()` is given, it is called on the calling thread once
+    for each worker and `func(state, x)` is called with the state of
+    the worker, e.g. a VTK reader which may not be shared by threads.
+
+    Setting the `cancel` threading.Event stops the workers once the
+    items being processed are done, None is then returned.
+    `progress(fraction)` is called on the calling thread every
+    `interval` seconds with the fraction of the items done, returning
+    False from it cancels.  The first exception raised by `func`
+    cancels the other items and is raised again.
+    """
+    items = list(items)
+    n = len(items)
+    if cancel is None:
+        cancel = threading.Event()
+    results = [None]*n
+    errors = []
+    done = [0]
+    lock = threading.Lock()
+    queue = Queue.Queue()
+    for i in range(n):
+        queue.put(i)
+
+    def _work(state):
+        while not cancel.isSet():
+            try:
+                i = queue.get_nowait()
+            except Queue.Empty:
+                return
+            try:
+                if new_state is None:
+                    results[i] = func(items[i])
+                else:
+                    results[i] = func(state, items[i])
+            except Exception, e:
+                with lock:
+                    errors.append(e)
+                cancel.set()
+                return
+            with lock:
+                done[0] += 1
+
+    threads = []
+    for i in range(min(n_threads or cpu_count(), n)):
+        state = None
+        if new_state is not None:
+            state = new_state()
+        t = threading.Thread(target=_work, args=(state,))
+        t.setDaemon(True)
+        t.start()
+        threads.append(t)
+    while len(threads) > 0:
+        threads[0].join(interval)
+        threads = [t for t in threads if t.isAlive()]
+        if progress is not None and \
+               progress(float(done[0])/n) is False:
+            cancel.set()
+
+    if len(errors) > 0:
+        raise errors[0]
+    if cancel.isSet():
+        return None
+    return results
@@ -0,0 +1,411 @@
+"""Binary storage of datasets in saved visualizations.
+
+When a visualization is saved with binary datasets, the datasets of
+the `VTKDataSource` objects are not written in the pickled state as VTK
+legacy ASCII strings.  The state only holds a reference and the arrays
+of the datasets are written, optionally zlib compressed, in a chunk
+following the state in the same file::
+
+    <pickled state> <arrays, 64 byte aligned> <JSON index> <trailer>
+
+The trailer (the magic string, the offset of the chunk and the offset
+of the index in the chunk) is at the end of the file, so that the
+chunk is found without parsing the state.  Uncompressed arrays are laid
+out as in memory and are copied straight into the numpy arrays given
+to VTK when loading, without any parsing.  Files without a trailer are
+loaded as before.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import json
+import mmap
+import struct
+import zlib
+from StringIO import StringIO
+
+import numpy
+
+# Enthought library imports.
+from apptools.persistence import state_pickler
+from tvtk.api import tvtk
+from tvtk import array_handler
+
+
+# The magic string of the trailer, followed by the offset of the chunk
+# in the file and of the index in the chunk.
+MAGIC = 'MV2DATA1'
+TRAILER = struct.Struct('<8sQQ')
+
+# The alignment of the arrays in the chunk.
+ALIGN = 64
+
+# The size of the blocks written and decompressed at once.
+BLOCK_SIZE = 16*1024*1024
+
+# The prefix of the references to the datasets in the state.
+REF_PREFIX = 'mv2-dataset:'
+
+# The store used by `VTKDataSource` while saving or loading.
+_active_store = None
+
+# The cell arrays of poly data.
+_POLY_CELLS = ('verts', 'lines', 'polys', 'strips')
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def get_active_store():
+    """Returns the store of the visualization being saved or loaded,
+    None otherwise."""
+    return _active_store
+
+
+def is_reference(value):
+    """True if the state value is a reference to a stored dataset."""
+    return isinstance(value, basestring) and value.startswith(REF_PREFIX)
+
+
+def _ids(cell_array):
+    return array_handler.vtk2array(tvtk.to_vtk(cell_array).GetData())
+
+
+def dataset_to_arrays(data):
+    """Returns the description of the tvtk dataset `data` and the list
+    of (description, numpy array) of its arrays.  Raises a ValueError
+    for datasets that are not supported."""
+    name = data.__class__.__name__
+    meta = {'type': name, 'active': {}}
+    arrays = []
+    def _add(role, arr, **kw):
+        if arr is None:
+            return
+        desc = {'role': role}
+        desc.update(kw)
+        arrays.append((desc, numpy.ascontiguousarray(arr)))
+
+    if name in ('ImageData', 'StructuredPoints'):
+        meta.update(extent=list(data.extent), origin=list(data.origin),
+                    spacing=list(data.spacing))
+    elif name == 'RectilinearGrid':
+        meta['extent'] = list(data.extent)
+        for c in 'xyz':
+            coords = getattr(data, '%s_coordinates'%c)
+            if coords is not None:
+                _add(c, coords.to_array())
+    elif name in ('StructuredGrid', 'PolyData', 'UnstructuredGrid'):
+        if name == 'StructuredGrid':
+            meta['extent'] = list(data.extent)
+        if data.points is not None:
+            _add('points', data.points.to_array())
+        if name == 'PolyData':
+            for role in _POLY_CELLS:
+                ca = getattr(data, role)
+                if ca is not None and ca.number_of_cells > 0:
+                    _add(role, _ids(ca), n_cells=ca.number_of_cells)
+        elif name == 'UnstructuredGrid' and data.number_of_cells > 0:
+            ca = data.get_cells()
+            _add('cells', _ids(ca), n_cells=ca.number_of_cells)
+            _add('cell_types', data.get_cell_types_array().to_array())
+            _add('cell_locations',
+                 data.get_cell_locations_array().to_array())
+    else:
+        raise ValueError('Unsupported dataset type %s'%name)
+
+    for kind in ('point_data', 'cell_data'):
+        attr = getattr(data, kind)
+        active = {}
+        for i in range(attr.number_of_arrays):
+            arr = tvtk.to_vtk(attr).GetArray(i)
+            if arr is None or arr.GetName() is None or \
+                   arr.GetDataType() not in \
+                   array_handler.get_vtk_to_numeric_typemap():
+                # Not a numeric array.
+                continue
+            _add(kind, array_handler.vtk2array(arr), name=arr.GetName())
+        for a in ('scalars', 'vectors', 'tensors'):
+            v = getattr(attr, a)
+            if v is not None and v.name is not None:
+                active[a] = v.name
+        meta['active'][kind] = active
+    return meta, arrays
+
+
+def dataset_from_arrays(meta, arrays):
+    """Builds the tvtk dataset described by `meta` with the list of
+    (description, numpy array) `arrays`.  The arrays are used by VTK
+    without a copy."""
+    name = meta['type']
+    data = getattr(tvtk, name)()
+    if 'extent' in meta:
+        data.extent = tuple(meta['extent'])
+    if 'origin' in meta:
+        data.origin = tuple(meta['origin'])
+        data.spacing = tuple(meta['spacing'])
+    for desc, arr in arrays:
+        role = desc['role']
+        if role == 'points':
+            data.points = arr
+        elif role in ('x', 'y', 'z'):
+            setattr(data, '%s_coordinates'%role, arr)
+        elif role in _POLY_CELLS:
+            ca = tvtk.CellArray()
+            ca.set_cells(desc['n_cells'], arr)
+            setattr(data, role, ca)
+    if name == 'UnstructuredGrid':
+        d = dict((desc['role'], (desc, arr)) for desc, arr in arrays)
+        if 'cells' in d:
+            ca = tvtk.CellArray()
+            ca.set_cells(d['cells'][0]['n_cells'], d['cells'][1])
+            data.set_cells(d['cell_types'][1], d['cell_locations'][1], ca)
+
+    for kind in ('point_data', 'cell_data'):
+        attr = getattr(data, kind)
+        vtk_attr = tvtk.to_vtk(attr)
+        for desc, arr in arrays:
+            if desc['role'] == kind:
+                vtk_arr = array_handler.array2vtk(arr)
+                vtk_arr.SetName(desc['name'])
+                vtk_attr.AddArray(vtk_arr)
+        for a, arr_name in meta['active'].get(kind, {}).items():
+            getattr(attr, 'set_active_%s'%a)(arr_name)
+    scalars = data.point_data.scalars
+    if name in ('ImageData', 'StructuredPoints') and scalars is not None:
+        # This is very important and if not done can lead to a segfault!
+        data.scalar_type = scalars.data_type
+        data.number_of_scalar_components = scalars.number_of_components
+    return data
+
+
+def _map_file(file_name):
+    """Returns a read-only memory map of the file, an empty string for
+    an empty file."""
+    f = open(file_name, 'rb')
+    try:
+        try:
+            return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except (ValueError, mmap.error):
+            # An empty file.
+            return ''
+    finally:
+        f.close()
+
+
+def _write_array(f, arr, compress):
+    """Writes the array in blocks and returns the number of bytes
+    written."""
+    flat = arr.reshape(-1).view(numpy.uint8)
+    n = 0
+    z = None
+    if compress:
+        # The fastest level, the arrays are large.
+        z = zlib.compressobj(1)
+    for i in range(0, len(flat), BLOCK_SIZE):
+        block = flat[i:i + BLOCK_SIZE].tostring()
+        if z is not None:
+            block = z.compress(block)
+        f.write(block)
+        n += len(block)
+    if z is not None:
+        block = z.flush()
+        f.write(block)
+        n += len(block)
+    return n
+
+
+######################################################################
+# `DatasetStore` class.
+######################################################################
+class DatasetStore(object):
+    """The datasets written after (or read from after) the state of a
+    saved visualization."""
+
+    def __init__(self, compress=False):
+        # Compress the arrays with zlib.
+        self.compress = compress
+        # The datasets to write, as (meta, arrays).
+        self._datasets = []
+        # The index and the buffer of a loaded file.
+        self._index = []
+        self._buf = None
+        self._start = 0
+        # The name, size and trailer of the mapped file, used to map it
+        # again after `release`.
+        self._file_name = None
+        self._size = 0
+        self._trailer = ''
+
+    ######################################################################
+    # Saving.
+    ######################################################################
+    def add_dataset(self, data):
+        """Records the tvtk dataset to be written and returns its
+        reference for the state, or None if it is not supported."""
+        try:
+            meta, arrays = dataset_to_arrays(data)
+        except ValueError:
+            return None
+        self._datasets.append((meta, arrays))
+        return '%s%d'%(REF_PREFIX, len(self._datasets) - 1)
+
+    def write(self, f):
+        """Writes the chunk of the recorded datasets and the trailer at
+        the current position of the file `f`."""
+        start = f.tell()
+        index = []
+        for meta, arrays in self._datasets:
+            descs = []
+            for desc, arr in arrays:
+                pad = -f.tell() % ALIGN
+                f.write('\0'*pad)
+                desc = dict(desc, dtype=arr.dtype.str, shape=arr.shape,
+                            offset=f.tell() - start,
+                            codec='zlib' if self.compress else None)
+                desc['size'] = _write_array(f, arr, self.compress)
+                descs.append(desc)
+            meta = dict(meta, arrays=descs)
+            index.append(meta)
+        index_offset = f.tell() - start
+        f.write(json.dumps(index))
+        f.write(TRAILER.pack(MAGIC, start, index_offset))
+
+    ######################################################################
+    # Loading.
+    ######################################################################
+    @classmethod
+    def from_buffer(cls, buf, file_name=None):
+        """Returns the store of the saved file in the buffer `buf` (a
+        string or a memory map), None if it has no datasets chunk.
+        `file_name` is the name of the file mapped in `buf`, if any.
+        """
+        size = len(buf)
+        if size < TRAILER.size:
+            return None
+        trailer = buf[size - TRAILER.size:]
+        magic, start, index_offset = TRAILER.unpack(trailer)
+        if magic != MAGIC:
+            return None
+        store = cls()
+        store._buf = buf
+        store._start = start
+        store._size = size
+        store._trailer = trailer
+        if isinstance(buf, mmap.mmap):
+            store._file_name = file_name
+        store._index = json.loads(buf[start + index_offset:
+                                      size - TRAILER.size])
+        return store
+
+    def state_size(self):
+        """The size of the pickled state before the chunk."""
+        return self._start
+
+    def get_dataset(self, ref):
+        """Returns the tvtk dataset of the given reference.  The arrays
+        are copied out of the file.  Raises an IOError if the file was
+        released and has changed since."""
+        meta = self._index[int(ref[len(REF_PREFIX):])]
+        buf = self._get_buffer()
+        arrays = [(desc, self._read_array(buf, desc))
+                  for desc in meta['arrays']]
+        return dataset_from_arrays(meta, arrays)
+
+    def release(self):
+        """Unmaps the file, so that it may be changed or removed while
+        parts of the visualization are still to be loaded.  The file is
+        mapped again by `get_dataset`."""
+        if self._file_name is not None and self._buf is not None:
+            self._buf.close()
+            self._buf = None
+
+    def _get_buffer(self):
+        if self._buf is None:
+            buf = _map_file(self._file_name)
+            if len(buf) != self._size or \
+                   buf[len(buf) - TRAILER.size:] != self._trailer:
+                if isinstance(buf, mmap.mmap):
+                    buf.close()
+                raise IOError('%s has changed since it was loaded.'
+                              %self._file_name)
+            self._buf = buf
+        return self._buf
+
+    def _read_array(self, buf, desc):
+        dtype = numpy.dtype(str(desc['dtype']))
+        out = numpy.empty(tuple(desc['shape']), dtype)
+        offset = self._start + desc['offset']
+        if desc['codec'] is None:
+            out.reshape(-1)[:] = numpy.frombuffer(buf, dtype, out.size,
+                                                  offset)
+            return out
+        view = out.reshape(-1).view(numpy.uint8)
+        z = zlib.decompressobj()
+        pos = 0
+        end = offset + desc['size']
+        for i in range(offset, end, BLOCK_SIZE):
+            block = z.decompress(buf[i:min(i + BLOCK_SIZE, end)])
+            view[pos:pos + len(block)] = numpy.frombuffer(block,
+                                                          numpy.uint8)
+            pos += len(block)
+        block = z.flush()
+        view[pos:pos + len(block)] = numpy.frombuffer(block, numpy.uint8)
+        return out
+
+
+######################################################################
+# Saving and loading visualizations.
+######################################################################
+def dump(obj, file_or_fname, compress=False):
+    """Saves the state of `obj` like `state_pickler.dump` with the
+    datasets of the `VTKDataSource` objects in a binary chunk."""
+    global _active_store
+    if isinstance(file_or_fname, basestring):
+        f = open(file_or_fname, 'wb')
+    else:
+        f = file_or_fname
+    store = DatasetStore(compress)
+    _active_store = store
+    try:
+        state_pickler.dump(obj, f)
+    finally:
+        _active_store = None
+    try:
+        store.write(f)
+    finally:
+        if f is not file_or_fname:
+            f.close()
+
+
+def load_state(file_or_fname):
+    """Returns the state saved in the file (as
+    `state_pickler.load_state`) and its `DatasetStore`, or None if the
+    file has no datasets chunk.  Use `activate` while the state is
+    set and `DatasetStore.release` once done."""
+    file_name = None
+    if isinstance(file_or_fname, basestring):
+        buf = _map_file(file_or_fname)
+        name = file_name = file_or_fname
+    else:
+        buf = file_or_fname.read()
+        name = getattr(file_or_fname, 'name', None)
+    store = DatasetStore.from_buffer(buf, file_name)
+    if store is None:
+        if isinstance(file_or_fname, basestring):
+            return state_pickler.load_state(file_or_fname), None
+        f = StringIO(buf)
+    else:
+        # Only the state is given to the unpickler.
+        f = StringIO(buf[:store.state_size()])
+    if name is not None:
+        # Used to find the files saved with relative paths.
+        f.name = name
+    return state_pickler.load_state(f), store
+
+
+def activate(store):
+    """Makes `store` the store used by the `VTKDataSource` objects
+    whose state is set.  Call with None when done."""
+    global _active_store
+    _active_store = store
@@ -7,6 +7,8 @@ highest level.
 # License: BSD Style.
 
 # Standard library imports.
+import cPickle
+
 # VTK is used to just shut off the warnings temporarily.
 try:
     import vtk
@@ -18,15 +20,17 @@ except ImportError, m:
 # Enthought library imports.
 from traits.api import (HasStrictTraits, List, Str,
         Property, Instance, Event, HasTraits, Callable, Dict,
-        Bool, on_trait_change, WeakRef)
+        Bool, Range, on_trait_change, WeakRef)
 from traitsui.api import View, Item
 from apptools.persistence import state_pickler
 from apptools.scripting.api import Recorder, recordable
 
 # Local imports.
 from mayavi.core.base import Base
+from mayavi.core import dataset_store
 from mayavi.core.scene import Scene
-from mayavi.core.common import error, process_ui_events
+from mayavi.core.common import error, process_ui_events, \
+     handle_children_state
 from mayavi.core.registry import registry
 from mayavi.core.adder_node import AdderNode, SceneAdderNode
 from mayavi.preferences.api import preference_manager
@@ -103,9 +107,19 @@ class Engine(HasStrictTraits):
     # The recorder for script recording.
     recorder = Instance(Recorder, record=False)
 
+    # The fraction of the scenes of the visualization being loaded (or
+    # of the objects of a deferred scene being restored) that are done.
+    load_progress = Range(0.0, 1.0, record=False)
+
     ########################################
     # Private traits.
 
+    # The states of the scenes and of the hidden objects whose loading
+    # was deferred by a lazy `load_visualization`, with the stores of
+    # their datasets.
+    _deferred_scenes = Dict
+    _deferred_objects = Dict
+
     _current_scene = WeakRef(Scene, allow_none=True)
     _current_object = WeakRef(HasTraits, allow_none=True)
     _current_selection = WeakRef(HasTraits, allow_none=True)
@@ -137,7 +151,8 @@ class Engine(HasStrictTraits):
         d = self.__dict__.copy()
         for x in ['_current_scene', '_current_object',
                   '__sync_trait__', '_viewer_ref',
-                  '__traits_listener__']:
+                  '__traits_listener__', 'load_progress',
+                  '_deferred_scenes', '_deferred_objects']:
             d.pop(x, None)
         return d
 
@@ -240,33 +255,55 @@ class Engine(HasStrictTraits):
         self.add_filter(mod, obj=obj)
 
     @recordable
-    def save_visualization(self, file_or_fname):
+    def save_visualization(self, file_or_fname, binary_data=True,
+                           compress=False):
         """Given a file or a file name, this saves the current
         visualization to the file.
+
+        If `binary_data` is True the datasets of the VTK data sources
+        are stored as binary arrays after the state, compressed with
+        zlib if `compress` is True.  Otherwise they are stored in the
+        state as VTK legacy ASCII files.  Anything whose loading was
+        deferred is loaded first.
         """
+        self.load_deferred()
         # Save the state of VTK's global warning display.
         o = vtk.vtkObject
         w = o.GetGlobalWarningDisplay()
         o.SetGlobalWarningDisplay(0) # Turn it off.
         try:
-            state_pickler.dump(self, file_or_fname)
+            if binary_data:
+                dataset_store.dump(self, file_or_fname, compress)
+            else:
+                state_pickler.dump(self, file_or_fname)
         finally:
             # Reset the warning state.
             o.SetGlobalWarningDisplay(w)
 
     @recordable
-    def load_visualization(self, file_or_fname):
-        """Given a file/file name this loads the visualization."""
+    def load_visualization(self, file_or_fname, lazy=False):
+        """Given a file/file name this loads the visualization.
+
+        If `lazy` is True, the scenes and their top level objects are
+        created but the state of the objects, and hence their datasets
+        and pipelines, is only loaded when their scene becomes the
+        current scene.  Hidden top level objects are only loaded when
+        they are shown.  Use `load_deferred` to load everything left.
+        """
         # Save the state of VTK's global warning display.
         o = vtk.vtkObject
         w = o.GetGlobalWarningDisplay()
         o.SetGlobalWarningDisplay(0) # Turn it off.
         try:
             # Get the state from the file.
-            state = state_pickler.load_state(file_or_fname)
+            state, store = dataset_store.load_state(file_or_fname)
             state_pickler.update_state(state)
+            # The data sources find their datasets in the store.
+            dataset_store.activate(store)
+            self.load_progress = 0.0
             # Add the new scenes.
-            for scene_state in state.scenes:
+            n_scene = len(state.scenes)
+            for i, scene_state in enumerate(state.scenes):
                 self.new_scene()
                 scene = self.scenes[-1]
                 # Disable rendering initially.
@@ -274,13 +311,35 @@ class Engine(HasStrictTraits):
                     scene.scene.disable_render = True
                 # Update the state.
                 state_pickler.update_state(scene_state)
-                scene.__set_pure_state__(scene_state)
-                # Setting the state will automatically reset the
-                # disable_render.
-                scene.render()
+                if lazy:
+                    self._defer_scene(scene, scene_state, store)
+                else:
+                    scene.__set_pure_state__(scene_state)
+                    # Setting the state will automatically reset the
+                    # disable_render.
+                    scene.render()
+                self.load_progress = (i + 1.0)/n_scene
         finally:
+            dataset_store.activate(None)
             # Reset the warning state.
             o.SetGlobalWarningDisplay(w)
+        # Deferred objects map the file again when they are loaded.
+        if store is not None:
+            store.release()
+
+        scene = self.current_scene
+        if scene in self._deferred_scenes:
+            self._restore_scene(scene)
+
+    def load_deferred(self):
+        """Loads the state of all the scenes and hidden objects whose
+        loading was deferred by a lazy `load_visualization`.  The
+        hidden objects stay hidden.
+        """
+        for scene in list(self._deferred_scenes):
+            self._restore_scene(scene)
+        for obj in list(self._deferred_objects):
+            self._restore_object(obj)
 
     @recordable
     def open(self, filename, scene=None):
@@ -326,6 +385,21 @@ class Engine(HasStrictTraits):
         if r is not None:
             r.record(msg)
 
+    def memory_report(self):
+        """Returns a `MemoryReport` with the memory used by the
+        datasets of every object on the pipeline.  Print it for a table
+        or call its `to_dict` method.
+        """
+        from mayavi.core.memory_report import MemoryReport
+        return MemoryReport(self)
+
+    def get_profiler(self):
+        """Returns the `PipelineProfiler` of this engine.  Set its
+        `enabled` trait to profile the executions of the pipeline.
+        """
+        from mayavi.core.profiler import get_profiler
+        return get_profiler(self)
+
     ######################################################################
     # Scene creation/deletion related methods.
     ######################################################################
@@ -387,6 +461,11 @@ class Engine(HasStrictTraits):
         if s is not None:
             s.stop()
             self.scenes.remove(s)
+            # Forget what was never loaded.
+            self._deferred_scenes.pop(s, None)
+            for obj in list(self._deferred_objects):
+                if obj.scene is scene:
+                    self._forget_object(obj)
             # Don't record it shutting down.  To do this we must
             # unregister it here so we don't record unnecessary calls.
             recorder = self.recorder
@@ -500,6 +579,8 @@ class Engine(HasStrictTraits):
             for s in self.scenes:
                 if s.scene == scene:
                     self._current_scene = s
+                    if s in self._deferred_scenes:
+                        self._restore_scene(s)
                     break
         except AttributeError:
             pass
@@ -521,6 +602,8 @@ class Engine(HasStrictTraits):
         old = self._current_scene
         self._current_scene = scene
         self.trait_property_changed('current_scene', old, scene)
+        if scene in self._deferred_scenes:
+            self._restore_scene(scene)
 
     def _get_current_object(self):
         if self._current_object is not None:
@@ -545,6 +628,87 @@ class Engine(HasStrictTraits):
         self._current_selection = object
         self.trait_property_changed('current_selection', old, object)
 
+    def _call_with_store(self, store, func, *args):
+        """Calls `func` with the given datasets store active and VTK's
+        warnings off."""
+        o = vtk.vtkObject
+        w = o.GetGlobalWarningDisplay()
+        o.SetGlobalWarningDisplay(0)
+        dataset_store.activate(store)
+        try:
+            return func(*args)
+        finally:
+            dataset_store.activate(None)
+            if store is not None:
+                store.release()
+            o.SetGlobalWarningDisplay(w)
+
+    def _defer_scene(self, scene, state, store):
+        """Creates the top level objects of the scene from its state
+        without setting their state, which is loaded when they start.
+        """
+        # The children are not started when added to a stopped scene.
+        scene.stop()
+        state_pickler.set_state(scene, state, ignore=['children', 'scene'])
+        handle_children_state(scene.children, state.children)
+        for child, kid in zip(scene.children, state.children):
+            # Loaded by `Base.start`.
+            child._saved_state = cPickle.dumps(kid)
+            for name in ('name', 'visible'):
+                if name in kid:
+                    setattr(child, name, kid[name])
+        self._deferred_scenes[scene] = (state, store)
+
+    def _restore_scene(self, scene):
+        """Starts a deferred scene, loading the state of its objects.
+        """
+        state, store = self._deferred_scenes.pop(scene)
+        self._call_with_store(store, self._start_scene, scene, state,
+                              store)
+
+    def _start_scene(self, scene, state, store):
+        children = scene.children
+        self.load_progress = 0.0
+        for i, child in enumerate(children):
+            if not child.visible:
+                self._defer_object(child, store)
+            # Errors propagate, like when the state is loaded eagerly.
+            child.start()
+            self.load_progress = (i + 1.0)/len(children)
+        scene.start()
+        # The camera is set last, as when the state is set.
+        state_pickler.set_state(scene, state, first=['scene'],
+                                ignore=['*'])
+        scene.render()
+        self.load_progress = 1.0
+
+    def _defer_object(self, obj, store):
+        """Keeps the saved state of a hidden object until it is shown.
+        """
+        self._deferred_objects[obj] = (obj._saved_state, store)
+        obj._saved_state = ''
+        obj.on_trait_change(self._on_deferred_shown, 'visible')
+
+    def _forget_object(self, obj):
+        obj.on_trait_change(self._on_deferred_shown, 'visible',
+                            remove=True)
+        return self._deferred_objects.pop(obj)
+
+    def _restore_object(self, obj):
+        """Loads the deferred state of a hidden object.  If the object
+        is not running the state is loaded when it starts."""
+        saved_state, store = self._forget_object(obj)
+        obj._saved_state = saved_state
+        if obj.running:
+            self._call_with_store(store, obj._load_saved_state)
+
+    def _on_deferred_shown(self, obj, name, old, new):
+        if new:
+            self._restore_object(obj)
+            # The saved state is the hidden one.
+            obj.visible = True
+            obj.render()
+
     def _on_scene_closed(self, obj, name, old, new):
         self.remove_scene(obj.scene)
 
@@ -8,73 +8,204 @@ sources derive.
 
 # Standard library imports.
 import re
-from os.path import split, join, isfile
-from glob import glob
+import json
+import math
+from os import listdir, curdir
+from os.path import split, join, isfile, getmtime
+from operator import itemgetter
+try:
+    from scandir import scandir
+except ImportError:
+    try:
+        from os import scandir
+    except ImportError:
+        scandir = None
 
 # Enthought library imports.
-from traits.api import List, Str, Instance, Int, Range
+from traits.api import List, Str, Instance, Int, Range, Float, Any, Bool
 from traitsui.api import Group, Item, FileEditor
 from apptools.persistence.state_pickler import set_state
 from apptools.persistence.file_path import FilePath
+from tvtk.api import tvtk
 
 # Local imports
 from mayavi.core.source import Source
 from mayavi.core.common import handle_children_state
+from mayavi.core.time_step_cache import TimeStepCache, ReadAhead
+from mayavi.core.time_interpolation import same_topology, \
+     same_arrays, interpolate_dataset
+
+
+# The version of the format of the time series manifests.
+MANIFEST_VERSION = 2
+
+# The coarsest resolution of the modification times of the file
+# systems (FAT has 2 seconds), in seconds.  A file added within this
+# time of the manifest being saved may not change the modification
+# time of the directory.
+MTIME_RESOLUTION = 2.0
 
 
 ######################################################################
 # Utility functions.
 ######################################################################
-def get_file_list(file_name):
+def _iter_dir(directory):
+    """Yields the names of the entries of `directory` without building
+    the whole list first when `scandir` is available.  Nothing is
+    yielded if the directory cannot be read."""
+    try:
+        if scandir is None:
+            entries = listdir(directory or curdir)
+        else:
+            entries = scandir(directory or curdir)
+    except OSError:
+        return
+    for entry in entries:
+        if scandir is None:
+            yield entry
+        else:
+            yield entry.name
+
+
+def _load_manifest(fname):
+    """Returns the manifest stored in `fname` or None."""
+    try:
+        f = open(fname, 'r')
+        try:
+            manifest = json.load(f)
+        finally:
+            f.close()
+    except (IOError, OSError, ValueError):
+        return None
+    if manifest.get('version') != MANIFEST_VERSION:
+        return None
+    return manifest
+
+
+def _save_manifest(fname, manifest):
+    """Saves the manifest, ignoring errors (the directory may be read
+    only)."""
+    try:
+        f = open(fname, 'w')
+        try:
+            json.dump(manifest, f)
+        finally:
+            f.close()
+    except (IOError, OSError):
+        pass
+
+
+def get_manifest_name(file_name):
+    """Returns the name of the manifest file used by `get_file_list`
+    for the series that `file_name` belongs to."""
+    f_dir, f_base = split(file_name)
+    head = re.sub("[0-9]+[^0-9]*$", "", f_base)
+    tail = re.sub("^.*[0-9]+", "", f_base)
+    return join(f_dir, '.%s#%s.manifest'%(head, tail))
+
+
+def get_file_list(file_name, manifest=False):
     """ Given a file name, this function treats the file as a part of
     a series of files based on the index of the file and tries to
     determine the list of files in the series.  The file name of a
     file in a time series must be of the form 'some_name[0-9]*.ext'.
     That is the integers at the end of the file determine what part of
     the time series the file belongs to.  The files are then sorted as
-    per this index."""
+    per this index.
+
+    If `manifest` is True, the (index, name) of the files are saved in
+    a manifest next to the files (see `get_manifest_name`).  When the
+    series is opened again the directory is only listed if it was
+    modified and only the names of the new files are parsed.  The
+    contents of the files are not checked, the readers do that.  A manifest saved within `MTIME_RESOLUTION` of the
+    last change of the directory is not trusted.
+    """
 
     # The matching is done only for the basename of the file.
     f_dir, f_base = split(file_name)
     # Find the head and tail of the file pattern.
     head = re.sub("[0-9]+[^0-9]*$", "", f_base)
     tail = re.sub("^.*[0-9]+", "", f_base)
-    pattern = head+"[0-9]*"+tail
-    # Glob the files for the pattern.
-    _files = glob(join(f_dir, pattern))
-
-    # A simple function to get the index from the file.
-    def _get_index(f, head=head, tail=tail):
-        base = split(f)[1]
-        result = base.replace(head, '')
-        return float(result.replace(tail, ''))
-
-    # Before sorting make sure the files in the globbed series are
-    # really part of a timeseries.  This can happen in cases like so:
-    # 5_2_1.vtk and 5_2_1s.vtk will be globbed but 5_2_1s.vtk is
-    # obviously not a valid time series file.
-    files = []
-    for x in _files:
+    # The same files the glob pattern head[0-9]*tail would match.
+    matcher = re.compile(re.escape(head) + "([0-9].*)" +
+                         re.escape(tail) + "$")
+
+    # Index of the files we already know about.
+    known = {}
+    manifest_name = dir_mtime = None
+    if manifest:
+        manifest_name = get_manifest_name(file_name)
         try:
-            _get_index(x)
+            dir_mtime = getmtime(f_dir or curdir)
+        except OSError:
+            dir_mtime = None
+        old = _load_manifest(manifest_name)
+        if old is not None:
+            try:
+                saved = getmtime(manifest_name)
+            except OSError:
+                saved = None
+            if old['dir_mtime'] == dir_mtime and saved is not None and \
+                   saved - dir_mtime > MTIME_RESOLUTION:
+                # Nothing was added or removed.
+                return [join(f_dir, name) for idx, name in old['files']]
+            known = dict((x[1], x) for x in old['files'])
+
+    # Parse the index of each file once.  Files whose index is not a
+    # number are not part of the series.  This can happen in cases
+    # like so: 5_2_1.vtk and 5_2_1s.vtk will be matched but 5_2_1s.vtk
+    # is obviously not a valid time series file.
+    entries = []
+    for name in _iter_dir(f_dir):
+        info = known.get(name)
+        if info is not None:
+            entries.append(info)
+            continue
+        match = matcher.match(name)
+        if match is None:
+            continue
+        try:
+            index = float(match.group(1))
         except ValueError:
-            pass
-        else:
-            files.append(x)
-
-    # Sort the globbed files based on the index value.
-    def file_sort(x, y):
-        x1 = _get_index(x)
-        y1 = _get_index(y)
-        if x1 > y1:
-            return 1
-        elif y1 > x1:
-            return -1
-        else:
-            return 0
+            continue
+        entries.append((index, name))
+
+    # Sort the files based on the index value.
+    entries.sort(key=itemgetter(0, 1))
+
+    if manifest and dir_mtime is not None:
+        data = {'version': MANIFEST_VERSION, 'dir_mtime': dir_mtime,
+                'files': [list(x) for x in entries]}
+        _save_manifest(manifest_name, data)
+        # Creating the manifest modifies the directory, rewriting it
+        # does not.
+        try:
+            new_mtime = getmtime(f_dir or curdir)
+        except OSError:
+            new_mtime = dir_mtime
+        if new_mtime != dir_mtime:
+            data['dir_mtime'] = new_mtime
+            _save_manifest(manifest_name, data)
+    return [join(f_dir, x[1]) for x in entries]
 
-    files.sort(file_sort)
-    return files
+
+def read_timestep(reader, file_name):
+    """Reads `file_name` with the given VTK reader and returns the list
+    of its outputs, detached from the reader, and their size in bytes.
+    This is safe to call from a worker thread as long as the reader is
+    not used elsewhere.
+    """
+    reader.SetFileName(file_name)
+    reader.Update()
+    outputs = []
+    nbytes = 0
+    for i in range(reader.GetNumberOfOutputPorts()):
+        output = reader.GetOutputDataObject(i)
+        data = output.NewInstance()
+        data.ShallowCopy(output)
+        outputs.append(data)
+        nbytes += data.GetActualMemorySize()*1024
+    return outputs, nbytes
 
 
 ######################################################################
@@ -102,10 +233,55 @@ class FileDataSource(Source):
                        enter_set=True, auto_set=False,
                        editor=FileEditor())
 
+    # Keep a manifest of the files of the time series next to them so
+    # that reopening a large series does not examine every file again.
+    use_manifest = Bool(False,
+                        desc='if a manifest of the time series is kept')
+
+    # The number of decoded time steps kept in memory so that stepping
+    # back to them does not read the file again.  Zero disables the
+    # cache.  Only used by subclasses that support it.
+    cache_size = Int(0, desc='the number of time steps kept in memory')
+
+    # The maximum memory (in MB) used by the cached time steps.  Zero
+    # means no limit other than `cache_size`.
+    cache_memory = Float(0.0,
+                         desc='the memory in MB used by cached time steps')
+
+    # The number of time steps following the current one that are read
+    # in the background.  Requires the cache to be enabled.
+    read_ahead = Int(0, desc='the number of time steps read in advance')
+
+    # Show the data linearly interpolated between the two time steps
+    # bracketing `time`.  Only used by subclasses that support the
+    # time step cache.
+    interpolate = Bool(False, desc='if the data is interpolated in time')
+
+    # The fractional time step shown when `interpolate` is set.
+    time = Float(0.0, desc='the fractional time step to show')
+
+    # Number of time steps found in (or not found in) the cache.
+    cache_hits = Int(0, desc='the number of time steps found in the cache')
+    cache_misses = Int(0,
+                       desc='the number of time steps not found in the cache')
+
     # A timestep view group that may be included by subclasses.
     time_step_group = Group(Item(name='file_path', style='readonly'),
                             Item(name='timestep',
-                                 defined_when='len(object.file_list) > 1')
+                                 defined_when='len(object.file_list) > 1'),
+                            Item(name='interpolate',
+                                 defined_when='object._cache_supported and '\
+                                              'len(object.file_list) > 1'),
+                            Item(name='time',
+                                 enabled_when='object.interpolate',
+                                 defined_when='object._cache_supported and '\
+                                              'len(object.file_list) > 1'),
+                            Item(name='cache_size',
+                                 defined_when='object._cache_supported and '\
+                                              'len(object.file_list) > 1'),
+                            Item(name='read_ahead',
+                                 defined_when='object._cache_supported and '\
+                                              'len(object.file_list) > 1'),
                             )
 
     ##################################################
@@ -119,13 +295,37 @@ class FileDataSource(Source):
     _min_timestep = Int(0)
     _max_timestep = Int(0)
 
+    # Subclasses that implement `_set_timestep_outputs` set this to
+    # True to enable the time step cache.
+    _cache_supported = False
+
+    # The cache of decoded time steps and its read-ahead helper.
+    _cache = Any
+    _read_ahead = Any
+
+    # The outputs of the two time steps bracketing `time`, keyed on
+    # their file name, and the interpolated dataset.
+    _interp_steps = Any
+    _interp_output = Any
+    # The file names of the bracketing steps and whether they can be
+    # interpolated.
+    _interp_key = Any
+    _interp_same = Bool(False)
+
+    # Set while `file_path` is changed for a cached time step.  The
+    # subclasses should not read the file when this is set.
+    _loading_cached = Bool(False)
+
     ######################################################################
     # `object` interface
     ######################################################################
     def __get_pure_state__(self):
         d = super(FileDataSource, self).__get_pure_state__()
         # These are obtained dynamically, so don't pickle them.
-        for x in ['file_list', 'timestep']:
+        for x in ['file_list', 'timestep', 'cache_hits', 'cache_misses',
+                  '_cache', '_read_ahead', '_loading_cached',
+                  '_interp_steps', '_interp_output', '_interp_key',
+                  '_interp_same']:
             d.pop(x, None)
         return d
 
@@ -145,6 +345,29 @@ class FileDataSource(Source):
         # Setup the children's state.
         set_state(self, state, first=['children'], ignore=['*'])
 
+    ######################################################################
+    # `Base` interface
+    ######################################################################
+    def start(self):
+        """Invoked when this object is added to the mayavi pipeline.
+        """
+        if self.running:
+            return
+        # The cache is dropped when stopped.
+        self._update_cache()
+        super(FileDataSource, self).start()
+
+    def stop(self):
+        """Invoked when this object is removed from the mayavi pipeline.
+        The read-ahead thread is stopped and the cached time steps are
+        freed.
+        """
+        if not self.running:
+            return
+        self._stop_read_ahead()
+        self._cache = None
+        super(FileDataSource, self).stop()
+
     ######################################################################
     # `FileDataSource` interface
     ######################################################################
@@ -174,12 +397,191 @@ class FileDataSource(Source):
     def _timestep_changed(self, value):
         file_list = self.file_list
         if len(file_list) > 0:
-            self.file_path = FilePath(file_list[value])
+            if self._cache is not None and len(self.outputs) > 0:
+                self._load_cached_timestep(file_list[value])
+            else:
+                self.file_path = FilePath(file_list[value])
+            self._request_read_ahead(value)
         else:
             self.file_path = FilePath('')
 
+    def _load_cached_timestep(self, file_name):
+        cache = self._cache
+        outputs = cache.get(file_name)
+        if outputs is None and self._read_ahead is not None and \
+               self._read_ahead.wait(file_name):
+            outputs = cache.peek(file_name)
+        if outputs is None:
+            outputs, nbytes = self._read_timestep(file_name)
+            cache.put(file_name, outputs, nbytes)
+        self.set(cache_hits=cache.hits, cache_misses=cache.misses)
+
+        self._loading_cached = True
+        try:
+            self.file_path = FilePath(file_name)
+        finally:
+            self._loading_cached = False
+        self._set_timestep_outputs([tvtk.to_tvtk(o) for o in outputs])
+
+    def _request_read_ahead(self, timestep):
+        if self._cache is None or self.read_ahead == 0 or \
+               getattr(self, 'reader', None) is None:
+            return
+        if self._read_ahead is None:
+            self._read_ahead = ReadAhead(self._cache,
+                                         self._new_timestep_loader())
+        file_list = self.file_list
+        last = min(timestep + self.read_ahead, len(file_list) - 1)
+        self._read_ahead.request(file_list[timestep + 1:last + 1])
+
+    def _new_timestep_loader(self):
+        """Returns a function reading a time step on the read-ahead
+        thread, see `_read_timestep`.  This is called on the main
+        thread and the function must not use our traits."""
+        # The reader of the worker thread is created here, on the main
+        # thread, and reused for every time step it loads.
+        reader = self._new_timestep_reader()
+        def _loader(file_name, reader=reader):
+            return read_timestep(reader, file_name)
+        return _loader
+
+    def _new_timestep_reader(self):
+        """Returns a new VTK reader configured like ours for reading a
+        time step.  This is called on the main thread."""
+        return tvtk.to_vtk(self.reader).NewInstance()
+
+    def _read_timestep(self, file_name):
+        """Reads a time step with a separate VTK reader and returns the
+        list of VTK output datasets and their size in bytes.
+        """
+        return read_timestep(self._new_timestep_reader(), file_name)
+
+    def _set_timestep_outputs(self, outputs):
+        """Sets the given datasets of a cached time step as our
+        outputs.  Subclasses that set `_cache_supported` must
+        implement this."""
+        raise NotImplementedError
+
+    def _update_cache(self):
+        enabled = self._cache_supported and \
+                  (self.cache_size > 0 or self.cache_memory > 0)
+        max_bytes = int(self.cache_memory*1024*1024)
+        if not enabled:
+            self._stop_read_ahead()
+            self._cache = None
+            return
+        if self._cache is None:
+            self._cache = TimeStepCache(self.cache_size, max_bytes)
+        else:
+            self._cache.set_limits(self.cache_size, max_bytes)
+        if self.read_ahead == 0:
+            self._stop_read_ahead()
+
+    def _stop_read_ahead(self):
+        if self._read_ahead is not None:
+            self._read_ahead.shutdown()
+            self._read_ahead = None
+
+    def _cache_size_changed(self):
+        self._update_cache()
+
+    def _cache_memory_changed(self):
+        self._update_cache()
+
+    def _read_ahead_changed(self):
+        self._update_cache()
+
+    def _get_step_outputs(self, index):
+        """Returns the VTK outputs of a time step, keeping it resident
+        while it brackets `time`."""
+        file_name = self.file_list[index]
+        steps = self._interp_steps
+        outputs = steps.get(file_name)
+        if outputs is not None:
+            return outputs
+        cache = self._cache
+        if cache is not None:
+            outputs = cache.get(file_name)
+            if outputs is None:
+                outputs, nbytes = self._read_timestep(file_name)
+                cache.put(file_name, outputs, nbytes)
+            self.set(cache_hits=cache.hits, cache_misses=cache.misses)
+        else:
+            outputs, nbytes = self._read_timestep(file_name)
+        steps[file_name] = outputs
+        return outputs
+
+    def _show_interpolated(self, time):
+        n = len(self.file_list)
+        if not self._cache_supported or n == 0 or len(self.outputs) == 0:
+            return
+        time = min(max(time, 0.0), n - 1.0)
+        i0 = int(math.floor(time))
+        i1 = min(i0 + 1, n - 1)
+        f = time - i0
+        if self._interp_steps is None:
+            self._interp_steps = {}
+        d0 = self._get_step_outputs(i0)[0]
+        d1 = self._get_step_outputs(i1)[0]
+        # Only keep the bracketing steps.
+        keep = (self.file_list[i0], self.file_list[i1])
+        for key in self._interp_steps.keys():
+            if key not in keep:
+                del self._interp_steps[key]
+
+        new_bracket = self._interp_key != keep
+        if new_bracket:
+            # The structures are only compared once per bracket.
+            self._interp_key = keep
+            self._interp_same = same_topology(d0, d1)
+        if not self._interp_same:
+            # Show the nearest step.
+            nearest = i0 if f < 0.5 else i1
+            self._set_timestep_outputs(
+                [tvtk.to_tvtk(o) for o in self._get_step_outputs(nearest)])
+            return
+
+        out = self._interp_output
+        if out is None or (new_bracket and not
+                           (same_topology(out, d0) and same_arrays(out, d0))):
+            # Allocate the output buffers, they are reused for the
+            # following brackets as long as the structure is the same.
+            out = d0.NewInstance()
+            out.DeepCopy(d0)
+            self._interp_output = out
+        elif new_bracket and not out.IsA('vtkPointSet'):
+            # The origin and spacing or coordinates are not interpolated.
+            out.CopyStructure(d0)
+        interpolate_dataset(out, d0, d1, f)
+        output = tvtk.to_tvtk(out)
+        if len(self.outputs) != 1 or self.outputs[0] is not output:
+            self._set_timestep_outputs([output])
+        else:
+            self.data_changed = True
+            self.render()
+
+    def _time_changed(self, value):
+        if self.interpolate:
+            self._show_interpolated(value)
+
+    def _interpolate_changed(self, value):
+        if value:
+            self._show_interpolated(self.time)
+        else:
+            self._interp_steps = None
+            self._interp_output = None
+            self._interp_key = None
+            self._timestep_changed(self.timestep)
+
     def _base_file_name_changed(self,value):
-        self.file_list = get_file_list(value)
+        # A new series may need a different reader.
+        self._stop_read_ahead()
+        self._interp_steps = None
+        self._interp_output = None
+        self._interp_key = None
+        if self._cache is not None:
+            self._cache.clear()
+        self.file_list = get_file_list(value, self.use_manifest)
         if len(self.file_list) == 0:
             self.file_list = [value]
         try:
@@ -0,0 +1,247 @@
+"""Reports the memory held by the datasets of the objects on the
+Mayavi pipeline.
+
+The report walks the tree of the engine (scenes, sources, filters,
+module managers and modules) and attributes to each node the memory
+of the datasets it outputs (or, for modules, the datasets rendered by
+its actors).  VTK arrays shared between datasets, for instance when a
+filter passes its input attributes through, are only counted for the
+first node that holds them.
+
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from tvtk import array_handler
+from tvtk.common import format_table
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _get_vtk(obj):
+    """Returns the VTK object wrapped by `obj` or None if `obj` is not a
+    VTK data object."""
+    if obj is None:
+        return None
+    try:
+        vtk_obj = tvtk.to_vtk(obj)
+    except Exception:
+        return None
+    if vtk_obj is None or not hasattr(vtk_obj, 'IsA') or \
+           not vtk_obj.IsA('vtkDataObject'):
+        return None
+    return vtk_obj
+
+
+def _dataset_arrays(ds):
+    """Returns the VTK arrays (data arrays and cell arrays) held by the
+    VTK data object `ds`, including those of the blocks of composite
+    datasets."""
+    arrays = []
+    def add(arr):
+        if arr is not None:
+            arrays.append(arr)
+
+    if ds.IsA('vtkCompositeDataSet'):
+        it = ds.NewIterator()
+        it.InitTraversal()
+        while not it.IsDoneWithTraversal():
+            arrays.extend(_dataset_arrays(it.GetCurrentDataObject()))
+            it.GoToNextItem()
+    elif ds.IsA('vtkDataSet'):
+        if hasattr(ds, 'GetPoints'):
+            points = ds.GetPoints()
+            if points is not None:
+                add(points.GetData())
+        for name in ('GetXCoordinates', 'GetYCoordinates',
+                     'GetZCoordinates', 'GetVerts', 'GetLines',
+                     'GetPolys', 'GetStrips', 'GetCells',
+                     'GetCellTypesArray', 'GetCellLocationsArray'):
+            method = getattr(ds, name, None)
+            if method is not None:
+                add(method())
+    attrs = [ds.GetFieldData()]
+    if ds.IsA('vtkDataSet'):
+        attrs = [ds.GetPointData(), ds.GetCellData()] + attrs
+    for attr in attrs:
+        if attr is None:
+            continue
+        for i in range(attr.GetNumberOfArrays()):
+            add(attr.GetAbstractArray(i))
+    return arrays
+
+
+def _array_key(arr):
+    return arr.__this__
+
+
+def _pinned_bytes(arr):
+    """Returns the number of bytes of the numpy array backing the VTK
+    array `arr` if it was passed to VTK without a copy."""
+    cache = array_handler._array_cache
+    if arr in cache:
+        return cache.get(arr).nbytes
+    return 0
+
+
+######################################################################
+# `MemoryNode` class.
+######################################################################
+class MemoryNode(object):
+    """The memory used by one node on the pipeline.  All sizes are in
+    bytes."""
+
+    def __init__(self, obj, name, path):
+        # The pipeline object.
+        self.object = obj
+        # The name of the object.
+        self.name = name
+        # The path of the object with respect to the engine.
+        self.path = path
+        # The memory of the datasets (not counting shared arrays).
+        self.bytes = 0
+        # The part of `bytes` held by numpy arrays shared with VTK.
+        self.pinned_bytes = 0
+        # The memory of arrays already counted for another node.
+        self.shared_bytes = 0
+        # The number of datasets.
+        self.n_datasets = 0
+        # The child nodes.
+        self.children = []
+
+    @property
+    def total_bytes(self):
+        """The memory of this node and all its children."""
+        return self.bytes + sum(c.total_bytes for c in self.children)
+
+    def to_dict(self):
+        return dict(name=self.name, path=self.path,
+                    type=self.object.__class__.__name__,
+                    bytes=self.bytes, pinned_bytes=self.pinned_bytes,
+                    shared_bytes=self.shared_bytes,
+                    n_datasets=self.n_datasets,
+                    total_bytes=self.total_bytes,
+                    children=[c.to_dict() for c in self.children])
+
+
+######################################################################
+# `MemoryReport` class.
+######################################################################
+class MemoryReport(object):
+    """Walks the pipeline below an engine (or any pipeline object) and
+    collects the memory used by every node.
+
+    Use `to_dict` for a machine readable report and `str(report)` (or
+    `table`) for a human readable one.
+    """
+
+    def __init__(self, obj, path='engine'):
+        self._seen_arrays = set()
+        self._seen_datasets = set()
+        self.root = self._walk(obj, path)
+
+    ######################################################################
+    # `MemoryReport` interface.
+    ######################################################################
+    @property
+    def total_bytes(self):
+        return self.root.total_bytes
+
+    def nodes(self):
+        """Returns a list of (depth, node) in tree order."""
+        result = []
+        def _collect(node, depth):
+            result.append((depth, node))
+            for child in node.children:
+                _collect(child, depth + 1)
+        _collect(self.root, 0)
+        return result
+
+    def to_dict(self):
+        """Returns the report as a nested dictionary."""
+        return self.root.to_dict()
+
+    def table(self, unit='MB'):
+        """Returns the report as a text table.  `unit` is one of 'B',
+        'KB', 'MB' or 'GB'."""
+        scale = {'B': 1.0, 'KB': 1024.0, 'MB': 1024.0**2,
+                 'GB': 1024.0**3}[unit]
+        rows = []
+        for depth, node in self.nodes():
+            rows.append(('  '*depth + node.name,
+                         '%.2f'%(node.bytes/scale),
+                         '%.2f'%(node.pinned_bytes/scale),
+                         '%.2f'%(node.shared_bytes/scale),
+                         '%.2f'%(node.total_bytes/scale)))
+        header = ('Object', 'Own (%s)'%unit, 'Pinned', 'Shared', 'Total')
+        return format_table(header, rows)
+
+    def __str__(self):
+        return self.table()
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def _walk(self, obj, path):
+        name = getattr(obj, 'name', '') or obj.__class__.__name__
+        node = MemoryNode(obj, name, path)
+        for ds in self._get_datasets(obj):
+            self._add_dataset(node, ds)
+
+        if hasattr(obj, 'scenes'):
+            child_trait = 'scenes'
+        elif hasattr(obj, 'children'):
+            child_trait = 'children'
+        else:
+            child_trait = ''
+        if child_trait:
+            for i, child in enumerate(getattr(obj, child_trait)):
+                child_path = '%s.%s[%d]'%(path, child_trait, i)
+                node.children.append(self._walk(child, child_path))
+        return node
+
+    def _get_datasets(self, obj):
+        """Returns the VTK datasets held by the pipeline object."""
+        candidates = list(getattr(obj, 'outputs', []))
+        # Modules have no outputs, use their components and the inputs
+        # of the mappers of their actors.  Datasets already counted
+        # upstream are skipped by `_add_dataset`.
+        for component in getattr(obj, 'components', []):
+            candidates.extend(getattr(component, 'outputs', []))
+        for actor in getattr(obj, 'actors', []):
+            mapper = getattr(actor, 'mapper', None)
+            if mapper is not None:
+                candidates.append(getattr(mapper, 'input', None))
+        return [d for d in (_get_vtk(c) for c in candidates)
+                if d is not None]
+
+    def _add_dataset(self, node, ds):
+        key = _array_key(ds)
+        if key in self._seen_datasets:
+            return
+        self._seen_datasets.add(key)
+        node.n_datasets += 1
+        # GetActualMemorySize is in kilobytes.
+        total = ds.GetActualMemorySize()*1024
+        arrays_size = 0
+        shared = 0
+        for arr in _dataset_arrays(ds):
+            size = arr.GetActualMemorySize()*1024
+            arrays_size += size
+            akey = _array_key(arr)
+            if akey in self._seen_arrays:
+                shared += size
+                continue
+            self._seen_arrays.add(akey)
+            node.pinned_bytes += min(_pinned_bytes(arr), size)
+        node.shared_bytes += shared
+        node.bytes += max(total, arrays_size) - shared
+
+
+def memory_report(obj, path='engine'):
+    """Returns a `MemoryReport` for the given engine or pipeline
+    object."""
+    return MemoryReport(obj, path)
@@ -0,0 +1,353 @@
+"""An opt-in execution profiler for the Mayavi pipeline.
+
+The profiler observes the `StartEvent` and `EndEvent` of every VTK
+algorithm owned by the objects on the pipeline (sources, filters,
+modules and their components) and attributes the wall time, the
+number of executions and the size of the output to the Mayavi object
+that owns the algorithm.  The observers only read a clock and update
+a few counters so the profiler may be left enabled.
+
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import weakref
+
+# Enthought library imports.
+from traits.api import HasTraits, Bool, Property
+from tvtk.api import tvtk
+from tvtk.common import clock, format_table
+
+# The profilers that are currently alive, keyed on their engine.
+_profilers = weakref.WeakKeyDictionary()
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _get_algorithms(obj):
+    """Returns the VTK algorithms held by the traits of `obj` (and of
+    the items of its list traits)."""
+    values = []
+    for value in obj.__dict__.values():
+        if isinstance(value, (list, tuple)):
+            values.extend(value)
+        else:
+            values.append(value)
+    result = []
+    for value in values:
+        if isinstance(value, tvtk.Object):
+            vtk_obj = tvtk.to_vtk(value)
+            if vtk_obj.IsA('vtkAlgorithm'):
+                result.append(vtk_obj)
+    return result
+
+
+def _node_algorithms(node):
+    """Returns the VTK algorithms owned by a pipeline object."""
+    algorithms = _get_algorithms(node)
+    for component in getattr(node, 'components', []):
+        algorithms.extend(_get_algorithms(component))
+    for actor in getattr(node, 'actors', []):
+        mapper = getattr(actor, 'mapper', None)
+        if isinstance(mapper, tvtk.Object):
+            algorithms.append(tvtk.to_vtk(mapper))
+    return algorithms
+
+
+def get_profile(node):
+    """Returns the `NodeProfile` of a pipeline object from any enabled
+    profiler or None if the object is not being profiled."""
+    for profiler in _profilers.values():
+        stats = profiler.get(node)
+        if stats is not None:
+            return stats
+    return None
+
+
+def get_profiler(engine):
+    """Returns the `PipelineProfiler` of an engine, creating it if
+    needed.  The profiler is not enabled."""
+    profiler = _profilers.get(engine)
+    if profiler is None:
+        profiler = PipelineProfiler(engine=engine)
+        _profilers[engine] = profiler
+    return profiler
+
+
+######################################################################
+# `NodeProfile` class.
+######################################################################
+class NodeProfile(object):
+    """The execution statistics of one pipeline object.  Times are in
+    seconds."""
+
+    __slots__ = ('n_calls', 'total_time', 'max_time', 'last_time',
+                 'n_points', 'n_cells', '_start')
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.n_calls = 0
+        self.total_time = 0.0
+        self.max_time = 0.0
+        self.last_time = 0.0
+        # Size of the output of the last algorithm that executed.
+        self.n_points = 0
+        self.n_cells = 0
+        self._start = {}
+
+    def start(self, key):
+        self._start[key] = clock()
+
+    def end(self, key, vtk_obj):
+        start = self._start.pop(key, None)
+        if start is None:
+            return
+        dt = clock() - start
+        self.n_calls += 1
+        self.total_time += dt
+        self.last_time = dt
+        if dt > self.max_time:
+            self.max_time = dt
+        if vtk_obj.GetNumberOfOutputPorts() > 0:
+            output = vtk_obj.GetOutputDataObject(0)
+            if output is not None and output.IsA('vtkDataSet'):
+                self.n_points = output.GetNumberOfPoints()
+                self.n_cells = output.GetNumberOfCells()
+
+    @property
+    def mean_time(self):
+        if self.n_calls == 0:
+            return 0.0
+        return self.total_time/self.n_calls
+
+    def to_dict(self):
+        return dict(n_calls=self.n_calls, total_time=self.total_time,
+                    mean_time=self.mean_time, max_time=self.max_time,
+                    last_time=self.last_time, n_points=self.n_points,
+                    n_cells=self.n_cells)
+
+    def __str__(self):
+        return '%d calls, %.2f ms total, %.2f ms max, %d points, %d cells'%(
+            self.n_calls, self.total_time*1e3, self.max_time*1e3,
+            self.n_points, self.n_cells)
+
+
+######################################################################
+# `PipelineProfiler` class.
+######################################################################
+class PipelineProfiler(HasTraits):
+    """Profiles the executions of the VTK algorithms of the objects on
+    the pipeline of an engine.
+
+    Set `enabled` to start profiling.  Objects added to the pipeline
+    while the profiler is enabled are profiled too and objects removed
+    from it are forgotten.  Print the profiler for a table or use
+    `to_dict`.
+    """
+
+    # The engine whose pipeline is profiled.  It is held through a weak
+    # reference so the profiler does not keep it alive.
+    engine = Property
+
+    # Is the profiler observing the pipeline.
+    enabled = Bool(False, desc='if the pipeline executions are profiled')
+
+    ######################################################################
+    # `PipelineProfiler` interface.
+    ######################################################################
+    def get(self, node):
+        """Returns the `NodeProfile` for a pipeline object or None."""
+        return self._stats.get(node)
+
+    def reset(self):
+        """Resets the statistics of all the profiled objects."""
+        for stats in self._stats.values():
+            stats.reset()
+
+    def nodes(self):
+        """Returns a list of (depth, node, stats) in tree order.  stats
+        is None for objects that own no algorithm."""
+        result = []
+        def _collect(node, depth):
+            result.append((depth, node, self._stats.get(node)))
+            for child in self._get_children(node):
+                _collect(child, depth + 1)
+        if self.engine is not None:
+            _collect(self.engine, 0)
+        return result
+
+    def to_dict(self):
+        """Returns a dictionary mapping the path of each profiled object
+        to its statistics (see `NodeProfile.to_dict`)."""
+        from mayavi.core.common import get_object_path
+        result = {}
+        for depth, node, stats in self.nodes():
+            if stats is not None:
+                path = get_object_path(node, self.engine)
+                d = stats.to_dict()
+                d['name'] = node.name
+                result[path] = d
+        return result
+
+    def table(self):
+        """Returns the statistics as a text table."""
+        rows = []
+        for depth, node, stats in self.nodes():
+            name = '  '*depth + (getattr(node, 'name', '') or
+                                 node.__class__.__name__)
+            if stats is None:
+                rows.append((name, '', '', '', '', ''))
+            else:
+                rows.append((name, str(stats.n_calls),
+                             '%.2f'%(stats.total_time*1e3),
+                             '%.2f'%(stats.max_time*1e3),
+                             str(stats.n_points), str(stats.n_cells)))
+        header = ('Object', 'Calls', 'Total (ms)', 'Max (ms)',
+                  'Points', 'Cells')
+        return format_table(header, rows)
+
+    def __str__(self):
+        return self.table()
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def __init__(self, **traits):
+        # Maps the pipeline objects to their NodeProfile.
+        self._stats = weakref.WeakKeyDictionary()
+        # Maps the address of an observed algorithm to (vtk_obj,
+        # observer ids).
+        self._observed = {}
+        # Maps the id of the objects on the pipeline whose trait changes
+        # we listen to, to a weak reference to the object and the keys
+        # of its algorithms in `_observed`.
+        self._nodes = {}
+        self._engine_ref = None
+        super(PipelineProfiler, self).__init__(**traits)
+
+    def _get_engine(self):
+        if self._engine_ref is None:
+            return None
+        return self._engine_ref()
+
+    def _set_engine(self, engine):
+        if self.enabled:
+            self._detach()
+        self._engine_ref = None
+        if engine is not None:
+            self._engine_ref = weakref.ref(engine)
+        if self.enabled:
+            self._update()
+
+    def _enabled_changed(self, value):
+        if value:
+            self._update()
+        else:
+            self._detach()
+
+    def _get_child_trait(self, node):
+        if hasattr(node, 'scenes'):
+            return 'scenes'
+        elif hasattr(node, 'children'):
+            return 'children'
+        return ''
+
+    def _get_children(self, node):
+        child_trait = self._get_child_trait(node)
+        if len(child_trait) == 0:
+            return []
+        return getattr(node, child_trait)
+
+    def _listen(self, node, remove=False):
+        child_trait = self._get_child_trait(node)
+        if len(child_trait) > 0:
+            node.on_trait_change(self._on_children_changed,
+                                 child_trait + '[]', remove=remove)
+        if hasattr(node, 'pipeline_changed'):
+            node.on_trait_change(self._on_pipeline_changed,
+                                 'pipeline_changed', remove=remove)
+
+    def _update(self):
+        """Observes the objects on the pipeline and forgets the objects
+        that left it."""
+        nodes = []
+        def _collect(node):
+            nodes.append(node)
+            for child in self._get_children(node):
+                _collect(child)
+        engine = self.engine
+        if engine is not None:
+            _collect(engine)
+
+        current = set(id(node) for node in nodes)
+        for key, (ref, keys) in self._nodes.items():
+            if key not in current or ref() is None:
+                self._forget(key)
+        for node in nodes:
+            if id(node) not in self._nodes:
+                self._nodes[id(node)] = (weakref.ref(node), set())
+                self._listen(node)
+            self._attach(node)
+
+    def _attach(self, node):
+        """Observes the algorithms of `node`, forgetting the ones it
+        does not hold anymore."""
+        keys = self._nodes[id(node)][1]
+        algorithms = _node_algorithms(node)
+        current = set(vtk_obj.__this__ for vtk_obj in algorithms)
+        self._unobserve(keys - current)
+        keys &= current
+        if len(algorithms) > 0:
+            stats = self._stats.get(node)
+            if stats is None:
+                stats = self._stats[node] = NodeProfile()
+            for vtk_obj in algorithms:
+                if self._observe(vtk_obj, stats):
+                    keys.add(vtk_obj.__this__)
+
+    def _observe(self, vtk_obj, stats):
+        """Observes `vtk_obj` unless it is already observed.  Returns
+        True if it was not."""
+        key = vtk_obj.__this__
+        if key in self._observed:
+            return False
+        def _start(caller, event, stats=stats, key=key):
+            stats.start(key)
+        def _end(caller, event, stats=stats, key=key):
+            stats.end(key, caller)
+        ids = (vtk_obj.AddObserver('StartEvent', _start),
+               vtk_obj.AddObserver('EndEvent', _end))
+        self._observed[key] = (vtk_obj, ids)
+        return True
+
+    def _unobserve(self, keys):
+        for key in keys:
+            vtk_obj, ids = self._observed.pop(key)
+            for id in ids:
+                vtk_obj.RemoveObserver(id)
+
+    def _forget(self, key):
+        """Stops observing the object of id `key`."""
+        ref, keys = self._nodes.pop(key)
+        node = ref()
+        if node is not None:
+            self._listen(node, remove=True)
+        self._unobserve(keys)
+
+    def _detach(self):
+        for key in self._nodes.keys():
+            self._forget(key)
+        self._unobserve(self._observed.keys())
+
+    def _on_children_changed(self, obj, name, old, new):
+        if self.enabled:
+            self._update()
+
+    def _on_pipeline_changed(self, obj, name, old, new):
+        # The object may have replaced its algorithms.
+        if self.enabled and id(obj) in self._nodes:
+            self._attach(obj)
@@ -0,0 +1,146 @@
+"""Linear interpolation of VTK datasets between two time steps.
+
+The interpolated values are written in place into the arrays of an
+output dataset so that the same buffers are reused for every
+fractional time between the two steps.
+
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import numpy
+
+# Enthought library imports.
+from tvtk.array_handler import vtk2array, array2vtk
+
+
+######################################################################
+# Utility functions.
+######################################################################
+# The structured datasets, whose structure is given by their extent.
+_STRUCTURED = ('vtkImageData', 'vtkRectilinearGrid', 'vtkStructuredGrid')
+
+
+def _same_cells(c0, c1):
+    """True if the two vtkCellArrays have the same connectivity."""
+    if c0.GetNumberOfCells() != c1.GetNumberOfCells():
+        return False
+    if c0.GetNumberOfCells() == 0:
+        return True
+    return numpy.array_equal(vtk2array(c0.GetData()),
+                             vtk2array(c1.GetData()))
+
+
+def same_topology(d0, d1):
+    """Returns True if the two VTK datasets can be interpolated, i.e.
+    they are of the same type and have the same structure: the same
+    extent for structured data and the same cells (connectivity and
+    cell types) otherwise.  The point coordinates are not compared."""
+    if d0.GetClassName() != d1.GetClassName():
+        return False
+    if not d0.IsA('vtkDataSet'):
+        return False
+    if d0.GetNumberOfPoints() != d1.GetNumberOfPoints() or \
+           d0.GetNumberOfCells() != d1.GetNumberOfCells():
+        return False
+    for cls in _STRUCTURED:
+        if d0.IsA(cls):
+            return tuple(d0.GetExtent()) == tuple(d1.GetExtent())
+    if d0.IsA('vtkPolyData'):
+        for name in ('Verts', 'Lines', 'Polys', 'Strips'):
+            if not _same_cells(getattr(d0, 'Get' + name)(),
+                               getattr(d1, 'Get' + name)()):
+                return False
+        return True
+    if d0.IsA('vtkUnstructuredGrid') and d0.GetNumberOfCells() > 0:
+        return _same_cells(d0.GetCells(), d1.GetCells()) and \
+               numpy.array_equal(vtk2array(d0.GetCellTypesArray()),
+                                 vtk2array(d1.GetCellTypesArray()))
+    return True
+
+
+def _array_layout(attr):
+    layout = []
+    for i in range(attr.GetNumberOfArrays()):
+        arr = attr.GetAbstractArray(i)
+        layout.append((arr.GetName(), arr.GetDataType(),
+                       arr.GetNumberOfComponents()))
+    return sorted(layout)
+
+
+def same_arrays(d0, d1):
+    """Returns True if the point data and the cell data of the two VTK
+    datasets have arrays of the same names, types and number of
+    components."""
+    return _array_layout(d0.GetPointData()) == \
+           _array_layout(d1.GetPointData()) and \
+           _array_layout(d0.GetCellData()) == _array_layout(d1.GetCellData())
+
+
+def lerp_array(out, a0, a1, f):
+    """Sets `out` to `a0 + f*(a1 - a0)` without allocating temporary
+    arrays.  All arrays are numpy arrays of the same shape; `out` may
+    not be `a0` but may be `a1`."""
+    numpy.subtract(a1, a0, out)
+    out *= f
+    out += a0
+
+
+def _lerp_vtk_array(out, a0, a1, f):
+    """Interpolates the VTK data arrays `a0` and `a1` into `out`.
+    Arrays that are not floating point are copied from the nearest
+    time step."""
+    o = vtk2array(out)
+    x0 = vtk2array(a0)
+    x1 = vtk2array(a1)
+    if o.shape != x0.shape or x0.shape != x1.shape:
+        return False
+    # `o` is normally a view of the VTK array.
+    view = o.flags.writeable
+    if not view:
+        o = o.copy()
+    if o.dtype.kind != 'f':
+        o[...] = x0 if f < 0.5 else x1
+    else:
+        lerp_array(o, x0, x1, f)
+    if view:
+        out.Modified()
+    else:
+        array2vtk(o, out)
+    return True
+
+
+def _lerp_attributes(out, attr0, attr1, f):
+    for i in range(out.GetNumberOfArrays()):
+        arr = out.GetArray(i)
+        if arr is None:
+            continue
+        name = arr.GetName()
+        if name is None:
+            continue
+        a0 = attr0.GetArray(name)
+        a1 = attr1.GetArray(name)
+        if a0 is not None and a1 is not None:
+            _lerp_vtk_array(arr, a0, a1, f)
+
+
+def interpolate_dataset(out, d0, d1, f):
+    """Writes the interpolation at fraction `f` (0 gives `d0`, 1 gives
+    `d1`) of the point data, cell data and point coordinates of the
+    VTK datasets `d0` and `d1` into `out`.  `out` must be a deep copy
+    of `d0` (or of a dataset satisfying `same_topology` and
+    `same_arrays` with it) and `d0`, `d1` must satisfy
+    `same_topology`.
+    """
+    _lerp_attributes(out.GetPointData(), d0.GetPointData(),
+                     d1.GetPointData(), f)
+    _lerp_attributes(out.GetCellData(), d0.GetCellData(),
+                     d1.GetCellData(), f)
+    if out.IsA('vtkPointSet'):
+        p = out.GetPoints()
+        p0 = d0.GetPoints()
+        p1 = d1.GetPoints()
+        if p is not None and p0 is not None and p1 is not None:
+            _lerp_vtk_array(p.GetData(), p0.GetData(), p1.GetData(), f)
+    out.Modified()
@@ -0,0 +1,172 @@
+"""A bounded LRU cache of decoded time steps and a background
+read-ahead helper used by `FileDataSource`.
+
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import threading
+import Queue
+from collections import OrderedDict
+
+
+######################################################################
+# `TimeStepCache` class.
+######################################################################
+class TimeStepCache(object):
+    """A thread safe least recently used cache bounded by the number of
+    items and/or their total size in bytes.  A limit of zero means no
+    limit on that quantity.  The most recently inserted item is never
+    evicted.
+    """
+
+    def __init__(self, max_items=0, max_bytes=0):
+        self.max_items = max_items
+        self.max_bytes = max_bytes
+        self.hits = 0
+        self.misses = 0
+        self._data = OrderedDict()
+        self._nbytes = 0
+        self._lock = threading.Lock()
+
+    def __len__(self):
+        return len(self._data)
+
+    def __contains__(self, key):
+        return key in self._data
+
+    @property
+    def nbytes(self):
+        """The total size of the cached items."""
+        return self._nbytes
+
+    def get(self, key):
+        """Returns the cached value for `key` (marking it as recently
+        used) or None.  Updates the hit/miss counters."""
+        with self._lock:
+            item = self._data.pop(key, None)
+            if item is None:
+                self.misses += 1
+                return None
+            self._data[key] = item
+            self.hits += 1
+            return item[0]
+
+    def peek(self, key):
+        """Returns the cached value for `key` or None without changing
+        the counters or the order."""
+        item = self._data.get(key)
+        if item is None:
+            return None
+        return item[0]
+
+    def put(self, key, value, nbytes=0):
+        """Adds a value of size `nbytes` and evicts the least recently
+        used items if the cache is full."""
+        with self._lock:
+            old = self._data.pop(key, None)
+            if old is not None:
+                self._nbytes -= old[1]
+            self._data[key] = (value, nbytes)
+            self._nbytes += nbytes
+            self._evict()
+
+    def set_limits(self, max_items=0, max_bytes=0):
+        with self._lock:
+            self.max_items = max_items
+            self.max_bytes = max_bytes
+            self._evict()
+
+    def clear(self):
+        with self._lock:
+            self._data.clear()
+            self._nbytes = 0
+
+    def reset_counters(self):
+        self.hits = self.misses = 0
+
+    def _evict(self):
+        data = self._data
+        while len(data) > 1 and \
+              ((self.max_items > 0 and len(data) > self.max_items) or
+               (self.max_bytes > 0 and self._nbytes > self.max_bytes)):
+            key, (value, nbytes) = data.popitem(last=False)
+            self._nbytes -= nbytes
+
+
+######################################################################
+# `ReadAhead` class.
+######################################################################
+class ReadAhead(object):
+    """Loads items into a `TimeStepCache` on worker threads.
+
+    `loader(key)` is called on a worker thread and must return a
+    `(value, nbytes)` tuple.  It must not touch objects that are used
+    by the main thread.
+    """
+
+    def __init__(self, cache, loader, n_threads=1):
+        self.cache = cache
+        self.loader = loader
+        self._queue = Queue.Queue()
+        # The keys of the last request, stale queued keys are skipped.
+        self._wanted = set()
+        # Maps the keys being loaded to an event set once done.
+        self._pending = {}
+        self._lock = threading.Lock()
+        self._threads = []
+        for i in range(n_threads):
+            t = threading.Thread(target=self._work)
+            t.setDaemon(True)
+            t.start()
+            self._threads.append(t)
+
+    def request(self, keys):
+        """Schedules the loading of the given keys in order.  Keys from
+        previous requests that have not been started are dropped."""
+        with self._lock:
+            self._wanted = set(keys)
+            for key in keys:
+                if key in self.cache or key in self._pending:
+                    continue
+                self._pending[key] = threading.Event()
+                self._queue.put(key)
+
+    def wait(self, key, timeout=None):
+        """Waits for `key` if it is being loaded.  Returns True if the
+        key was pending."""
+        event = self._pending.get(key)
+        if event is None:
+            return False
+        event.wait(timeout)
+        return True
+
+    def shutdown(self):
+        """Stops the worker threads once the current loads are done."""
+        with self._lock:
+            self._wanted = set()
+        for t in self._threads:
+            self._queue.put(None)
+        self._threads = []
+
+    def _work(self):
+        while True:
+            key = self._queue.get()
+            if key is None:
+                return
+            with self._lock:
+                event = self._pending.get(key)
+                stale = key not in self._wanted
+            try:
+                if not stale and key not in self.cache:
+                    value, nbytes = self.loader(key)
+                    self.cache.put(key, value, nbytes)
+            except Exception:
+                # The main thread will read the file again and report
+                # the error.
+                pass
+            with self._lock:
+                self._pending.pop(key, None)
+            if event is not None:
+                event.set()
@@ -147,6 +147,11 @@ class MayaviMlabPreferencesPage(PreferencesPage):
     offscreen = Bool(desc='if mlab should use offscreen rendering'
                           ' (no window will show up in this case)')
 
+    # The precision used by mlab sources to store the data.
+    precision = Enum('double', 'single',
+                     desc='the precision used to store mlab data'
+                          ' (single halves the memory used)')
+
 
     ######################################################################
     # Traits UI view.
@@ -156,6 +161,7 @@ class MayaviMlabPreferencesPage(PreferencesPage):
                              Item('background_color'),
                              Item('foreground_color'),
                              Item('offscreen'),
+                             Item('precision'),
                              ),
                        resizable=True
                       )
@@ -107,6 +107,11 @@ class MlabPreferencesHelper(PreferencesHelper):
     offscreen = Bool(desc='if mlab should use offscreen rendering'
                           ' (no window will show up in this case)')
 
+    # The precision used by mlab sources to store the data.
+    precision = Enum('double', 'single',
+                     desc='the precision used to store mlab data'
+                          ' (single halves the memory used)')
+
     ######################################################################
     # Traits UI view.
 
@@ -114,7 +119,8 @@ class MlabPreferencesHelper(PreferencesHelper):
                              Item('backend'),
                              Item('background_color'),
                              Item('foreground_color'),
-                             Item('offscreen')
+                             Item('offscreen'),
+                             Item('precision'),
                              ),
                        resizable=True
                       )
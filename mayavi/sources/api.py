@@ -14,6 +14,7 @@ from image_reader import ImageReader
 from parametric_surface import ParametricSurface
 from plot3d_reader import PLOT3DReader
 from point_load import PointLoad
+from shared_array_source import SharedArraySource
 from poly_data_reader import PolyDataReader
 from three_ds_importer import ThreeDSImporter
 from vrml_importer import VRMLImporter
@@ -52,6 +52,14 @@ def _check_vector_array(obj, name, value):
 
 _check_vector_array.info = 'a 3D or 4D numpy array with shape[-1] = 3'
 
+def _copy_in_place(vtk_array, data):
+    """Copies `data`, ordered as VTK wants it, into `vtk_array` unless
+    VTK already uses its memory."""
+    arr = vtk_array.to_array()
+    if not numpy.may_share_memory(arr, data):
+        arr.reshape(data.shape)[...] = data
+    vtk_array.modified()
+
 
 ######################################################################
 # 'ArraySource' class.
@@ -150,10 +158,19 @@ class ArraySource(Source):
         d = self.image_data
         d.modified()
         pd = d.point_data
+        # VTK holds a copy of the arrays if they had to be transposed.
         if self.scalar_data is not None:
-            pd.scalars.modified()
+            data = self.scalar_data
+            if self.transpose_input_array:
+                data = numpy.transpose(data)
+            _copy_in_place(pd.scalars, data)
         if self.vector_data is not None:
-            pd.vectors.modified()
+            data = self.vector_data
+            if len(data.shape) == 3:
+                data = data[:, :, numpy.newaxis, :]
+            if self.transpose_input_array:
+                data = numpy.transpose(data, (2, 1, 0, 3))
+            _copy_in_place(pd.vectors, data)
         self.data_changed = True
 
     ######################################################################
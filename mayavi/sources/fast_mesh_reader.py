@@ -0,0 +1,451 @@
+"""Fast parsers for large OBJ, STL, PLY and text point files.
+
+The files are memory-mapped and parsed in large blocks with regular
+expressions and numpy, building the points and the cell connectivity
+as arrays instead of one value at a time.  They are an alternative to
+the VTK readers used by `PolyDataReader` for these extensions.  Files
+using features the parsers do not handle are read with the VTK reader.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import re
+import mmap
+import time
+import logging
+
+import numpy
+
+# Enthought library imports.
+from traits.api import HasTraits, Str, Bool, Float, Int, Instance
+from traitsui.api import View, Group, Item
+from tvtk.api import tvtk
+from tvtk.array_handler import ID_TYPE_CODE
+
+# Setup a logger for this module.
+logger = logging.getLogger(__name__)
+
+# The size of the blocks of the file parsed at once.
+CHUNK_SIZE = 32*1024*1024
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _chunks(buf, start, end, chunk_size):
+    """Yields (begin, end) offsets of blocks of complete lines of the
+    buffer `buf` between `start` and `end`."""
+    while start < end:
+        stop = min(start + chunk_size, end)
+        if stop < end:
+            nl = buf.find('\n', stop)
+            stop = end if nl == -1 or nl >= end else nl + 1
+        yield start, stop
+        start = stop
+
+
+def _to_float(values):
+    """Converts a list of tuples of strings to an (N, 3) float32 array
+    without converting each value in Python."""
+    if len(values) == 0:
+        return numpy.zeros((0, 3), numpy.float32)
+    return numpy.array(values, 'S').astype(numpy.float32)
+
+
+def _tokens_per_line(text):
+    """Returns the number of whitespace separated tokens on each line
+    of `text`."""
+    a = numpy.frombuffer(text, numpy.uint8)
+    if len(a) == 0:
+        return numpy.zeros(0, int)
+    newline = a == 10
+    blank = (a == 32) | (a == 9) | (a == 13) | newline
+    # A token starts on a non blank character after a blank one.
+    prev = numpy.ones(len(a), bool)
+    prev[1:] = blank[:-1]
+    starts = numpy.flatnonzero(~blank & prev)
+    line = numpy.cumsum(newline)
+    return numpy.bincount(line[starts], minlength=line[-1] + 1)
+
+
+def _cells(ids, counts):
+    """Returns the VTK connectivity (n, i0, i1, ...) of cells with the
+    given numbers of point ids."""
+    cells = numpy.empty(len(counts) + len(ids), ID_TYPE_CODE)
+    starts = numpy.cumsum(counts + 1) - (counts + 1)
+    mask = numpy.ones(len(cells), bool)
+    mask[starts] = False
+    cells[starts] = counts
+    cells[mask] = ids
+    return cells
+
+
+def merge_points(points):
+    """Merges coincident points.  Returns the unique points, in the
+    order they first appear, and the index of each input point in
+    them."""
+    points = numpy.ascontiguousarray(points)
+    # Make -0.0 and 0.0 compare equal.
+    points = points + points.dtype.type(0)
+    rows = points.view(numpy.dtype((numpy.void,
+                                    points.dtype.itemsize*points.shape[1])))
+    rows = rows.ravel()
+    uniq, first, inverse = numpy.unique(rows, return_index=True,
+                                        return_inverse=True)
+    order = numpy.argsort(first)
+    remap = numpy.empty(len(order), ID_TYPE_CODE)
+    remap[order] = numpy.arange(len(order))
+    return points[first[order]], remap[inverse]
+
+
+######################################################################
+# Parsers.  They take a buffer and return (points, cells, n_cells,
+# kind) where `kind` is 'polys' or 'verts' and `cells` is either an
+# (n_cells, n) array or the flat VTK connectivity, or None if the file
+# cannot be parsed.
+######################################################################
+_OBJ_VERTEX = re.compile(r'^v[ \t]+(\S+)[ \t]+(\S+)[ \t]+(\S+)', re.M)
+_OBJ_FACE = re.compile(r'^f[ \t]+([^\r\n#]*)', re.M)
+# The texture and normal indices of a face vertex.
+_OBJ_SLASH = re.compile(r'/\S*')
+
+
+def parse_obj(buf, chunk_size=CHUNK_SIZE, merge=False):
+    """Parses the vertices and faces of a Wavefront OBJ file."""
+    points, ids, counts = [], [], []
+    for begin, end in _chunks(buf, 0, len(buf), chunk_size):
+        text = buf[begin:end]
+        points.append(_to_float(_OBJ_VERTEX.findall(text)))
+        faces = _OBJ_FACE.findall(text)
+        if len(faces) == 0:
+            continue
+        text = _OBJ_SLASH.sub('', '\n'.join(faces))
+        counts.append(_tokens_per_line(text))
+        ids.append(numpy.fromstring(text, dtype=ID_TYPE_CODE, sep=' '))
+    points = numpy.concatenate(points)
+    if len(ids) == 0:
+        return points, numpy.zeros((0, 3), ID_TYPE_CODE), 0, 'polys'
+    ids = numpy.concatenate(ids)
+    counts = numpy.concatenate(counts)
+    if counts.sum() != len(ids) or \
+           (len(ids) and (ids.min() < 1 or ids.max() > len(points))):
+        # Relative (negative) indices, indices past the last vertex or
+        # unparsable faces.
+        return None
+    ids -= 1
+    if numpy.all(counts == 3):
+        return points, ids.reshape(-1, 3), len(counts), 'polys'
+    return points, _cells(ids, counts), len(counts), 'polys'
+
+
+_STL_VERTEX = re.compile(
+    r'^[ \t]*vertex[ \t]+(\S+)[ \t]+(\S+)[ \t]+(\S+)', re.M)
+
+_STL_BINARY = numpy.dtype([('normal', '<f4', (3,)),
+                           ('points', '<f4', (3, 3)),
+                           ('attribute', '<u2')])
+
+
+def _is_ascii_stl(buf):
+    """True if the STL file looks like an ASCII one: its first bytes
+    are text and hold the start of a facet, as vtkSTLReader checks."""
+    head = buf[:512]
+    return numpy.frombuffer(head, numpy.uint8).max() < 128 and \
+           head.lstrip().lower().startswith('solid') and 'facet' in head
+
+
+def parse_stl(buf, chunk_size=CHUNK_SIZE, merge=True):
+    """Parses an ASCII or binary STL file.  Coincident points are
+    merged if `merge` is set."""
+    size = len(buf)
+    n = 0
+    if size >= 84:
+        n = int(numpy.frombuffer(buf, '<u4', 1, 80)[0])
+    # Some exporters pad binary files.
+    if size >= 84 and (84 + 50*n == size or
+                       (84 + 50*n < size and not _is_ascii_stl(buf))):
+        tris = numpy.frombuffer(buf, _STL_BINARY, n, 84)
+        points = tris['points'].reshape(-1, 3).astype(numpy.float32)
+    else:
+        points = [_to_float(_STL_VERTEX.findall(buf[begin:end]))
+                  for begin, end in _chunks(buf, 0, size, chunk_size)]
+        points = numpy.concatenate(points)
+        if len(points) % 3 != 0 or (len(points) == 0 and size > 0):
+            # Not a file we understand, leave it to the VTK reader.
+            return None
+    if merge:
+        points, ids = merge_points(points)
+    else:
+        ids = numpy.arange(len(points), dtype=ID_TYPE_CODE)
+    return points, ids.reshape(-1, 3), len(ids)//3, 'polys'
+
+
+_PLY_TYPES = {'char': 'i1', 'int8': 'i1', 'uchar': 'u1', 'uint8': 'u1',
+              'short': 'i2', 'int16': 'i2', 'ushort': 'u2', 'uint16': 'u2',
+              'int': 'i4', 'int32': 'i4', 'uint': 'u4', 'uint32': 'u4',
+              'float': 'f4', 'float32': 'f4', 'double': 'f8',
+              'float64': 'f8'}
+
+
+def _parse_ply_header(buf):
+    """Returns the format, the elements (name, count, properties) and
+    the size of the header of a PLY file or None."""
+    end = buf.find('end_header', 0, 65536)
+    if not buf[:3] == 'ply' or end == -1:
+        return None
+    body = buf.find('\n', end) + 1
+    fmt = None
+    elements = []
+    for line in buf[:end].splitlines():
+        words = line.split()
+        if len(words) == 0:
+            continue
+        if words[0] == 'format':
+            fmt = words[1]
+        elif words[0] == 'element':
+            elements.append((words[1], int(words[2]), []))
+        elif words[0] == 'property' and len(elements) > 0:
+            if words[1] == 'list':
+                prop = (words[4], _PLY_TYPES.get(words[2]),
+                        _PLY_TYPES.get(words[3]))
+            else:
+                prop = (words[2], _PLY_TYPES.get(words[1]), None)
+            if prop[1] is None or (words[1] == 'list' and prop[2] is None):
+                return None
+            elements[-1][2].append(prop)
+    return fmt, elements, body
+
+
+def parse_ply(buf, chunk_size=CHUNK_SIZE, merge=False):
+    """Parses the vertices and faces of an ASCII or binary PLY file.
+    Only the point coordinates are read."""
+    header = _parse_ply_header(buf)
+    if header is None:
+        return None
+    fmt, elements, pos = header
+    binary = fmt != 'ascii'
+    order = '>' if fmt == 'binary_big_endian' else '<'
+    points = None
+    cells = ids = numpy.zeros((0, 3), ID_TYPE_CODE)
+    n_cells = 0
+    for name, count, props in elements:
+        lists = [p for p in props if p[2] is not None]
+        if name == 'vertex':
+            if lists:
+                return None
+            names = [p[0] for p in props]
+            if not set('xyz') <= set(names):
+                return None
+            cols = [names.index(c) for c in 'xyz']
+            if binary:
+                dtype = numpy.dtype([(p[0], order + p[1]) for p in props])
+                v = numpy.frombuffer(buf, dtype, count, pos)
+                pos += dtype.itemsize*count
+                points = numpy.empty((count, 3), numpy.float32)
+                for i, c in enumerate('xyz'):
+                    points[:, i] = v[c]
+            else:
+                end = _skip_lines(buf, pos, count)
+                v = numpy.fromstring(buf[pos:end], dtype=float, sep=' ')
+                if v.size != count*len(props):
+                    return None
+                points = v.reshape(count, len(props))[:, cols]
+                points = points.astype(numpy.float32)
+                pos = end
+        elif name == 'face':
+            if len(props) != 1 or len(lists) != 1:
+                return None
+            prop_name, count_type, index_type = props[0]
+            if binary:
+                if count == 0:
+                    continue
+                n = int(numpy.frombuffer(buf, order + count_type, 1, pos)[0])
+                dtype = numpy.dtype([('n', order + count_type),
+                                     ('ids', order + index_type, (n,))])
+                f = numpy.frombuffer(buf, dtype, count, pos)
+                if numpy.any(f['n'] != n):
+                    # Faces of different sizes.
+                    return None
+                cells = ids = f['ids'].astype(ID_TYPE_CODE)
+            else:
+                end = _skip_lines(buf, pos, count)
+                text = buf[pos:end]
+                # Each line is already the VTK connectivity "n i0 i1 ...".
+                cells = numpy.fromstring(text, dtype=ID_TYPE_CODE, sep=' ')
+                counts = _tokens_per_line(text)[:count] - 1
+                if len(counts) != count or \
+                       counts.sum() + count != cells.size:
+                    return None
+                if count > 0 and numpy.all(counts == counts[0]):
+                    cells = ids = cells.reshape(count, -1)[:, 1:]
+                else:
+                    # Drop the vertex count in front of each face.
+                    starts = numpy.cumsum(counts + 1) - (counts + 1)
+                    ids = numpy.delete(cells, starts)
+                pos = end
+            n_cells = count
+        elif points is not None and n_cells > 0:
+            break
+        elif lists:
+            # Cannot skip an element of variable size.
+            return None
+        else:
+            # Skip the element.
+            if binary:
+                dtype = numpy.dtype([(p[0], order + p[1]) for p in props])
+                pos += dtype.itemsize*count
+            else:
+                pos = _skip_lines(buf, pos, count)
+    if points is None:
+        return None
+    if ids.size and (ids.min() < 0 or ids.max() >= len(points)):
+        # Indices past the last vertex.
+        return None
+    return points, cells, n_cells, 'polys'
+
+
+def _skip_lines(buf, pos, count):
+    """Returns the offset after `count` lines starting at `pos`."""
+    for i in xrange(count):
+        nl = buf.find('\n', pos)
+        if nl == -1:
+            return len(buf)
+        pos = nl + 1
+    return pos
+
+
+def parse_points(buf, chunk_size=CHUNK_SIZE, merge=False):
+    """Parses a text file with 3 coordinates per line, like
+    `SimplePointsReader`.  Each point is a vertex cell."""
+    blocks = []
+    for begin, end in _chunks(buf, 0, len(buf), chunk_size):
+        values = numpy.fromstring(buf[begin:end], dtype=numpy.float32,
+                                  sep=' ')
+        if values.size % 3 != 0:
+            return None
+        blocks.append(values.reshape(-1, 3))
+    if len(blocks) == 0:
+        points = numpy.zeros((0, 3), numpy.float32)
+    else:
+        points = numpy.concatenate(blocks)
+    n = len(points)
+    return points, numpy.arange(n, dtype=ID_TYPE_CODE).reshape(n, 1), n, \
+           'verts'
+
+
+# The parsers and the VTK readers used for the files they cannot read,
+# by extension.
+PARSERS = {'obj': (parse_obj, 'OBJReader'),
+           'stl': (parse_stl, 'STLReader'),
+           'stla': (parse_stl, 'STLReader'),
+           'stlb': (parse_stl, 'STLReader'),
+           'ply': (parse_ply, 'PLYReader'),
+           'txt': (parse_points, 'SimplePointsReader'),
+          }
+
+
+def make_poly_data(points, cells, n_cells, kind):
+    """Returns a tvtk.PolyData for the output of a parser."""
+    pd = tvtk.PolyData(points=points)
+    if cells.ndim == 2:
+        setattr(pd, kind, cells)
+    else:
+        ca = tvtk.CellArray()
+        ca.set_cells(n_cells, cells)
+        setattr(pd, kind, ca)
+    return pd
+
+
+######################################################################
+# `FastMeshReader` class
+######################################################################
+class FastMeshReader(HasTraits):
+
+    """A reader using the fast parsers, with the interface of the VTK
+    readers used by `PolyDataReader`.
+    """
+
+    # The file to read.
+    file_name = Str('', desc='the file to read')
+
+    # Merge the coincident points of STL files.
+    merge_points = Bool(True, desc='if coincident STL points are merged')
+
+    # The data read.
+    output = Instance(tvtk.PolyData, ())
+
+    # True if the last file was read with the VTK reader because the
+    # parser could not handle it.
+    used_fallback = Bool(False)
+
+    # The size of the last file read, the time taken and the reading
+    # rate.
+    file_size = Int(0)
+    read_time = Float(0.0)
+    bytes_per_second = Float(0.0)
+
+    view = View(Group(Item(name='file_name', style='readonly'),
+                      Item(name='merge_points'),
+                      Item(name='used_fallback', style='readonly'),
+                      Item(name='bytes_per_second', style='readonly')))
+
+    ######################################################################
+    # `object` interface
+    ######################################################################
+    def __get_pure_state__(self):
+        d = self.__getstate__()
+        # The data is read from the file.
+        for x in ['output', 'used_fallback', 'file_size', 'read_time',
+                  'bytes_per_second']:
+            d.pop(x, None)
+        return d
+
+    ######################################################################
+    # `FastMeshReader` interface
+    ######################################################################
+    def can_parse(cls, file_name):
+        """True if there is a parser for the extension of the file."""
+        return file_name.strip().split('.')[-1].lower() in PARSERS
+
+    can_parse = classmethod(can_parse)
+
+    def update(self):
+        file_name = self.file_name.strip()
+        if len(file_name) == 0:
+            return
+        extension = file_name.split('.')[-1].lower()
+        parser, vtk_reader = PARSERS[extension]
+        t0 = time.time()
+        f = open(file_name, 'rb')
+        try:
+            size = os.fstat(f.fileno()).st_size
+            if size == 0:
+                result = None
+            else:
+                buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+                try:
+                    result = parser(buf, merge=self.merge_points)
+                finally:
+                    buf.close()
+        finally:
+            f.close()
+
+        if result is None:
+            reader = getattr(tvtk, vtk_reader)(file_name=file_name)
+            reader.update()
+            output = reader.output
+        else:
+            output = make_poly_data(*result)
+        dt = max(time.time() - t0, 1e-6)
+        self.set(used_fallback=result is None, file_size=size,
+                 read_time=dt, bytes_per_second=size/dt)
+        logger.info('Read %s: %d bytes in %.3f s (%.1f MB/s)', file_name,
+                    size, dt, size/dt/1e6)
+        # The output is updated in place so that the pipeline sees the
+        # new data.
+        self.output.shallow_copy(output)
+
+    def update_information(self):
+        pass
@@ -0,0 +1,521 @@
+"""A fast reader for binary PLOT3D grid and solution files.
+
+The files are memory-mapped and their layout (byte order, Fortran record
+markers, single or multiple grids, 2D or 3D, single or double precision,
+blanking) is found from the sizes in the headers.  The blocks are read
+on worker threads.  The solution (Q) variables are kept once read, so
+that changing the derived scalar or vector shown only computes the new
+function.  This is an alternative to the VTK reader used by
+`PLOT3DReader`.
+
+The derived quantities use a ratio of specific heats of 1.4 and a gas
+constant of 1, like the VTK reader.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import mmap
+import time
+import logging
+
+import numpy
+
+# Enthought library imports.
+from traits.api import HasTraits, Str, Int, Float, List, Any
+from traitsui.api import View, Group, Item
+from tvtk.api import tvtk
+
+# Local imports.
+from mayavi.core.common import parallel_map
+
+# Setup a logger for this module.
+logger = logging.getLogger(__name__)
+
+# The ratio of specific heats and the gas constant.
+GAMMA = 1.4
+R_GAS = 1.0
+
+# The names of the arrays of the VTK PLOT3D function numbers.
+SCALAR_FUNCTIONS = {100: 'Density',
+                    110: 'Pressure',
+                    120: 'Temperature',
+                    130: 'Enthalpy',
+                    140: 'InternalEnergy',
+                    144: 'KineticEnergy',
+                    153: 'VelocityMagnitude',
+                    163: 'StagnationEnergy',
+                    170: 'Entropy',
+                    184: 'Swirl'}
+
+VECTOR_FUNCTIONS = {200: 'Velocity',
+                    201: 'Vorticity',
+                    202: 'Momentum',
+                    210: 'PressureGradient'}
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _map_file(file_name):
+    """Returns a read-only memory map of the file, or an empty string
+    for an empty file."""
+    f = open(file_name, 'rb')
+    try:
+        if os.fstat(f.fileno()).st_size == 0:
+            return ''
+        return mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    finally:
+        f.close()
+
+
+def _int(buf, offset, endian):
+    return int(numpy.frombuffer(buf, endian + 'i4', 1, offset)[0])
+
+
+def _record(buf, offset, nbytes, endian, records):
+    """Returns the offsets of the data of a record of `nbytes` starting
+    at `offset` and of the end of the record, or None if the record
+    does not fit in the buffer or its Fortran markers do not match."""
+    if not records:
+        end = offset + nbytes
+        if end > len(buf):
+            return None
+        return offset, end
+    end = offset + nbytes + 8
+    if end > len(buf) or _int(buf, offset, endian) != nbytes or \
+           _int(buf, end - 4, endian) != nbytes:
+        return None
+    return offset + 4, end
+
+
+def _read_header(buf, endian, records, multi_grid, ndim):
+    """Returns the dimensions of the blocks of a PLOT3D file and the
+    offset following them, or None if the header does not match."""
+    offset = 0
+    n_blocks = 1
+    if multi_grid:
+        r = _record(buf, 0, 4, endian, records)
+        if r is None:
+            return None
+        n_blocks = _int(buf, r[0], endian)
+        offset = r[1]
+        if n_blocks < 1 or n_blocks*ndim*4 > len(buf):
+            return None
+    r = _record(buf, offset, n_blocks*ndim*4, endian, records)
+    if r is None:
+        return None
+    dims = numpy.frombuffer(buf, endian + 'i4', n_blocks*ndim, r[0])
+    if (dims < 1).any():
+        return None
+    dims = [tuple(int(x) for x in d) + (1,)*(3 - ndim)
+            for d in dims.reshape(n_blocks, ndim)]
+    return dims, r[1]
+
+
+def _block_offsets(buf, start, dims, endian, records, block_records):
+    """Returns the offset of the last record of each block, or None if
+    the records do not end exactly at the end of the buffer.
+    `block_records(n)` gives the sizes of the records of a block of `n`
+    points."""
+    offsets = []
+    offset = start
+    for d in dims:
+        for nbytes in block_records(d[0]*d[1]*d[2]):
+            r = _record(buf, offset, nbytes, endian, records)
+            if r is None:
+                return None
+            offset = r[1]
+        offsets.append(r[0])
+    if offset != len(buf):
+        return None
+    return offsets
+
+
+def grid_layout(buf):
+    """Finds the layout of the binary PLOT3D grid in the buffer `buf`.
+    Returns a dict or None if the buffer is not a grid file."""
+    for records in (True, False):
+        for endian in ('>', '<'):
+            for multi_grid in (True, False):
+                for ndim in (3, 2):
+                    header = _read_header(buf, endian, records,
+                                          multi_grid, ndim)
+                    if header is None:
+                        continue
+                    dims, start = header
+                    for fsize in (4, 8):
+                        for iblank in (False, True):
+                            def _sizes(n):
+                                return [n*(ndim*fsize + 4*iblank)]
+                            offsets = _block_offsets(buf, start, dims,
+                                                     endian, records,
+                                                     _sizes)
+                            if offsets is not None:
+                                return dict(endian=endian,
+                                            records=records,
+                                            multi_grid=multi_grid,
+                                            ndim=ndim, dims=dims,
+                                            float_size=fsize,
+                                            iblank=iblank,
+                                            offsets=offsets)
+    return None
+
+
+def q_layout(buf, grid):
+    """Finds the layout of the binary PLOT3D solution in `buf` for the
+    grid of layout `grid`.  Returns a dict or None."""
+    endian, records = grid['endian'], grid['records']
+    header = _read_header(buf, endian, records, grid['multi_grid'],
+                          grid['ndim'])
+    if header is None or header[0] != grid['dims']:
+        return None
+    dims, start = header
+    n_vars = grid['ndim'] + 2
+    for fsize in (grid['float_size'], 12 - grid['float_size']):
+        def _sizes(n):
+            # The free stream conditions and the variables.
+            return [4*fsize, n_vars*n*fsize]
+        offsets = _block_offsets(buf, start, dims, endian, records,
+                                 _sizes)
+        if offsets is not None:
+            return dict(float_size=fsize, n_vars=n_vars, offsets=offsets)
+    return None
+
+
+def read_grid_block(buf, layout, index):
+    """Returns the (N, 3) points of the block `index` of the grid."""
+    d = layout['dims'][index]
+    n = d[0]*d[1]*d[2]
+    ndim = layout['ndim']
+    dtype = numpy.dtype('%sf%d'%(layout['endian'], layout['float_size']))
+    coords = numpy.frombuffer(buf, dtype, ndim*n, layout['offsets'][index])
+    points = numpy.zeros((n, 3), dtype.newbyteorder('='))
+    for c in range(ndim):
+        points[:, c] = coords[c*n:(c + 1)*n]
+    return points
+
+
+def read_q_block(buf, grid, layout, index):
+    """Returns the density, the (N, 3) momentum and the energy of the
+    block `index` of the solution.  The density and the energy are
+    views of `buf` when the file has the native byte order."""
+    d = grid['dims'][index]
+    n = d[0]*d[1]*d[2]
+    n_vars = layout['n_vars']
+    dtype = numpy.dtype('%sf%d'%(grid['endian'], layout['float_size']))
+    q = numpy.frombuffer(buf, dtype, n_vars*n, layout['offsets'][index])
+    q = q.reshape(n_vars, n)
+    if not dtype.isnative:
+        q = q.astype(dtype.newbyteorder('='))
+    momentum = numpy.zeros((n, 3), q.dtype)
+    for c in range(n_vars - 2):
+        momentum[:, c] = q[1 + c]
+    return q[0], momentum, q[n_vars - 1]
+
+
+def _diff(a, axis):
+    """Central differences of the 3D array `a` along `axis`, one sided
+    at the ends."""
+    out = numpy.empty(a.shape, float)
+    def _s(index):
+        s = [slice(None)]*3
+        s[axis] = index
+        return tuple(s)
+    out[_s(slice(1, -1))] = 0.5*(a[_s(slice(2, None))] -
+                                 a[_s(slice(None, -2))])
+    out[_s(0)] = a[_s(1)] - a[_s(0)]
+    out[_s(-1)] = a[_s(-1)] - a[_s(-2)]
+    return out
+
+
+def grid_derivatives(values, dims):
+    """Returns the (N, 3) derivatives of the point values along the i,
+    j and k directions of the grid.  They are zero along directions
+    with a single point."""
+    a = numpy.reshape(values, dims[::-1])
+    out = numpy.zeros((len(values), 3))
+    for c, axis in enumerate((2, 1, 0)):
+        if a.shape[axis] > 1:
+            out[:, c] = _diff(a, axis).ravel()
+    return out
+
+
+def inverse_jacobian(points, dims):
+    """Returns the (N, 3, 3) inverse of the Jacobian of the grid, the
+    derivatives of i, j, k with respect to x, y, z.  Directions with a
+    single point are taken normal to the others."""
+    jac = numpy.empty((len(points), 3, 3))
+    for c in range(3):
+        jac[:, c, :] = grid_derivatives(points[:, c], dims)
+    for b in range(3):
+        if dims[b] > 1:
+            continue
+        others = [o for o in range(3) if o != b]
+        normal = numpy.cross(jac[:, :, others[0]], jac[:, :, others[1]])
+        length = numpy.sqrt((normal*normal).sum(axis=1))
+        unit = numpy.zeros(3)
+        unit[b] = 1.0
+        ok = length > 0
+        normal[ok] /= length[ok][:, None]
+        normal[~ok] = unit
+        jac[:, :, b] = normal
+    try:
+        return numpy.linalg.inv(jac)
+    except numpy.linalg.LinAlgError:
+        return numpy.array([numpy.linalg.pinv(j) for j in jac])
+
+
+def gradient(values, dims, jinv):
+    """Returns the (N, 3) gradient of the point values given the
+    inverse Jacobian of the grid."""
+    return numpy.einsum('nb,nba->na', grid_derivatives(values, dims), jinv)
+
+
+######################################################################
+# `Block` class.
+######################################################################
+class Block(object):
+    """The points and the solution variables of a block and the
+    functions computed from them."""
+
+    def __init__(self, dims, points):
+        self.dims = dims
+        self.points = points
+        self.density = self.momentum = self.energy = None
+        self._jinv = None
+
+    def has_solution(self):
+        return self.density is not None
+
+    def jinv(self):
+        # The metrics only depend on the grid and are kept.
+        if self._jinv is None:
+            self._jinv = inverse_jacobian(self.points, self.dims)
+        return self._jinv
+
+    def _flow(self):
+        """Returns the density (never zero), the velocity, its square
+        and the pressure."""
+        rho = numpy.where(self.density != 0.0, self.density, 1.0)
+        v = self.momentum/rho[:, None]
+        v2 = (v*v).sum(axis=1)
+        p = (GAMMA - 1.0)*(self.energy - 0.5*rho*v2)
+        return rho, v, v2, p
+
+    def _vorticity(self, v):
+        dims, jinv = self.dims, self.jinv()
+        du, dv, dw = [gradient(v[:, c], dims, jinv) for c in range(3)]
+        return numpy.column_stack((dw[:, 1] - dv[:, 2],
+                                   du[:, 2] - dw[:, 0],
+                                   dv[:, 0] - du[:, 1]))
+
+    def scalar(self, number):
+        """Returns the scalar function with the VTK function number."""
+        if number == 100:
+            return self.density
+        if number == 163:
+            return self.energy
+        rho, v, v2, p = self._flow()
+        if number == 110:
+            return p
+        elif number == 120:
+            return p/(rho*R_GAS)
+        elif number == 130:
+            return GAMMA*(self.energy/rho - 0.5*v2)
+        elif number == 140:
+            return self.energy/rho - 0.5*v2
+        elif number == 144:
+            return 0.5*v2
+        elif number == 153:
+            return numpy.sqrt(v2)
+        elif number == 170:
+            cv = R_GAS/(GAMMA - 1.0)
+            # The free stream pressure is 1/GAMMA.
+            old = numpy.seterr(divide='ignore', invalid='ignore')
+            try:
+                return cv*numpy.log(GAMMA*p/rho**GAMMA)
+            finally:
+                numpy.seterr(**old)
+        elif number == 184:
+            w = self._vorticity(v)
+            swirl = (w*v).sum(axis=1)
+            ok = v2 != 0.0
+            swirl[ok] /= v2[ok]
+            swirl[~ok] = 0.0
+            return swirl
+        raise ValueError('Unknown scalar function %s'%number)
+
+    def vector(self, number):
+        """Returns the vector function with the VTK function number."""
+        if number == 202:
+            return self.momentum
+        rho, v, v2, p = self._flow()
+        if number == 200:
+            return v
+        elif number == 201:
+            return self._vorticity(v)
+        elif number == 210:
+            return gradient(p, self.dims, self.jinv())
+        raise ValueError('Unknown vector function %s'%number)
+
+
+######################################################################
+# `FastPLOT3DReader` class.
+######################################################################
+class FastPLOT3DReader(HasTraits):
+
+    """Reads binary PLOT3D files into one StructuredGrid per block.
+    The grid is only read again when the file changes, and changing
+    the function numbers only computes the new functions.
+    """
+
+    # The grid and the (optional) solution file.
+    xyz_file_name = Str('', desc='the XYZ file')
+    q_file_name = Str('', desc='the Q file')
+
+    # The VTK numbers of the scalar and vector functions.
+    scalar_function_number = Int(100, desc='the scalar function')
+    vector_function_number = Int(202, desc='the vector function')
+
+    # The number of threads reading the blocks, all the processors if
+    # zero.
+    n_threads = Int(0, desc='the number of threads reading the blocks')
+
+    # The outputs, one StructuredGrid per block.
+    outputs = List
+
+    # The time taken by the last read of the files.
+    read_time = Float(0.0, desc='the time taken to read the files')
+
+    view = View(Group(Item(name='xyz_file_name', style='readonly'),
+                      Item(name='q_file_name', style='readonly'),
+                      Item(name='n_threads'),
+                      Item(name='read_time', style='readonly')))
+
+    ########################################
+    # Private traits.
+
+    # The blocks read and the (name, size, mtime) of the files they
+    # were read from.
+    _blocks = Any
+    _grid_key = Any
+    _q_key = Any
+
+    # The layout of the grid file.
+    _layout = Any
+
+    ######################################################################
+    # `object` interface
+    ######################################################################
+    def __get_pure_state__(self):
+        d = self.__getstate__()
+        for name in ('outputs', 'read_time', '_blocks', '_grid_key',
+                     '_q_key', '_layout'):
+            d.pop(name, None)
+        return d
+
+    ######################################################################
+    # `FastPLOT3DReader` interface
+    ######################################################################
+    @classmethod
+    def can_read(cls, file_name):
+        """Returns True if the file is a binary PLOT3D grid."""
+        try:
+            return grid_layout(_map_file(file_name)) is not None
+        except (IOError, OSError, ValueError):
+            return False
+
+    def update(self):
+        """Reads the files if they changed and computes the functions.
+        Raises a ValueError if a file is not in a known format."""
+        t0 = time.time()
+        read = self._read_grid()
+        read = self._read_q() or read
+        if read:
+            self.read_time = time.time() - t0
+            logger.debug('Read %s in %.3f s', self.xyz_file_name,
+                         self.read_time)
+        self.update_functions()
+
+    def update_functions(self):
+        """Computes the scalar and vector functions on the blocks
+        already read."""
+        blocks = self._blocks or []
+        if len(blocks) == 0 or not blocks[0].has_solution():
+            return
+        s_num, v_num = self.scalar_function_number, \
+                       self.vector_function_number
+        def _compute(block):
+            return block.scalar(s_num), block.vector(v_num)
+        values = parallel_map(_compute, blocks, self.n_threads)
+        s_name, v_name = SCALAR_FUNCTIONS[s_num], VECTOR_FUNCTIONS[v_num]
+        for sg, (scalars, vectors) in zip(self.outputs, values):
+            pd = sg.point_data
+            pd.scalars = scalars
+            pd.scalars.name = s_name
+            pd.vectors = vectors
+            pd.vectors.name = v_name
+            pd.update()
+
+    ######################################################################
+    # Non-public interface
+    ######################################################################
+    def _file_key(self, file_name):
+        st = os.stat(file_name)
+        return file_name, st.st_size, st.st_mtime
+
+    def _read_grid(self):
+        key = self._file_key(self.xyz_file_name)
+        if key == self._grid_key:
+            return False
+        buf = _map_file(self.xyz_file_name)
+        layout = grid_layout(buf)
+        if layout is None:
+            raise ValueError('%s is not a binary PLOT3D grid file.'
+                             %self.xyz_file_name)
+        def _read(index):
+            return read_grid_block(buf, layout, index)
+        points = parallel_map(_read, range(len(layout['dims'])),
+                              self.n_threads)
+        blocks = []
+        outputs = []
+        for dims, pts in zip(layout['dims'], points):
+            blocks.append(Block(dims, pts))
+            sg = tvtk.StructuredGrid(dimensions=dims)
+            sg.points = pts
+            outputs.append(sg)
+        self._layout = layout
+        self._blocks = blocks
+        self._grid_key = key
+        self._q_key = None
+        self.outputs = outputs
+        return True
+
+    def _read_q(self):
+        if len(self.q_file_name) == 0:
+            return False
+        key = self._file_key(self.q_file_name)
+        if key == self._q_key:
+            return False
+        buf = _map_file(self.q_file_name)
+        grid = self._layout
+        layout = q_layout(buf, grid)
+        if layout is None:
+            raise ValueError('%s is not a binary PLOT3D solution for %s.'
+                             %(self.q_file_name, self.xyz_file_name))
+        def _read(index):
+            return read_q_block(buf, grid, layout, index)
+        values = parallel_map(_read, range(len(grid['dims'])),
+                              self.n_threads)
+        for block, (rho, m, e) in zip(self._blocks, values):
+            block.density, block.momentum, block.energy = rho, m, e
+        self._q_key = key
+        return True
+
+    def _xyz_file_name_changed(self):
+        self._grid_key = None
+
+    def _q_file_name_changed(self):
+        self._q_key = None
@@ -9,16 +9,50 @@
 # Copyright (c) 2007, Enthought, Inc.
 # License: BSD Style.
 
+import threading
 from os.path import basename
 
 # Enthought library imports.
-from traits.api import Instance, Str, Dict
+from traits.api import Instance, Str, Dict, Bool, Int, Range, Any
+from traits.etsconfig.api import ETSConfig
 from traitsui.api import View, Group, Item, Include
+from pyface.api import GUI
+from pyface.util import guisupport
 from tvtk.api import tvtk
 
 # Local imports.
 from mayavi.core.file_data_source import FileDataSource
 from mayavi.core.pipeline_info import PipelineInfo
+from mayavi.core.common import error
+from mayavi.sources.slice_stack import SliceStackLoader, make_image_data
+
+
+# The names of the tvtk reader classes used for each file extension.
+# The readers are only created when a file with that extension is read.
+READER_CLASSES = {'bmp': 'BMPReader',
+                  'jpg': 'JPEGReader',
+                  'jpeg': 'JPEGReader',
+                  'png': 'PNGReader',
+                  'pnm': 'PNMReader',
+                  'dcm': 'DICOMImageReader',
+                  'tiff': 'TIFFReader',
+                  'ximg': 'GESignaReader',
+                  'dem': 'DEMReader',
+                  'mha': 'MetaImageReader',
+                  'mhd': 'MetaImageReader',
+                  # Pre 5.2 VTK versions do not have a MINC reader.
+                  'mnc': 'MINCImageReader',
+                 }
+
+
+def _event_loop_running():
+    """Returns True if the GUI event loop is running, so that calls
+    posted with `GUI.invoke_later` are run."""
+    if ETSConfig.toolkit == 'wx':
+        return guisupport.is_event_loop_running_wx()
+    elif ETSConfig.toolkit == 'qt4':
+        return guisupport.is_event_loop_running_qt4()
+    return False
 
 
 ########################################################################
@@ -36,12 +70,36 @@ class ImageReader(FileDataSource):
     # The Image data file reader.
     reader = Instance(tvtk.Object, allow_none=False, record=True)
 
+    # Load the files of the series as the z slices of a volume rather
+    # than as time steps.  Only self-describing formats (PNG, TIFF,
+    # DICOM, ...) can be stacked, not raw images.
+    stack = Bool(False, desc='if the files are the slices of a volume')
+
+    # The number of threads decoding the slices of a stack, all the
+    # processors if zero.
+    n_threads = Int(0, desc='the number of threads loading the slices')
+
+    # Load the stack on a background thread when the GUI event loop is
+    # running, so the UI (and `cancel_stack`) stays usable meanwhile.
+    background = Bool(True, desc='if the stack is loaded in the background')
+
+    # The fraction of the slices of the stack loaded.
+    progress = Range(0.0, 1.0, desc='the fraction of the slices loaded')
+
     # Information about what this object can produce.
     output_info = PipelineInfo(datasets=['image_data'])
 
     # Our view.
     view = View(Group(Include('time_step_group'),
                       Item(name='base_file_name'),
+                      Group(Item(name='stack'),
+                            Item(name='n_threads',
+                                 enabled_when='object.stack'),
+                            Item(name='background',
+                                 enabled_when='object.stack'),
+                            Item(name='progress', style='readonly',
+                                 enabled_when='object.stack'),
+                            show_labels=True),
                       Item(name='reader',
                            style='custom',
                            resizable=True),
@@ -50,46 +108,60 @@ class ImageReader(FileDataSource):
 
     ######################################################################
     # Private Traits
+
+    # The readers created so far, by extension.
     _image_reader_dict = Dict(Str, Instance(tvtk.Object))
 
+    # The loader of the stack being loaded and the thread running it.
+    _stack_loader = Any
+    _stack_thread = Any
+
+    # The files of the stack shown and the volume they make.
+    _stack_files = Any
+    _stack_data = Instance(tvtk.ImageData)
+
     ######################################################################
     # `object` interface
     ######################################################################
-    def __init__(self, **traits):
-        d = {'bmp':tvtk.BMPReader(),
-             'jpg':tvtk.JPEGReader(),
-             'png':tvtk.PNGReader(),
-             'pnm':tvtk.PNMReader(),
-             'dcm':tvtk.DICOMImageReader(),
-             'tiff':tvtk.TIFFReader(),
-             'ximg':tvtk.GESignaReader(),
-             'dem':tvtk.DEMReader(),
-             'mha':tvtk.MetaImageReader(),
-             'mhd':tvtk.MetaImageReader(),
-            }
-        # Account for pre 5.2 VTk versions, without MINC reader
-        if hasattr(tvtk, 'MINCImageReader'):
-            d['mnc'] = tvtk.MINCImageReader()
-        d['jpeg'] = d['jpg']
-        self._image_reader_dict = d
-        # Call parent class' init.
-        super(ImageReader, self).__init__(**traits)
-
     def __set_pure_state__(self, state):
         # The reader has its own file_name which needs to be fixed.
         state.reader.file_name = state.file_path.abs_pth
         # Now call the parent class to setup everything.
         super(ImageReader, self).__set_pure_state__(state)
 
+    def __get_pure_state__(self):
+        d = super(ImageReader, self).__get_pure_state__()
+        for name in ('progress', '_stack_loader', '_stack_thread',
+                     '_stack_files', '_stack_data'):
+            d.pop(name, None)
+        return d
+
     ######################################################################
     # `FileDataSource` interface
     ######################################################################
     def update(self):
-        self.reader.update()
+        if self.stack and len(self.file_list) > 1:
+            self._stack_files = None
+            self._file_path_changed(self.file_path)
+        else:
+            self.reader.update()
         if len(self.file_path.get()) == 0:
             return
         self.render()
 
+    ######################################################################
+    # `ImageReader` interface
+    ######################################################################
+    def cancel_stack(self):
+        """Cancels the loading of the stack.  This may be called from
+        the UI while the stack loads in the background, from another
+        thread or from a handler of `progress`.  The previous output is
+        kept.
+        """
+        loader = self._stack_loader
+        if loader is not None:
+            loader.cancel()
+
     ######################################################################
     # Non-public interface
     ######################################################################
@@ -102,24 +174,114 @@ class ImageReader(FileDataSource):
         extension = splitname[-1].lower()
         # Select image reader based on file type
         old_reader = self.reader
-        if self._image_reader_dict.has_key(extension):
-            self.reader = self._image_reader_dict[extension]
-        else:
-            self.reader = tvtk.ImageReader()
+        self.reader = self._get_reader(extension)
 
         self.reader.file_name = value.strip()
-        self.reader.update()
-        self.reader.update_information()
-
         if old_reader is not None:
             old_reader.on_trait_change(self.render, remove=True)
         self.reader.on_trait_change(self.render)
 
-        self.outputs = [self.reader.output]
+        if self.stack and len(self.file_list) > 1 and self._can_stack():
+            self._load_stack()
+        else:
+            self.cancel_stack()
+            self._stack_files = self._stack_data = None
+            self.reader.update()
+            self.reader.update_information()
+            self.outputs = [self.reader.output]
 
         # Change our name on the tree view
         self.name = self._get_name()
 
+    def _can_stack(self):
+        """True if the files can be loaded as a stack.  The readers of
+        the slices are new instances of the class of `reader`, which
+        is fine for formats describing the image in the file but not
+        for raw images whose extent, scalar type, byte order and header
+        size are settings of `reader`."""
+        if isinstance(self.reader, tvtk.ImageReader):
+            error('Only self-describing image formats (PNG, TIFF, '
+                  'DICOM, ...) can be loaded as a stack, not raw images.')
+            return False
+        return True
+
+    def _load_stack(self):
+        files = tuple(self.file_list)
+        if files == self._stack_files:
+            # Changing the time step does not change the stack.
+            return
+        # A stack still loading is not wanted anymore.
+        self.cancel_stack()
+        reader_class = tvtk.to_vtk(self.reader).__class__
+        loader = SliceStackLoader(files, reader_class, self.n_threads)
+        self._stack_loader = loader
+        self.progress = 0.0
+        if self.background and _event_loop_running():
+            # The progress and the result are posted to the GUI thread.
+            def _progress(fraction):
+                GUI.invoke_later(self._update_progress, fraction, loader)
+            def _run():
+                result = error_msg = None
+                try:
+                    result = loader.load(progress=_progress)
+                except Exception, e:
+                    error_msg = str(e)
+                GUI.invoke_later(self._stack_loaded, loader, files,
+                                 result, error_msg)
+            t = threading.Thread(target=_run)
+            t.setDaemon(True)
+            self._stack_thread = t
+            t.start()
+            return
+        try:
+            result = loader.load(progress=self._update_progress)
+        except (ValueError, IOError), e:
+            self._stack_loaded(loader, files, None, str(e))
+        else:
+            self._stack_loaded(loader, files, result)
+
+    def _stack_loaded(self, loader, files, result, error_msg=None):
+        """Shows the stack loaded by `loader`.  This is called on the
+        GUI thread.  The result of a loader that was replaced or
+        cancelled, even after it was done, is dropped."""
+        if loader is not self._stack_loader:
+            return
+        self._stack_loader = self._stack_thread = None
+        if error_msg is not None:
+            error(error_msg)
+            return
+        if result is None or loader.cancelled:
+            return
+        self._stack_files = files
+        self._stack_data = make_image_data(*result)
+        self.outputs = [self._stack_data]
+        self.render()
+
+    def _update_progress(self, fraction, loader=None):
+        if loader is None or loader is self._stack_loader:
+            self.progress = fraction
+
+    def _stack_changed(self):
+        self._stack_files = None
+        if len(self.file_path.get()) > 0:
+            self._file_path_changed(self.file_path)
+            self.render()
+
+    def _get_reader(self, extension):
+        """Returns the reader for the given extension, creating it on
+        first use.  A generic `tvtk.ImageReader` is returned for unknown
+        extensions."""
+        cls_name = READER_CLASSES.get(extension)
+        if cls_name is None or not hasattr(tvtk, cls_name):
+            return tvtk.ImageReader()
+        if extension == 'jpeg':
+            extension = 'jpg'
+        reader = self._image_reader_dict.get(extension)
+        if reader is None:
+            reader = getattr(tvtk, cls_name)()
+            self._image_reader_dict[extension] = reader
+        return reader
+
     def _get_name(self):
         """ Returns the name to display on the tree view.  Note that
         this is not a property getter.
@@ -127,7 +289,10 @@ class ImageReader(FileDataSource):
         fname = basename(self.file_path.get())
         ret = "%s"%fname
         if len(self.file_list) > 1:
-            ret += " (timeseries)"
+            if self.stack:
+                ret += " (stack)"
+            else:
+                ret += " (timeseries)"
         if '[Hidden]' in self.name:
             ret += ' [Hidden]'
 
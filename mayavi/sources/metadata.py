@@ -97,6 +97,22 @@ open_ugrid_data = SourceMetadata(
 )
 
 
+open_numpy = SourceMetadata(
+    id            = "NumpyFile",
+    class_name    = BASE + ".numpy_file_reader.NumpyFileReader",
+    menu_name     = "&NumPy file (NPY/NPZ)",
+    tooltip       = "Open a NumPy .npy or .npz file",
+    desc        = "Open a NumPy .npy or .npz file",
+    help        = "Open a NumPy .npy or .npz file",
+    extensions = ['npy', 'npz'],
+    wildcard = 'NumPy files (*.npy)|*.npy|'\
+               'NumPy archives (*.npz)|*.npz',
+    output_info = PipelineInfo(datasets=['image_data'],
+                               attribute_types=['any'],
+                               attributes=['any'])
+)
+
+
 open_plot3d = SourceMetadata(
     id            = "PLOT3DFile",
     class_name    = BASE + ".plot3d_reader.PLOT3DReader",
@@ -234,6 +250,20 @@ open_volume = SourceMetadata(
                                attributes=['any'])
 )
 
+open_raw_volume = SourceMetadata(
+    id            = "RawVolumeFile",
+    class_name    = BASE + ".raw_volume_reader.RawVolumeReader",
+    menu_name     = "&Raw volume file",
+    tooltip       = "Open a raw binary volume file",
+    desc        = "Open a raw binary volume file",
+    help        = "Open a raw binary volume file",
+    extensions = ['vol'],
+    wildcard = 'Raw volume files (*.vol)|*.vol',
+    output_info = PipelineInfo(datasets=['image_data'],
+                               attribute_types=['any'],
+                               attributes=['scalars'])
+)
+
 open_chaco = SourceMetadata(
     id            = "ChacoFile",
     class_name    = BASE + ".chaco_reader.ChacoReader",
@@ -253,6 +283,7 @@ open_chaco = SourceMetadata(
 # Now collect all the sources for the mayavi registry.
 sources = [open_3ds,
            open_image,
+           open_numpy,
            open_plot3d,
            open_vrml,
            open_vtk,
@@ -264,6 +295,7 @@ sources = [open_3ds,
            open_poly_data,
            open_ugrid_data,
            open_volume,
+           open_raw_volume,
            open_chaco,
            ]
 
@@ -0,0 +1,361 @@
+"""A reader for NumPy .npy and .npz files.
+
+The arrays are memory-mapped when possible and handed to VTK without a
+copy, so that only the parts of the file used by the pipeline are read
+from disk.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import struct
+import zipfile
+from os.path import basename
+
+import numpy
+from numpy.lib import format as npy_format
+
+# Enthought library imports.
+from traits.api import Instance, List, Str, Bool, Array
+from traitsui.api import View, Group, Item, Include
+from tvtk.api import tvtk
+from tvtk import array_handler
+
+# Local imports.
+from mayavi.core.file_data_source import FileDataSource
+from mayavi.core.trait_defs import DEnum
+from mayavi.core.pipeline_info import PipelineInfo
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _read_npy_header(f):
+    """Reads the header of the .npy data at the current position of
+    the file `f`.  Returns the shape, the Fortran order flag and the
+    dtype."""
+    version = npy_format.read_magic(f)
+    if version == (1, 0):
+        return npy_format.read_array_header_1_0(f)
+    return npy_format.read_array_header_2_0(f)
+
+
+def _map_npz_member(file_name, info, mmap_mode):
+    """Memory-maps the array stored uncompressed in the member `info`
+    of the .npz file `file_name`."""
+    f = open(file_name, 'rb')
+    try:
+        # The local file header is 30 bytes followed by the file name
+        # and the extra field.
+        f.seek(info.header_offset)
+        header = f.read(30)
+        name_len, extra_len = struct.unpack('<HH', header[26:30])
+        f.seek(info.header_offset + 30 + name_len + extra_len)
+        shape, fortran, dtype = _read_npy_header(f)
+        offset = f.tell()
+    finally:
+        f.close()
+    if dtype.hasobject:
+        raise ValueError('Object arrays cannot be memory-mapped.')
+    order = 'F' if fortran else 'C'
+    if numpy.prod(shape) == 0:
+        return numpy.empty(shape, dtype, order=order)
+    return numpy.memmap(file_name, dtype=dtype, mode=mmap_mode,
+                        offset=offset, shape=shape, order=order)
+
+
+def load_arrays(file_name, mmap_mode='c'):
+    """Returns a list of (name, array) for the arrays stored in the
+    given .npy or .npz file.  The arrays are memory-mapped with the
+    given `mmap_mode` if it is not None.  Use the copy-on-write 'c'
+    mode for arrays given to VTK, which writes into read-only pages
+    instead of raising an error.  The array of a .npy file is
+    named 'scalar' or 'vector' depending on its shape.  The arrays of
+    a .npz file can only be mapped if they are stored uncompressed
+    (`numpy.savez`), the others are read into memory.
+    """
+    if not zipfile.is_zipfile(file_name):
+        arr = numpy.load(file_name, mmap_mode=mmap_mode)
+        if is_vector_array(arr):
+            return [('vector', arr)]
+        return [('scalar', arr)]
+
+    result = []
+    z = zipfile.ZipFile(file_name)
+    try:
+        infos = z.infolist()
+    finally:
+        z.close()
+    npz = None
+    try:
+        for info in infos:
+            name = info.filename
+            if name.endswith('.npy'):
+                name = name[:-4]
+            arr = None
+            if mmap_mode is not None and \
+                   info.compress_type == zipfile.ZIP_STORED:
+                try:
+                    arr = _map_npz_member(file_name, info, mmap_mode)
+                except ValueError:
+                    arr = None
+            if arr is None:
+                if npz is None:
+                    npz = numpy.load(file_name)
+                arr = npz[name]
+            result.append((name, arr))
+    finally:
+        if npz is not None and hasattr(npz, 'close'):
+            npz.close()
+    return result
+
+
+def is_vector_array(arr):
+    """True if `arr` holds 3 component vectors in its last axis."""
+    return arr.ndim == 4 and arr.shape[-1] == 3
+
+
+def image_layout(arr, transpose=True):
+    """Returns the dimensions of the image data and the flat array
+    (of shape (N,) for scalars, (N, 3) for vectors) giving the values
+    of the numpy array `arr` in the VTK point order (x varies
+    fastest).
+
+    With `transpose`, the first axis of `arr` is x, like for
+    `ArraySource`.  Fortran ordered scalars are then used without a
+    copy but C ordered arrays are copied.  Without `transpose`, C
+    ordered arrays are used without a copy and their last axis (before
+    the vector components) is x.
+    """
+    vector = is_vector_array(arr)
+    shape = arr.shape[:-1] if vector else arr.shape
+    if not arr.dtype.isnative:
+        arr = arr.astype(arr.dtype.newbyteorder('='))
+    if arr.dtype.kind == 'b':
+        # VTK has no bool arrays, masks are shown as 0 and 1.
+        arr = arr.view(numpy.uint8)
+    if vector:
+        if transpose:
+            axes = range(arr.ndim - 1)[::-1] + [arr.ndim - 1]
+            arr = numpy.transpose(arr, axes)
+        else:
+            shape = shape[::-1]
+        # A view for C contiguous arrays.
+        flat = numpy.reshape(arr, (-1, 3))
+    elif transpose:
+        # A view for Fortran contiguous arrays.
+        flat = numpy.ravel(arr, order='F')
+    else:
+        shape = shape[::-1]
+        flat = numpy.ravel(arr)
+    dims = tuple(shape) + (1,)*(3 - len(shape))
+    return dims, flat
+
+
+######################################################################
+# `NumpyFileReader` class
+######################################################################
+class NumpyFileReader(FileDataSource):
+
+    """A reader for NumPy .npy and .npz files.  The arrays are shown
+    as point data on ImageData.  Arrays with a last axis of size 3
+    (and 4 dimensions) are vectors.  This reader also supports a time
+    series.
+    """
+
+    # The version of this class.  Used for persistence.
+    __version__ = 0
+
+    # The active scalar array.
+    scalars_name = DEnum(values_name='_scalars_list',
+                         desc='scalar array to use')
+
+    # The active vector array.
+    vectors_name = DEnum(values_name='_vectors_list',
+                         desc='vector array to use')
+
+    # Memory-map the arrays rather than reading them.
+    use_mmap = Bool(True, desc='if the arrays are memory-mapped')
+
+    # Use the first axis of the arrays as x, like `ArraySource`.  C
+    # ordered arrays are then copied, so that their pages are all
+    # read.  When this is off, C ordered arrays are shown without a
+    # copy with their axes in reverse order.
+    transpose_input_array = Bool(True,
+                        desc='if the first axis of the arrays is x')
+
+    # The spacing of the points.
+    spacing = Array(value=(1.0, 1.0, 1.0),
+                    shape=(3,),
+                    cols=1,
+                    dtype=float,
+                    enter_set=True,
+                    auto_set=False,
+                    labels=['sx', 'sy', 'sz'],
+                    desc='the spacing of the points')
+
+    # The origin of the points.
+    origin = Array(value=(0.0, 0.0, 0.0),
+                   shape=(3,),
+                   cols=1,
+                   dtype=float,
+                   enter_set=True,
+                   auto_set=False,
+                   labels=['x', 'y', 'z'],
+                   desc='the origin of the points')
+
+    # The image data holding the arrays.
+    image_data = Instance(tvtk.ImageData, (), allow_none=False)
+
+    # Information about what this object can produce.
+    output_info = PipelineInfo(datasets=['image_data'],
+                               attribute_types=['any'],
+                               attributes=['any'])
+
+    # Our view.
+    view = View(Group(Include('time_step_group'),
+                      Item(name='base_file_name'),
+                      Item(name='scalars_name'),
+                      Item(name='vectors_name'),
+                      Item(name='use_mmap'),
+                      Item(name='transpose_input_array'),
+                      Item(name='spacing'),
+                      Item(name='origin')),
+                resizable=True)
+
+    ########################################
+    # Private traits.
+
+    # The names of the scalar and vector arrays of the file.
+    _scalars_list = List(Str)
+    _vectors_list = List(Str)
+
+    ######################################################################
+    # `object` interface
+    ######################################################################
+    def __get_pure_state__(self):
+        d = super(NumpyFileReader, self).__get_pure_state__()
+        # The arrays are read from the file.
+        for name in ('image_data', '_scalars_list', '_vectors_list'):
+            d.pop(name, None)
+        return d
+
+    ######################################################################
+    # `FileDataSource` interface
+    ######################################################################
+    def update(self):
+        if len(self.file_path.get()) == 0:
+            return
+        self._file_path_changed(self.file_path)
+        self.render()
+
+    ######################################################################
+    # Non-public interface
+    ######################################################################
+    def _file_path_changed(self, fpath):
+        value = fpath.get()
+        if len(value) == 0:
+            return
+        self._load_file(value.strip())
+        # Change our name on the tree view
+        self.name = self._get_name()
+
+    def _load_file(self, file_name):
+        mmap_mode = 'c' if self.use_mmap else None
+        arrays = load_arrays(file_name, mmap_mode)
+
+        # The arrays of the image are replaced, so that the pipeline
+        # is not set up again at each time step.
+        img = self.image_data
+        pd = tvtk.to_vtk(img.point_data)
+        pd.Initialize()
+        dims = None
+        scalars, vectors = [], []
+        for name, arr in arrays:
+            if arr.ndim == 0 or arr.ndim > 4 or \
+                   arr.dtype.kind not in 'biuf':
+                continue
+            d, flat = image_layout(arr, self.transpose_input_array)
+            if dims is None:
+                dims = d
+            elif d != dims:
+                # Not on the same grid as the first array.
+                continue
+            vtk_arr = array_handler.array2vtk(flat)
+            vtk_arr.SetName(name)
+            pd.AddArray(vtk_arr)
+            if is_vector_array(arr):
+                vectors.append(name)
+            else:
+                scalars.append(name)
+
+        if dims is None:
+            dims = (1, 1, 1)
+        img.origin = tuple(self.origin)
+        img.spacing = tuple(self.spacing)
+        img.dimensions = dims
+        img.extent = 0, dims[0]-1, 0, dims[1]-1, 0, dims[2]-1
+
+        # Keep the active arrays of the previous time step.
+        old_scalars, old_vectors = self.scalars_name, self.vectors_name
+        self._scalars_list = scalars
+        self._vectors_list = vectors
+        if old_scalars in scalars:
+            self._scalars_name_changed(old_scalars)
+        elif len(scalars) > 0:
+            self.scalars_name = scalars[0]
+        if old_vectors in vectors:
+            self._vectors_name_changed(old_vectors)
+        elif len(vectors) > 0:
+            self.vectors_name = vectors[0]
+
+        if len(self.outputs) == 0:
+            self.outputs = [img]
+        else:
+            img.modified()
+        self.data_changed = True
+
+    def _scalars_name_changed(self, value):
+        img = self.image_data
+        if len(value) == 0 or value not in self._scalars_list:
+            return
+        img.point_data.set_active_scalars(value)
+        # This is very important and if not done can lead to a segfault!
+        arr = img.point_data.scalars
+        img.scalar_type = arr.data_type
+        img.number_of_scalar_components = arr.number_of_components
+        img.point_data.update()
+        self.data_changed = True
+
+    def _vectors_name_changed(self, value):
+        if len(value) == 0 or value not in self._vectors_list:
+            return
+        self.image_data.point_data.set_active_vectors(value)
+        self.image_data.point_data.update()
+        self.data_changed = True
+
+    def _spacing_changed(self, value):
+        self.image_data.spacing = tuple(value)
+        self.data_changed = True
+
+    def _origin_changed(self, value):
+        self.image_data.origin = tuple(value)
+        self.data_changed = True
+
+    def _use_mmap_changed(self):
+        self.update()
+
+    def _transpose_input_array_changed(self):
+        self.update()
+
+    def _get_name(self):
+        """ Returns the name to display on the tree view.  Note that
+        this is not a property getter.
+        """
+        fname = basename(self.file_path.get())
+        ret = "%s"%fname
+        if len(self.file_list) > 1:
+            ret += " (timeseries)"
+        if '[Hidden]' in self.name:
+            ret += ' [Hidden]'
+        return ret
@@ -0,0 +1,391 @@
+"""Reading the pieces of parallel VTK XML files concurrently.
+
+The .pvti, .pvtp, .pvtr, .pvts and .pvtu files list the files of the
+pieces of a dataset.  `PieceLoader` reads these pieces on a pool of
+worker threads, each with its own VTK reader, optionally only the
+pieces intersecting a bounding box, and merges them into one dataset.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+from os.path import dirname, join, isabs
+import threading
+from xml.etree import ElementTree
+
+import numpy
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from tvtk import array_handler
+
+# Local imports.
+from mayavi.core.common import parallel_map
+
+
+# The VTK readers of the pieces of each type of parallel file.
+PIECE_READERS = {'PImageData': 'XMLImageDataReader',
+                 'PPolyData': 'XMLPolyDataReader',
+                 'PRectilinearGrid': 'XMLRectilinearGridReader',
+                 'PStructuredGrid': 'XMLStructuredGridReader',
+                 'PUnstructuredGrid': 'XMLUnstructuredGridReader'}
+
+# The bounds of the pieces read so far, keyed on the name, size and
+# modification time of their file.
+_bounds_cache = {}
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def is_parallel_file(file_name):
+    """True if the file name has the extension of a parallel VTK XML
+    file."""
+    ext = os.path.splitext(file_name)[1].lower()
+    return ext in ('.pvti', '.pvtp', '.pvtr', '.pvts', '.pvtu')
+
+
+def _floats(text, default):
+    if text is None:
+        return default
+    return tuple(float(x) for x in text.split())
+
+
+def read_parallel_header(file_name):
+    """Parses the parallel VTK XML file and returns a dict with its
+    'type' (e.g. 'PUnstructuredGrid'), the 'origin' and 'spacing' of
+    image data and the 'pieces', a list of (file name, extent) where
+    the extent is None for unstructured data."""
+    root = ElementTree.parse(file_name).getroot()
+    data_type = root.get('type')
+    if data_type not in PIECE_READERS:
+        raise ValueError('%s is not a parallel VTK XML file.'%file_name)
+    elem = root.find(data_type)
+    base = dirname(file_name)
+    pieces = []
+    for piece in elem.findall('Piece'):
+        source = piece.get('Source')
+        if not isabs(source):
+            source = join(base, source)
+        extent = piece.get('Extent')
+        if extent is not None:
+            extent = tuple(int(x) for x in extent.split())
+        pieces.append((source, extent))
+    return {'type': data_type,
+            'origin': _floats(elem.get('Origin'), (0.0, 0.0, 0.0)),
+            'spacing': _floats(elem.get('Spacing'), (1.0, 1.0, 1.0)),
+            'pieces': pieces}
+
+
+def extent_bounds(extent, origin, spacing):
+    """Returns the bounds of the image data extent."""
+    b = []
+    for i in range(3):
+        b.extend([origin[i] + extent[2*i]*spacing[i],
+                  origin[i] + extent[2*i + 1]*spacing[i]])
+    return tuple(b)
+
+
+def bounds_intersect(a, b):
+    """True if the bounds `a` and `b` overlap."""
+    for i in range(3):
+        if a[2*i] > b[2*i + 1] or b[2*i] > a[2*i + 1]:
+            return False
+    return True
+
+
+def read_piece(reader, file_name, arrays=True):
+    """Reads the piece with the given VTK reader and returns a copy of
+    the output detached from the reader.  Without `arrays` only the
+    geometry is read."""
+    reader.SetFileName(file_name)
+    reader.UpdateInformation()
+    selections = (reader.GetPointDataArraySelection(),
+                  reader.GetCellDataArraySelection())
+    for s in selections:
+        if arrays:
+            s.EnableAllArrays()
+        else:
+            s.DisableAllArrays()
+    reader.Update()
+    output = reader.GetOutput()
+    data = output.NewInstance()
+    data.ShallowCopy(output)
+    return data
+
+
+def _file_key(file_name):
+    st = os.stat(file_name)
+    return file_name, st.st_size, st.st_mtime
+
+
+######################################################################
+# Merging the pieces.
+######################################################################
+def _union_extent(extents):
+    ext = list(extents[0])
+    for e in extents[1:]:
+        for i in range(3):
+            ext[2*i] = min(ext[2*i], e[2*i])
+            ext[2*i + 1] = max(ext[2*i + 1], e[2*i + 1])
+    return tuple(ext)
+
+
+def _shape(extent, cells):
+    """The (z, y, x) shape of the points or cells of an extent."""
+    shape = [extent[2*i + 1] - extent[2*i] + 1 for i in (2, 1, 0)]
+    if cells:
+        shape = [max(n - 1, 1) for n in shape]
+    return shape
+
+
+def extents_tile(whole, extents):
+    """True if the extents cover every point of the extent `whole`."""
+    covered = numpy.zeros(_shape(whole, False), bool)
+    for e in extents:
+        s = [slice(max(e[2*i] - whole[2*i], 0),
+                   max(e[2*i + 1] - whole[2*i] + 1, 0))
+             for i in (2, 1, 0)]
+        covered[tuple(s)] = True
+    return bool(covered.all())
+
+
+def merge_array(arrays, whole, extents, cells=False):
+    """Returns the numpy array of the values of the VTK `arrays` of
+    the pieces with the given extents, placed in the extent `whole`.
+    Parts of `whole` not covered by a piece are zero, see
+    `extents_tile`."""
+    first = arrays[0]
+    n_comp = first.GetNumberOfComponents()
+    dtype = array_handler.get_numeric_array_type(first.GetDataType())
+    out = numpy.zeros(_shape(whole, cells) + [n_comp], dtype)
+    for arr, e in zip(arrays, extents):
+        values = array_handler.vtk2array(arr)
+        values = numpy.reshape(values, _shape(e, cells) + [n_comp])
+        s = [slice(e[2*i] - whole[2*i],
+                   e[2*i] - whole[2*i] + values.shape[2 - i])
+             for i in (2, 1, 0)]
+        out[tuple(s)] = values
+    if n_comp == 1:
+        return numpy.reshape(out, (-1,))
+    return numpy.reshape(out, (-1, n_comp))
+
+
+def merge_coordinates(arrays, whole, extents, axis):
+    """Returns the numpy array of the coordinates along `axis` (0, 1
+    or 2) of rectilinear grid pieces with the given extents, placed in
+    the extent `whole`."""
+    dtype = array_handler.get_numeric_array_type(arrays[0].GetDataType())
+    out = numpy.zeros(whole[2*axis + 1] - whole[2*axis] + 1, dtype)
+    for arr, e in zip(arrays, extents):
+        values = array_handler.vtk2array(arr)
+        start = e[2*axis] - whole[2*axis]
+        out[start:start + len(values)] = values
+    return out
+
+
+def _merge_data(src_list, dst, whole, extents, cells):
+    """Merges the arrays of the point (or cell) data of the pieces in
+    `src_list` into the data `dst`."""
+    first = src_list[0]
+    for a in range(first.GetNumberOfArrays()):
+        name = first.GetArrayName(a)
+        if name is None:
+            continue
+        arrays = [src.GetArray(name) for src in src_list]
+        if None in arrays:
+            # Only the arrays of every piece are kept.
+            continue
+        vtk_arr = array_handler.array2vtk(merge_array(arrays, whole,
+                                                      extents, cells))
+        vtk_arr.SetName(name)
+        dst.AddArray(vtk_arr)
+    # Keep the active attributes.
+    for attr in ('Scalars', 'Vectors', 'Tensors'):
+        active = getattr(first, 'Get' + attr)()
+        if active is not None and active.GetName() is not None:
+            getattr(dst, 'SetActive' + attr)(active.GetName())
+
+
+def merge_structured(datasets, extents):
+    """Merges structured pieces (image data, rectilinear or structured
+    grids) with the given extents into one dataset covering their union.  Raises a
+    ValueError if the pieces do not cover the union."""
+    whole = _union_extent(extents)
+    if not extents_tile(whole, extents):
+        raise ValueError('The pieces do not cover the extent %s.'%(whole,))
+    first = datasets[0]
+    out = first.NewInstance()
+    out.SetExtent(whole)
+    if first.IsA('vtkImageData'):
+        out.SetOrigin(first.GetOrigin())
+        out.SetSpacing(first.GetSpacing())
+    elif first.IsA('vtkRectilinearGrid'):
+        for axis, name in enumerate('XYZ'):
+            arrays = [getattr(d, 'Get%sCoordinates'%name)()
+                      for d in datasets]
+            coords = array_handler.array2vtk(
+                merge_coordinates(arrays, whole, extents, axis))
+            getattr(out, 'Set%sCoordinates'%name)(coords)
+    else:
+        tvtk.to_tvtk(out).points = merge_array(
+            [d.GetPoints().GetData() for d in datasets], whole, extents)
+    _merge_data([d.GetPointData() for d in datasets], out.GetPointData(),
+                whole, extents, False)
+    _merge_data([d.GetCellData() for d in datasets], out.GetCellData(),
+                whole, extents, True)
+    scalars = out.GetPointData().GetScalars()
+    if out.IsA('vtkImageData') and scalars is not None:
+        # This is very important and if not done can lead to a segfault!
+        out.SetScalarType(scalars.GetDataType())
+        out.SetNumberOfScalarComponents(scalars.GetNumberOfComponents())
+    return out
+
+
+def append_pieces(datasets):
+    """Appends the pieces into one poly data or unstructured grid."""
+    if datasets[0].IsA('vtkPolyData'):
+        f = tvtk.AppendPolyData()
+    else:
+        f = tvtk.AppendFilter()
+    f = tvtk.to_vtk(f)
+    for d in datasets:
+        f.AddInput(d)
+    f.Update()
+    output = f.GetOutput()
+    data = output.NewInstance()
+    data.ShallowCopy(output)
+    return data
+
+
+######################################################################
+# `PieceLoader` class.
+######################################################################
+class PieceLoader(object):
+    """Reads the pieces of a parallel VTK XML file on worker threads.
+
+    The VTK readers are created on the thread calling `load` or
+    `select`.  `cancel` may be called from any thread.
+    """
+
+    def __init__(self, file_name, n_threads=0):
+        self.file_name = file_name
+        self.header = read_parallel_header(file_name)
+        # The number of worker threads, all processors if zero.
+        self.n_threads = n_threads
+        # The number of pieces read by the last `load`.
+        self.n_done = 0
+        # The number of pieces selected by the last `load_selected`.
+        self.n_selected = 0
+        self._cancel = threading.Event()
+
+    def cancel(self):
+        """Stops the loading once the pieces being read are done."""
+        self._cancel.set()
+
+    def piece_bounds(self, index):
+        """Returns the bounds of a piece.  They are computed from the
+        extent of image data, other pieces are read without their
+        arrays the first time."""
+        source, extent = self.header['pieces'][index]
+        if self.header['type'] == 'PImageData' and extent is not None:
+            return extent_bounds(extent, self.header['origin'],
+                                 self.header['spacing'])
+        return self.all_bounds([index])[0]
+
+    def all_bounds(self, indices=None):
+        """Returns the bounds of the given pieces (all by default)."""
+        pieces = self.header['pieces']
+        if indices is None:
+            indices = range(len(pieces))
+        if self.header['type'] == 'PImageData':
+            return [self.piece_bounds(i) for i in indices]
+        keys = [_file_key(pieces[i][0]) for i in indices]
+        missing = [i for i, k in zip(indices, keys)
+                   if k not in _bounds_cache]
+        if len(missing) > 0:
+            outputs = self._read(missing, arrays=False)
+            if outputs is None:
+                return None
+            for i, data in zip(missing, outputs):
+                _bounds_cache[_file_key(pieces[i][0])] = data.GetBounds()
+        return [_bounds_cache[k] for k in keys]
+
+    def select(self, bounds=None):
+        """Returns the indices of the pieces intersecting `bounds`, all
+        of them if `bounds` is None."""
+        n = len(self.header['pieces'])
+        if bounds is None:
+            return range(n)
+        all_bounds = self.all_bounds()
+        if all_bounds is None:
+            return []
+        return [i for i, b in enumerate(all_bounds)
+                if bounds_intersect(b, bounds)]
+
+    def load_selected(self, bounds=None, merge='append', progress=None):
+        """Reads the pieces intersecting `bounds` (all of them if None),
+        see `select` and `load`.  Raises a ValueError if no piece is in
+        the bounds."""
+        indices = self.select(bounds)
+        if len(indices) == 0:
+            raise ValueError('No piece of %s is in the bounds.'
+                             %self.file_name)
+        self.n_selected = len(indices)
+        return self.load(indices, merge, progress)
+
+    def load(self, indices=None, merge='append', progress=None,
+             interval=0.1):
+        """Reads the given pieces (all by default) and returns the list
+        of VTK datasets, a single merged dataset with `merge='append'`
+        or one per piece with `merge='pieces'`.  Structured pieces that
+        do not cover the union of their extents (a selection with
+        holes) are not merged, one dataset per piece is returned.  None
+        is returned if the loading was cancelled.
+
+        `progress(fraction)` is called on the calling thread every
+        `interval` seconds, returning False from it cancels the
+        loading.
+        """
+        if indices is None:
+            indices = range(len(self.header['pieces']))
+        if len(indices) == 0:
+            raise ValueError('No pieces to load.')
+        outputs = self._read(indices, True, progress, interval)
+        if outputs is None:
+            return None
+        if merge == 'pieces' or len(outputs) == 1:
+            return outputs
+        extents = [self.header['pieces'][i][1] for i in indices]
+        if self.header['type'] in ('PImageData', 'PRectilinearGrid',
+                                   'PStructuredGrid'):
+            if None not in extents and \
+                   extents_tile(_union_extent(extents), extents):
+                return [merge_structured(outputs, extents)]
+            # Appending would turn the pieces into an unstructured grid.
+            return outputs
+        return [append_pieces(outputs)]
+
+    ######################################################################
+    # Non-public interface
+    ######################################################################
+    def _read(self, indices, arrays=True, progress=None, interval=0.1):
+        pieces = self.header['pieces']
+        n = len(indices)
+        cls_name = PIECE_READERS[self.header['type']]
+
+        def _new_reader():
+            return tvtk.to_vtk(getattr(tvtk, cls_name)())
+
+        def _read(reader, index):
+            return read_piece(reader, pieces[index][0], arrays)
+
+        def _progress(fraction):
+            self.n_done = int(round(fraction*n))
+            if progress is not None:
+                return progress(fraction)
+
+        self.n_done = 0
+        return parallel_map(_read, indices, self.n_threads, _new_reader,
+                            self._cancel, _progress, interval)
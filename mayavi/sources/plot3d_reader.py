@@ -11,7 +11,8 @@ files.
 from os.path import basename, isfile, exists, splitext
 
 # Enthought library imports.
-from traits.api import Trait, Instance, Str, TraitPrefixMap, Button
+from traits.api import Trait, Instance, Str, TraitPrefixMap, Button, \
+     Bool
 from traitsui.api import View, Group, Item, FileEditor
 from tvtk.api import tvtk
 from apptools.persistence.state_pickler import set_state
@@ -21,6 +22,7 @@ from apptools.persistence.file_path import FilePath
 from mayavi.core.source import Source
 from mayavi.core.common import handle_children_state, error
 from mayavi.core.pipeline_info import PipelineInfo
+from mayavi.sources.fast_plot3d_reader import FastPLOT3DReader
 
 
 ########################################################################
@@ -66,6 +68,13 @@ class PLOT3DReader(Source):
     reader = Instance(tvtk.PLOT3DReader, args=(), allow_none=False,
                       record=True)
 
+    # Read binary files with the memory-mapped reader rather than with
+    # the VTK reader.  Its blocks are read in parallel and changing the
+    # scalars or vectors does not read the files again.  Files it does
+    # not recognize are read by the VTK reader.
+    use_fast_reader = Bool(False,
+                           desc='if the fast reader is used when possible')
+
     # Information about what this object can produce.
     output_info = PipelineInfo(datasets=['structured_grid'])
 
@@ -81,6 +90,7 @@ class PLOT3DReader(Source):
                            enabled_when='len(object.q_file_name) > 0'),
                       Item(name='vectors_name',
                            enabled_when='len(object.q_file_name)>0'),
+                      Item(name='use_fast_reader'),
                       Item(name='update_reader'),
                       label='Reader',
                       ),
@@ -99,6 +109,10 @@ class PLOT3DReader(Source):
     xyz_file_path = Instance(FilePath, args=(), desc='the current XYZ file path')
     q_file_path = Instance(FilePath, args=(), desc='the current Q file path')
 
+    # The fast reader and whether it produced the current outputs.
+    _fast_reader = Instance(FastPLOT3DReader, ())
+    _using_fast_reader = Bool(False)
+
     ######################################################################
     # `object` interface
     ######################################################################
@@ -106,7 +120,7 @@ class PLOT3DReader(Source):
         d = super(PLOT3DReader, self).__get_pure_state__()
         # These traits are dynamically created.
         for name in ('scalars_name', 'vectors_name', 'xyz_file_name',
-                     'q_file_name'):
+                     'q_file_name', '_fast_reader', '_using_fast_reader'):
             d.pop(name, None)
 
         return d
@@ -121,6 +135,8 @@ class PLOT3DReader(Source):
 
         # Setup the reader state.
         set_state(self, state, first=['reader'], ignore=['*'])
+        # Pick the same kind of reader before the files are read.
+        self.use_fast_reader = getattr(state, 'use_fast_reader', False)
         # Initialize the files.
         self.initialize(xyz_fn, q_fn, configure=False)
         # Now set the remaining state without touching the children.
@@ -161,7 +177,11 @@ class PLOT3DReader(Source):
     def update(self):
         if len(self.xyz_file_path.get()) == 0:
             return
-        self.reader.update()
+        if self._using_fast_reader:
+            self._fast_reader.update()
+            self.data_changed = True
+        else:
+            self.reader.update()
         self.render()
 
 
@@ -185,6 +205,10 @@ class PLOT3DReader(Source):
             self._update_reader_output()
 
     def _update_reader_output(self):
+        if self.use_fast_reader and self._update_fast_reader_output():
+            return
+        self._using_fast_reader = False
+
         r = self.reader
         r.update()
 
@@ -252,18 +276,55 @@ class PLOT3DReader(Source):
         # Change our name on the tree view
         self.name = self._get_name()
 
+    def _update_fast_reader_output(self):
+        """Reads the files with the fast reader.  Returns False if the
+        files are not in a format it reads."""
+        fr = self._fast_reader
+        if len(self.xyz_file_name) == 0:
+            return False
+        fr.set(xyz_file_name=self.xyz_file_name,
+               q_file_name=self.q_file_name,
+               scalar_function_number=self.scalars_name_,
+               vector_function_number=self.vectors_name_)
+        try:
+            fr.update()
+        except ValueError:
+            return False
+        self._using_fast_reader = True
+        self.outputs = list(fr.outputs)
+        self.data_changed = True
+        self.name = self._get_name()
+        return True
+
     def _scalars_name_changed(self, value):
+        if self._using_fast_reader:
+            # Only the function is computed again.
+            self._fast_reader.scalar_function_number = self.scalars_name_
+            self._fast_reader.update_functions()
+            self.data_changed = True
+            self.render()
+            return
         self.reader.scalar_function_number = self.scalars_name_
         self.reader.modified()
         self.update()
         self.data_changed = True
 
     def _vectors_name_changed(self, value):
+        if self._using_fast_reader:
+            self._fast_reader.vector_function_number = self.vectors_name_
+            self._fast_reader.update_functions()
+            self.data_changed = True
+            self.render()
+            return
         self.reader.vector_function_number = self.vectors_name_
         self.reader.modified()
         self.update()
         self.data_changed = True
 
+    def _use_fast_reader_changed(self):
+        if len(self.xyz_file_name) > 0:
+            self._update_reader_output()
+
     def _update_reader_fired(self):
         self.reader.modified()
         self._update_reader_output()
@@ -9,7 +9,7 @@
 from os.path import basename
 
 # Enthought imports.
-from traits.api import Instance, Str,Dict
+from traits.api import Instance, Str, Dict, Bool, HasTraits
 from traitsui.api import View, Item, Group, Include
 from tvtk.api import tvtk
 
@@ -17,6 +17,25 @@ from tvtk.api import tvtk
 from mayavi.core.file_data_source import FileDataSource
 from mayavi.core.pipeline_info import PipelineInfo
 from mayavi.core.common import error
+from mayavi.sources.fast_mesh_reader import FastMeshReader
+
+# The names of the tvtk reader classes used for each file extension.
+# The readers are only created when a file with that extension is read.
+READER_CLASSES = {'stl': 'STLReader',
+                  'stla': 'STLReader',
+                  'stlb': 'STLReader',
+                  'txt': 'SimplePointsReader',
+                  'raw': 'ParticleReader',
+                  'ply': 'PLYReader',
+                  'pdb': 'PDBReader',
+                  'slc': 'SLCReader',
+                  'xyz': 'XYZMolReader',
+                  'obj': 'OBJReader',
+                  'facet': 'FacetReader',
+                  'cube': 'GaussianCubeReader',
+                  'g': 'BYUReader',
+                 }
+
 
 ########################################################################
 # `PolyDataReader` class
@@ -30,17 +49,30 @@ class PolyDataReader(FileDataSource):
     # The version of this class.  Used for persistence.
     __version__ = 0
 
-    # The PolyData file reader
-    reader = Instance(tvtk.Object, allow_none=False,
+    # The PolyData file reader.  This is a VTK reader or a
+    # `FastMeshReader`.
+    reader = Instance(HasTraits, allow_none=False,
                       record=True)
 
+    # Read OBJ, STL, PLY and TXT files with the fast built-in parsers
+    # rather than with the VTK readers.  This is much faster for large
+    # files but only the points and the cells are read.
+    use_fast_parsers = Bool(False,
+                            desc='if the fast parsers are used when possible')
+
     ######################################################################
     # Private Traits
+
+    # The readers created so far, by extension.
     _reader_dict = Dict(Str, Instance(tvtk.Object))
 
+    # The reader using the fast parsers.
+    _fast_reader = Instance(FastMeshReader, ())
+
     # Our View.
     view = View(Group(Include('time_step_group'),
                       Item(name='base_file_name'),
+                      Item(name='use_fast_parsers'),
                       Item(name='reader',
                            style='custom',
                            resizable=True),
@@ -59,6 +91,8 @@ class PolyDataReader(FileDataSource):
     def __set_pure_state__(self, state):
         # The reader has its own file_name which needs to be fixed.
         state.reader.file_name = state.file_path.abs_pth
+        # Pick the same kind of reader before the file is read.
+        self.use_fast_parsers = getattr(state, 'use_fast_parsers', False)
         # Now call the parent class to setup everything.
         super(PolyDataReader, self).__set_pure_state__(state)
 
@@ -84,8 +118,10 @@ class PolyDataReader(FileDataSource):
         extension = splitname[-1].lower()
         # Select polydata reader based on file type
         old_reader = self.reader
-        if self._reader_dict.has_key(extension):
-            self.reader = self._reader_dict[extension]
+        if self.use_fast_parsers and FastMeshReader.can_parse(value):
+            self.reader = self._fast_reader
+        elif extension in READER_CLASSES:
+            self.reader = self._get_reader(extension)
         else:
             error('Invalid extension for file: %s'%value)
             return
@@ -106,6 +142,10 @@ class PolyDataReader(FileDataSource):
         # Change our name on the tree view
         self.name = self._get_name()
 
+    def _use_fast_parsers_changed(self):
+        if len(self.file_path.get()) > 0:
+            self._file_path_changed(self.file_path)
+
     def _get_name(self):
         """ Returns the name to display on the tree view.  Note that
         this is not a property getter.
@@ -119,23 +159,14 @@ class PolyDataReader(FileDataSource):
 
         return ret
 
-    def __reader_dict_default(self):
-        """Default value for reader dict."""
-        rd = {'stl':tvtk.STLReader(),
-             'stla':tvtk.STLReader(),
-             'stlb':tvtk.STLReader(),
-             'txt':tvtk.SimplePointsReader(),
-             'raw':tvtk.ParticleReader(),
-             'ply':tvtk.PLYReader(),
-             'pdb':tvtk.PDBReader(),
-             'slc':tvtk.SLCReader(),
-             'xyz':tvtk.XYZMolReader(),
-             'obj':tvtk.OBJReader(),
-             'facet':tvtk.FacetReader(),
-             'cube':tvtk.GaussianCubeReader(),
-             'g':tvtk.BYUReader(),
-            }
-        return rd
+    def _get_reader(self, extension):
+        """Returns the reader for the given extension, creating it on
+        first use."""
+        reader = self._reader_dict.get(extension)
+        if reader is None:
+            reader = getattr(tvtk, READER_CLASSES[extension])()
+            self._reader_dict[extension] = reader
+        return reader
 
     # Callable to check if the reader can actually read the file
     def can_read(cls,filename):
@@ -148,17 +179,20 @@ class PolyDataReader(FileDataSource):
         extension = splitname[-1].lower()
 
         if extension == 'xyz':
-            from vtk import vtkObject
+            # Use the VTK reader directly, a tvtk wrapper is not needed
+            # for this.
+            from vtk import vtkObject, vtkXYZMolReader
             o = vtkObject
             w = o.GetGlobalWarningDisplay()
             o.SetGlobalWarningDisplay(0) # Turn it off.
 
-            r = tvtk.XYZMolReader()
-            r.file_name = filename
-            r.update()
+            r = vtkXYZMolReader()
+            r.SetFileName(filename)
+            r.Update()
             o.SetGlobalWarningDisplay(w)
 
-            if len(r.output.points) != 0:
+            points = r.GetOutput().GetPoints()
+            if points is not None and points.GetNumberOfPoints() != 0:
                 return True
             return False
 
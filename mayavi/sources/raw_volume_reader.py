@@ -0,0 +1,267 @@
+"""A reader for raw volume files that memory-maps the file.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+from os.path import basename
+
+import numpy
+
+# Enthought library imports.
+from traits.api import Instance, Int, Enum, Array, Any, Bool, \
+     on_trait_change
+from traitsui.api import View, Group, Item, Include
+from tvtk.api import tvtk
+from tvtk import array_handler
+
+# Local imports.
+from mayavi.core.file_data_source import FileDataSource
+from mayavi.core.pipeline_info import PipelineInfo
+from mayavi.core.common import error
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def map_raw_volume(file_name, dimensions, data_type, byte_order='little',
+                   header_size=0):
+    """Memory-maps the raw volume in `file_name` and returns it as a
+    flat array in the VTK point order (x varies fastest).  The mapping
+    is copy-on-write, as VTK may write into the arrays it is given, and
+    the file is never changed.  The byte order of the array is that of
+    the file.  Raises a ValueError if the file is too small.
+    """
+    order = {'little': '<', 'big': '>'}[byte_order]
+    dtype = numpy.dtype(data_type).newbyteorder(order)
+    n = int(numpy.prod(dimensions))
+    size = os.path.getsize(file_name)
+    if header_size + n*dtype.itemsize > size:
+        raise ValueError('The file %s has %d bytes, %d are needed.'
+                         %(file_name, size, header_size + n*dtype.itemsize))
+    if n == 0:
+        return numpy.empty(0, dtype)
+    return numpy.memmap(file_name, dtype=dtype, mode='c',
+                        offset=header_size, shape=(n,))
+
+
+def to_native(arr, out=None):
+    """Returns `arr` with the native byte order.  `arr` itself is
+    returned if it already has it, otherwise the values are swapped
+    into `out` (allocated if None)."""
+    if arr.dtype.isnative:
+        return arr
+    if out is None:
+        out = numpy.empty(arr.shape, arr.dtype.newbyteorder('='))
+    out[...] = arr
+    return out
+
+
+######################################################################
+# `RawVolumeReader` class
+######################################################################
+class RawVolumeReader(FileDataSource):
+
+    """A reader for volumes stored as raw binary values, optionally
+    after a header.  The file is memory-mapped and its values are used
+    by VTK without a copy, so that only the parts of the volume used
+    are read.  Files whose byte order is not the native one are swapped
+    once into a buffer kept while the same file is shown.  This reader
+    also supports a time series.
+    """
+
+    # The version of this class.  Used for persistence.
+    __version__ = 0
+
+    # The number of points along x, y and z.
+    dimensions = Array(value=(1, 1, 1),
+                       shape=(3,),
+                       cols=1,
+                       dtype=int,
+                       enter_set=True,
+                       auto_set=False,
+                       labels=['nx', 'ny', 'nz'],
+                       desc='the dimensions of the volume')
+
+    # The type of the values.
+    data_type = Enum('uint8', 'int8', 'uint16', 'int16', 'uint32',
+                     'int32', 'float32', 'float64',
+                     desc='the type of the values')
+
+    # The byte order of the values in the file.
+    byte_order = Enum('little', 'big',
+                      desc='the byte order of the values')
+
+    # The number of bytes before the values.
+    header_size = Int(0, desc='the number of bytes before the values')
+
+    # The spacing of the points.
+    spacing = Array(value=(1.0, 1.0, 1.0),
+                    shape=(3,),
+                    cols=1,
+                    dtype=float,
+                    enter_set=True,
+                    auto_set=False,
+                    labels=['sx', 'sy', 'sz'],
+                    desc='the spacing of the points')
+
+    # The origin of the points.
+    origin = Array(value=(0.0, 0.0, 0.0),
+                   shape=(3,),
+                   cols=1,
+                   dtype=float,
+                   enter_set=True,
+                   auto_set=False,
+                   labels=['x', 'y', 'z'],
+                   desc='the origin of the points')
+
+    # The image data showing the volume.
+    image_data = Instance(tvtk.ImageData, (), allow_none=False)
+
+    # Information about what this object can produce.
+    output_info = PipelineInfo(datasets=['image_data'],
+                               attribute_types=['any'],
+                               attributes=['scalars'])
+
+    # Our view.
+    view = View(Group(Include('time_step_group'),
+                      Item(name='base_file_name'),
+                      Item(name='dimensions'),
+                      Item(name='data_type'),
+                      Item(name='byte_order'),
+                      Item(name='header_size'),
+                      Item(name='spacing'),
+                      Item(name='origin')),
+                resizable=True)
+
+    ########################################
+    # Private traits.
+
+    # The key of the file whose values were byte swapped and the
+    # swapped values.
+    _swapped_key = Any
+    _swapped = Any
+
+    # Set by `set` so the file is read once after all the parameters
+    # changed.
+    _disable_update = Bool(False)
+
+    ######################################################################
+    # `object` interface
+    ######################################################################
+    def __init__(self, configure=False, **traits):
+        super(RawVolumeReader, self).__init__(**traits)
+        if configure:
+            self.edit_traits(kind='livemodal')
+
+    def __get_pure_state__(self):
+        d = super(RawVolumeReader, self).__get_pure_state__()
+        # The data is read from the file.
+        for name in ('image_data', '_swapped_key', '_swapped',
+                     '_disable_update'):
+            d.pop(name, None)
+        return d
+
+    def set(self, trait_change_notify=True, **traits):
+        """Sets the given traits and reads the file once, so that the
+        parameters may be changed together without going through a
+        combination that does not fit the file.
+        """
+        try:
+            self._disable_update = True
+            super(RawVolumeReader, self).set(trait_change_notify, **traits)
+        finally:
+            self._disable_update = False
+        if trait_change_notify and self._parameters_set(traits):
+            self.update()
+        return self
+
+    ######################################################################
+    # `FileDataSource` interface
+    ######################################################################
+    def update(self):
+        if len(self.file_path.get()) == 0:
+            return
+        self._load_file(self.file_path.get().strip())
+        self.render()
+
+    ######################################################################
+    # Non-public interface
+    ######################################################################
+    def _file_path_changed(self, fpath):
+        value = fpath.get()
+        if len(value) == 0:
+            return
+        self._load_file(value.strip())
+        # Change our name on the tree view
+        self.name = self._get_name()
+
+    def _load_file(self, file_name):
+        dims = tuple(int(x) for x in self.dimensions)
+        try:
+            values = map_raw_volume(file_name, dims, self.data_type,
+                                    self.byte_order, self.header_size)
+        except (ValueError, IOError, OSError), e:
+            error(str(e))
+            return
+        if not values.dtype.isnative:
+            st = os.stat(file_name)
+            key = (file_name, st.st_mtime, st.st_size, dims,
+                   self.data_type, self.byte_order, self.header_size)
+            if key != self._swapped_key:
+                # Reuse the buffer of the previous file if possible.
+                out = self._swapped
+                if out is None or out.shape != values.shape or \
+                       out.dtype != values.dtype.newbyteorder('='):
+                    out = None
+                self._swapped = to_native(values, out)
+                self._swapped_key = key
+            values = self._swapped
+        else:
+            self._swapped = self._swapped_key = None
+
+        img = self.image_data
+        img.point_data.scalars = values
+        img.point_data.scalars.name = 'scalars'
+        img.origin = tuple(self.origin)
+        img.spacing = tuple(self.spacing)
+        img.dimensions = dims
+        img.extent = 0, dims[0]-1, 0, dims[1]-1, 0, dims[2]-1
+        # This is very important and if not done can lead to a segfault!
+        img.scalar_type = array_handler.get_vtk_array_type(values.dtype)
+        img.update()
+        if len(self.outputs) == 0:
+            self.outputs = [img]
+        else:
+            self.data_changed = True
+
+    def _parameters_set(self, traits):
+        return len(set(traits).intersection(('dimensions', 'data_type',
+                                             'byte_order',
+                                             'header_size'))) > 0
+
+    @on_trait_change('dimensions, data_type, byte_order, header_size')
+    def _parameters_changed(self):
+        if not self._disable_update:
+            self.update()
+
+    def _spacing_changed(self, value):
+        self.image_data.spacing = tuple(value)
+        self.data_changed = True
+
+    def _origin_changed(self, value):
+        self.image_data.origin = tuple(value)
+        self.data_changed = True
+
+    def _get_name(self):
+        """ Returns the name to display on the tree view.  Note that
+        this is not a property getter.
+        """
+        fname = basename(self.file_path.get())
+        ret = "%s"%fname
+        if len(self.file_list) > 1:
+            ret += " (timeseries)"
+        if '[Hidden]' in self.name:
+            ret += ' [Hidden]'
+        return ret
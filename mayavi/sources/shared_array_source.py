@@ -0,0 +1,147 @@
+"""An array source showing the frames another process writes in shared
+memory.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Enthought library imports.
+from pyface.timer.api import Timer
+from traits.api import Str, Bool, Int, Range, Any
+from traitsui.api import View, Group, Item
+
+# Local imports.
+from mayavi.sources.array_source import ArraySource
+from mayavi.tools.shared_array import SharedArrayReader
+from mayavi.core.common import error
+
+
+######################################################################
+# `SharedArraySource` class.
+######################################################################
+class SharedArraySource(ArraySource):
+
+    """An `ArraySource` showing the latest frame written by a
+    `mayavi.tools.shared_array.SharedArrayWriter`, typically in another
+    process.  The frames are laid out as VTK wants them, so VTK uses the
+    shared memory without a copy.  New frames are shown by `poll` or,
+    when `live` is True, every `poll_interval` milliseconds.
+    """
+
+    # The version of this class.  Used for persistence.
+    __version__ = 0
+
+    # The name of the shared memory segment.
+    segment = Str(desc='the name of the shared memory segment')
+
+    # The number of the frame shown, 0 if none.
+    seq = Int(0, desc='the number of the frame shown')
+
+    # Poll the segment for new frames.
+    live = Bool(False, desc='if new frames are shown as they come')
+
+    # The polling interval in milliseconds.
+    poll_interval = Range(10, 10000, 100,
+                          desc='the polling interval in milliseconds')
+
+    # Our view.
+    view = View(Group(Item(name='segment'),
+                      Item(name='live'),
+                      Item(name='poll_interval', enabled_when='live'),
+                      Item(name='seq', style='readonly'),
+                      Item(name='scalar_name'),
+                      Item(name='vector_name'),
+                      Item(name='spacing'),
+                      Item(name='origin'),
+                      show_labels=True)
+                )
+
+    ######################################################################
+    # Private traits.
+
+    # The mapping of the segment.
+    _reader = Any
+
+    # The timer polling the segment.
+    _timer = Any
+
+    ######################################################################
+    # `object` interface.
+    ######################################################################
+    def __init__(self, **traits):
+        # The segment is mapped once the array source is set up.
+        segment = traits.pop('segment', '')
+        super(SharedArraySource, self).__init__(**traits)
+        self.segment = segment
+
+    def __get_pure_state__(self):
+        d = super(SharedArraySource, self).__get_pure_state__()
+        # The frames are in the segment.
+        for name in ('scalar_data', 'vector_data', 'seq', '_reader',
+                     '_timer'):
+            d.pop(name, None)
+        return d
+
+    ######################################################################
+    # `Base` interface.
+    ######################################################################
+    def start(self):
+        if self.running:
+            return
+        super(SharedArraySource, self).start()
+        self._live_changed(self.live)
+
+    def stop(self):
+        if self._timer is not None:
+            self._timer.Stop()
+        super(SharedArraySource, self).stop()
+
+    ######################################################################
+    # `SharedArraySource` interface.
+    ######################################################################
+    def poll(self):
+        """Shows the latest frame of the segment if it is not shown
+        yet.  Returns True if a new frame is shown."""
+        reader = self._reader
+        if reader is None or reader.seq in (0, self.seq):
+            return False
+        seq, arr = reader.acquire()
+        if reader.n_components == 1:
+            self.scalar_data = arr
+        else:
+            self.vector_data = arr
+        self.seq = seq
+        return True
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def _segment_changed(self, value):
+        old = self._reader
+        self._reader = None
+        if old is not None:
+            old.release()
+            self.scalar_data = self.vector_data = None
+        self.seq = 0
+        if len(value) == 0:
+            return
+        try:
+            self._reader = SharedArrayReader(value)
+        except (IOError, ValueError), e:
+            error(str(e))
+            return
+        self.name = 'SharedArray(%s)'%value
+        self.poll()
+
+    def _live_changed(self, value):
+        timer = self._timer
+        if timer is not None and timer.IsRunning():
+            timer.Stop()
+        if not value or not self.running:
+            return
+        if timer is None:
+            self._timer = Timer(self.poll_interval, self.poll)
+        else:
+            timer.Start(self.poll_interval)
+
+    def _poll_interval_changed(self, value):
+        self._live_changed(self.live)
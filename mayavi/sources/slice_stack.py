@@ -0,0 +1,136 @@
+"""Loading a stack of 2D image files as a volume.
+
+The slices are decoded by VTK readers on a pool of worker threads, each
+with its own reader, and copied into a volume allocated once.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import threading
+
+import numpy
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from tvtk import array_handler
+
+# Local imports.
+from mayavi.core.common import parallel_map
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def read_slice(reader, file_name):
+    """Reads `file_name` with the VTK image reader `reader` and returns
+    the dimensions, spacing and origin of the image and a numpy view of
+    its scalars.  The view is only valid until the reader is used
+    again.
+    """
+    reader.SetFileName(file_name)
+    reader.Update()
+    img = reader.GetOutput()
+    scalars = img.GetPointData().GetScalars()
+    if scalars is None:
+        raise ValueError('The image %s has no scalars.'%file_name)
+    return img.GetDimensions(), img.GetSpacing(), img.GetOrigin(), \
+           array_handler.vtk2array(scalars)
+
+
+def make_image_data(dims, spacing, origin, values):
+    """Returns a tvtk ImageData of the given geometry whose point
+    scalars are the flat array `values`, used without a copy."""
+    img = tvtk.ImageData(dimensions=dims, spacing=spacing, origin=origin)
+    img.extent = 0, dims[0]-1, 0, dims[1]-1, 0, dims[2]-1
+    img.point_data.scalars = values
+    img.point_data.scalars.name = 'scalars'
+    # This is very important and if not done can lead to a segfault!
+    img.scalar_type = array_handler.get_vtk_array_type(values.dtype)
+    if values.ndim > 1:
+        img.number_of_scalar_components = values.shape[1]
+    img.update()
+    return img
+
+
+######################################################################
+# `SliceStackLoader` class.
+######################################################################
+class SliceStackLoader(object):
+    """Loads 2D image files as the z slices of a volume.
+
+    `new_reader()` must return a new VTK image reader.  It is only
+    called on the thread calling `load`, the readers are then used by
+    one worker thread each.  `cancel` may be called from any thread.
+    """
+
+    def __init__(self, file_names, new_reader, n_threads=0):
+        self.file_names = list(file_names)
+        self.new_reader = new_reader
+        # The number of worker threads, all processors if zero.
+        self.n_threads = n_threads
+        # The number of slices loaded so far.
+        self.n_done = 0
+        self._cancel = threading.Event()
+
+    def cancel(self):
+        """Stops the loading as soon as the slices being decoded are
+        done."""
+        self._cancel.set()
+
+    @property
+    def cancelled(self):
+        """True if `cancel` was called."""
+        return self._cancel.isSet()
+
+    def load(self, progress=None, interval=0.1):
+        """Loads the slices and returns the dimensions, spacing and
+        origin of the volume and the flat array of its point values, or
+        None if the loading was cancelled.
+
+        `progress(fraction)` is called on the calling thread every
+        `interval` seconds, returning False from it cancels the
+        loading.  A ValueError is raised if the slices do not all have
+        the size of the first one.
+        """
+        files = self.file_names
+        n = len(files)
+        if n == 0:
+            raise ValueError('No slices to load.')
+        first = self.new_reader()
+        dims, spacing, origin, arr = read_slice(first, files[0])
+        if dims[2] != 1:
+            raise ValueError('The image %s is not 2D.'%files[0])
+        data = numpy.empty((n,) + arr.shape, arr.dtype)
+        data[0] = arr
+        self.n_done = 1
+
+        # The first reader is reused by a worker.
+        readers = [first]
+
+        def _new_reader():
+            if len(readers) > 0:
+                return readers.pop()
+            return self.new_reader()
+
+        def _read(reader, i):
+            d, s, o, values = read_slice(reader, files[i])
+            if d != dims or values.shape != data.shape[1:]:
+                raise ValueError('The image %s does not have the '\
+                                 'size of the first slice.'%files[i])
+            data[i] = values
+
+        def _progress(fraction):
+            self.n_done = 1 + int(round(fraction*(n - 1)))
+            if progress is not None:
+                return progress(float(self.n_done)/n)
+
+        if parallel_map(_read, range(1, n), self.n_threads, _new_reader,
+                        self._cancel, _progress, interval) is None:
+            return None
+        if progress is not None:
+            progress(1.0)
+        dims = dims[0], dims[1], n
+        # A view of the whole volume, x varying fastest.
+        values = numpy.reshape(data, (-1,) + arr.shape[1:])
+        return dims, spacing, origin, values
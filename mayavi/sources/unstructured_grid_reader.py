@@ -17,6 +17,14 @@ from mayavi.core.file_data_source import FileDataSource
 from mayavi.core.pipeline_info import PipelineInfo
 from mayavi.core.common import error
 
+# The names of the tvtk reader classes used for each file extension.
+# The readers are only created when a file with that extension is read.
+READER_CLASSES = {'inp': 'AVSucdReader',
+                  'neu': 'GAMBITReader',
+                  'exii': 'ExodusReader',
+                 }
+
+
 ########################################################################
 # `UnstructuredGridReader` class
 ########################################################################
@@ -33,6 +41,8 @@ class UnstructuredGridReader(FileDataSource):
 
     ######################################################################
     # Private Traits
+
+    # The readers created so far, by extension.
     _reader_dict = Dict(Str, Instance(tvtk.Object))
 
     # Our view.
@@ -75,8 +85,8 @@ class UnstructuredGridReader(FileDataSource):
         extension = splitname[-1].lower()
         # Select UnstructuredGridreader based on file type
         old_reader = self.reader
-        if self._reader_dict.has_key(extension):
-            self.reader = self._reader_dict[extension]
+        if extension in READER_CLASSES:
+            self.reader = self._get_reader(extension)
         else:
             error('Invalid file extension for file: %s'%value)
             return
@@ -111,10 +121,11 @@ class UnstructuredGridReader(FileDataSource):
 
         return ret
 
-    def __reader_dict_default(self):
-        """Default value for reader dict."""
-        rd = {'inp':tvtk.AVSucdReader(),
-             'neu':tvtk.GAMBITReader(),
-             'exii':tvtk.ExodusReader()
-            }
-        return rd
+    def _get_reader(self, extension):
+        """Returns the reader for the given extension, creating it on
+        first use."""
+        reader = self._reader_dict.get(extension)
+        if reader is None:
+            reader = getattr(tvtk, READER_CLASSES[extension])()
+            self._reader_dict[extension] = reader
+        return reader
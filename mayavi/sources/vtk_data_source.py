@@ -20,6 +20,7 @@ from tvtk import messenger
 # Local imports.
 from mayavi.core.source import Source
 from mayavi.core.common import handle_children_state
+from mayavi.core import dataset_store
 from mayavi.core.trait_defs import DEnum
 from mayavi.core.pipeline_info import (PipelineInfo,
         get_tvtk_dataset_name)
@@ -169,14 +170,29 @@ class VTKDataSource(Source):
             d.pop('_' + name + '_name', None)
         data = self.data
         if data is not None:
-            sdata = write_dataset_to_string(data)
-            z = gzip_string(sdata)
-            d['data'] = z
+            # When the visualization is saved with binary datasets only a
+            # reference to the dataset is kept in the state.
+            store = dataset_store.get_active_store()
+            ref = None
+            if store is not None:
+                ref = store.add_dataset(data)
+            if ref is not None:
+                d['data'] = ref
+            else:
+                sdata = write_dataset_to_string(data)
+                z = gzip_string(sdata)
+                d['data'] = z
         return d
 
     def __set_pure_state__(self, state):
         z = state.data
-        if z is not None:
+        if dataset_store.is_reference(z):
+            store = dataset_store.get_active_store()
+            if store is None:
+                raise ValueError('The dataset %s of the saved '\
+                      'visualization cannot be found'%z)
+            self.data = store.get_dataset(z)
+        elif z is not None:
             d = gunzip_string(z)
             r = tvtk.DataSetReader(read_from_input_string=1,
                                    input_string=d)
@@ -13,8 +13,7 @@ from traits.api import Instance
 from tvtk.api import tvtk
 
 # Local imports.
-from mayavi.core.pipeline_info import (PipelineInfo,
-        get_tvtk_dataset_name)
+from mayavi.core.pipeline_info import PipelineInfo
 from vtk_xml_file_reader import VTKXMLFileReader
 
 
@@ -52,9 +51,12 @@ class VTKFileReader(VTKXMLFileReader):
         if len(value) == 0:
             self.name = 'No VTK file'
             return
+        elif self._loading_cached:
+            return
         else:
             self.reader.file_name = value
             self.update()
+            self._cached_output = None
 
             # Setup the outputs by resetting self.outputs.  Changing
             # the outputs automatically fires a pipeline_changed
@@ -67,21 +69,15 @@ class VTKFileReader(VTKXMLFileReader):
             for i in range(n):
                 outputs.append(self.reader.get_output(i))
             self.outputs = outputs
-
-            # FIXME: Only the first output goes through the assign
-            # attribute filter.
-            aa = self._assign_attribute
-            aa.input = outputs[0]
-            outputs[0] = aa.output
-            self.update_data()
-
-            self.outputs = outputs
-
-            # FIXME: The output info is only based on the first output.
-            self.output_info.datasets = [get_tvtk_dataset_name(outputs[0])]
-
-            # Change our name on the tree view
-            self.name = self._get_name()
+            self._setup_outputs(outputs)
+
+    def _new_timestep_reader(self):
+        reader = tvtk.to_vtk(self.reader).NewInstance()
+        reader.ReadAllScalarsOn()
+        reader.ReadAllVectorsOn()
+        reader.ReadAllTensorsOn()
+        reader.ReadAllFieldsOn()
+        return reader
 
     def _get_name(self):
         """ Gets the name to display on the tree view.
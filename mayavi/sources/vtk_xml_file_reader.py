@@ -8,7 +8,8 @@
 from os.path import basename
 
 # Enthought library imports.
-from traits.api import Instance, List, Str, Bool
+from traits.api import Instance, List, Str, Bool, Int, Enum, Range, \
+     Array, Any
 from traitsui.api import View, Group, Item, Include
 from tvtk.api import tvtk
 
@@ -18,6 +19,7 @@ from mayavi.core.common import error
 from mayavi.core.trait_defs import DEnum
 from mayavi.core.pipeline_info import (PipelineInfo,
         get_tvtk_dataset_name)
+from mayavi.sources.piece_reader import PieceLoader, is_parallel_file
 
 
 ######################################################################
@@ -134,6 +136,41 @@ class VTKXMLFileReader(FileDataSource):
     # The VTK data file reader.
     reader = Instance(tvtk.XMLReader)
 
+    # Read the pieces of parallel files (.pvtu, .pvti etc.) on worker
+    # threads rather than with the VTK parallel reader.
+    read_pieces_in_parallel = Bool(False,
+                        desc='if the pieces are read on worker threads')
+
+    # The number of threads reading the pieces, all the processors if
+    # zero.
+    n_threads = Int(0, desc='the number of threads reading the pieces')
+
+    # Merge the pieces into one dataset or make one output per piece.
+    merge_pieces = Enum('append', 'pieces',
+                        desc='if the pieces are merged in one dataset')
+
+    # Only read the pieces intersecting `piece_bounds`.
+    select_pieces = Bool(False,
+                         desc='if only the pieces in the bounds are read')
+
+    # The bounds used to select the pieces.
+    piece_bounds = Array(value=(0.0, 1.0, 0.0, 1.0, 0.0, 1.0),
+                         shape=(6,),
+                         cols=2,
+                         dtype=float,
+                         enter_set=True,
+                         auto_set=False,
+                         labels=['xmin', 'xmax', 'ymin', 'ymax',
+                                 'zmin', 'zmax'],
+                         desc='the bounds of the pieces to read')
+
+    # The fraction of the pieces read.
+    piece_progress = Range(0.0, 1.0, desc='the fraction of pieces read')
+
+    # The number of pieces in the file and of pieces read.
+    n_pieces = Int(0, desc='the number of pieces in the file')
+    n_pieces_read = Int(0, desc='the number of pieces read')
+
     # Information about what this object can produce.
     output_info = PipelineInfo(datasets=['any'],
                                attribute_types=['any'],
@@ -148,7 +185,20 @@ class VTKXMLFileReader(FileDataSource):
                       Item(name='cell_vectors_name'),
                       Item(name='cell_tensors_name'),
                       Item(name='reader'),
-                      ))
+                      ),
+                Group(Item(name='read_pieces_in_parallel'),
+                      Group(Item(name='n_threads'),
+                            Item(name='merge_pieces'),
+                            Item(name='select_pieces'),
+                            Item(name='piece_bounds',
+                                 enabled_when='object.select_pieces'),
+                            Item(name='piece_progress', style='readonly'),
+                            Item(name='n_pieces_read', style='readonly'),
+                            Item(name='n_pieces', style='readonly'),
+                            enabled_when='object.read_pieces_in_parallel'),
+                      label='Pieces',
+                      defined_when='object._is_parallel'),
+                )
 
     ########################################
     # Private traits.
@@ -172,12 +222,27 @@ class VTKXMLFileReader(FileDataSource):
     # Toggles if this is the first time this object has been used.
     _first = Bool(True)
 
+    # The first output of a time step served from the cache, None when
+    # the data comes from `reader`.
+    _cached_output = Instance(tvtk.DataObject)
+
+    # The time step cache is supported.
+    _cache_supported = True
+
+    # The loader of the pieces being read.
+    _piece_loader = Any
+
+    # True if the file is a parallel file.
+    _is_parallel = Bool(False)
+
     ######################################################################
     # `object` interface
     ######################################################################
     def __get_pure_state__(self):
         d = super(VTKXMLFileReader, self).__get_pure_state__()
-        for name in ('_assign_attribute', '_first'):
+        for name in ('_assign_attribute', '_first', '_cached_output',
+                     '_piece_loader', '_is_parallel', 'piece_progress',
+                     'n_pieces', 'n_pieces_read'):
             d.pop(name, None)
         # Pickle the 'point_scalars_name' etc. since these are
         # properties and not in __dict__.
@@ -230,15 +295,18 @@ class VTKXMLFileReader(FileDataSource):
     def update(self):
         if len(self.file_path.get()) == 0:
             return
-        reader = self.reader
-        reader.update()
+        if self._use_piece_loader(self.file_path.get()):
+            self._reload_pieces()
+        else:
+            self.reader.update()
         self.render()
 
     def update_data(self):
         if len(self.file_path.get()) == 0:
             return
-        self.reader.update()
-        pnt_attr, cell_attr = get_all_attributes(self.reader.output)
+        if self._cached_output is None:
+            self.reader.update()
+        pnt_attr, cell_attr = get_all_attributes(self._get_reader_output())
 
         def _setup_data_traits(obj, attributes, d_type):
             """Given the object, the dict of the attributes from the
@@ -247,7 +315,7 @@ class VTKXMLFileReader(FileDataSource):
             """
             attrs = ['scalars', 'vectors', 'tensors']
             aa = obj._assign_attribute
-            data = getattr(obj.reader.output, '%s_data'%d_type)
+            data = getattr(obj._get_reader_output(), '%s_data'%d_type)
             for attr in attrs:
                 values = attributes[attr]
                 values.append('')
@@ -278,7 +346,7 @@ class VTKXMLFileReader(FileDataSource):
     ######################################################################
     def _file_path_changed(self, fpath):
         value = fpath.get()
-        if len(value) == 0:
+        if len(value) == 0 or self._loading_cached:
             return
         else:
             if self.reader is None:
@@ -286,7 +354,16 @@ class VTKXMLFileReader(FileDataSource):
                 self.reader = eval('tvtk.XML%sReader()'%d_type)
             reader = self.reader
             reader.file_name = value
+            self._is_parallel = is_parallel_file(value)
+            if self._use_piece_loader(value):
+                outputs = self._load_pieces(value)
+                if outputs is not None:
+                    outputs = [tvtk.to_tvtk(o) for o in outputs]
+                    self._cached_output = outputs[0]
+                    self._setup_outputs(outputs)
+                return
             reader.update()
+            self._cached_output = None
 
             # Setup the outputs by resetting self.outputs.  Changing
             # the outputs automatically fires a pipeline_changed
@@ -298,27 +375,144 @@ class VTKXMLFileReader(FileDataSource):
             outputs = []
             for i in range(n):
                 outputs.append(reader.get_output(i))
+            self._setup_outputs(outputs)
 
-            # FIXME: Only the first output goes through the assign
-            # attribute filter.
-            aa = self._assign_attribute
-            aa.input = outputs[0]
-            outputs[0] = aa.output
-            self.update_data()
-
-            self.outputs = outputs
-
-            # FIXME: The output info is only based on the first output.
-            self.output_info.datasets = [get_tvtk_dataset_name(outputs[0])]
+    def _setup_outputs(self, outputs):
+        """Sets the outputs read from the file, passing the first one
+        through the assign attribute filter."""
+        # FIXME: Only the first output goes through the assign
+        # attribute filter.
+        aa = self._assign_attribute
+        aa.input = outputs[0]
+        outputs[0] = aa.output
+        self.update_data()
+
+        self.outputs = outputs
+
+        # FIXME: The output info is only based on the first output.
+        self.output_info.datasets = [get_tvtk_dataset_name(outputs[0])]
+
+        # Change our name on the tree view
+        self.name = self._get_name()
+
+    def _use_piece_loader(self, file_name):
+        return self.read_pieces_in_parallel and is_parallel_file(file_name)
+
+    def _piece_settings(self):
+        """Returns the number of threads, the bounds and the merge mode
+        used to read the pieces."""
+        bounds = None
+        if self.select_pieces:
+            bounds = tuple(self.piece_bounds)
+        return self.n_threads, bounds, self.merge_pieces
+
+    def _load_pieces(self, file_name):
+        """Reads the (selected) pieces of the parallel file on worker
+        threads.  Returns the list of VTK outputs or None if the
+        loading failed or was cancelled."""
+        n_threads, bounds, merge = self._piece_settings()
+        try:
+            loader = PieceLoader(file_name, n_threads)
+        except (ValueError, IOError, SyntaxError), e:
+            error('Unable to read %s: %s'%(file_name, e))
+            return None
+        self._piece_loader = loader
+        self.piece_progress = 0.0
+        try:
+            outputs = loader.load_selected(bounds, merge,
+                                           self._update_piece_progress)
+        except (ValueError, IOError), e:
+            error(str(e))
+            return None
+        finally:
+            self._piece_loader = None
+        self.set(n_pieces=len(loader.header['pieces']),
+                 n_pieces_read=loader.n_selected)
+        return outputs
+
+    def cancel_pieces(self):
+        """Cancels the reading of the pieces.  This may be called from
+        another thread or from a handler of `piece_progress`."""
+        loader = self._piece_loader
+        if loader is not None:
+            loader.cancel()
+
+    def _update_piece_progress(self, fraction):
+        self.piece_progress = fraction
+
+    def _reload_pieces(self):
+        """Reads the current file again with the current piece
+        settings."""
+        if len(self.file_path.get()) == 0:
+            return
+        if self._cache is not None:
+            # The time steps read ahead with the old settings may still
+            # be put in the old cache.
+            self._stop_read_ahead()
+            self._cache = None
+            self._update_cache()
+        self._file_path_changed(self.file_path)
+        self.render()
 
-            # Change our name on the tree view
-            self.name = self._get_name()
+    def _read_pieces_in_parallel_changed(self):
+        if self._is_parallel:
+            self._reload_pieces()
+
+    def _merge_pieces_changed(self):
+        if self._use_piece_loader(self.file_path.get()):
+            self._reload_pieces()
+
+    def _select_pieces_changed(self):
+        if self._use_piece_loader(self.file_path.get()):
+            self._reload_pieces()
+
+    def _piece_bounds_changed(self):
+        if self.select_pieces and \
+               self._use_piece_loader(self.file_path.get()):
+            self._reload_pieces()
+
+    def _read_timestep(self, file_name):
+        if self._use_piece_loader(file_name):
+            outputs = self._load_pieces(file_name)
+            if outputs is not None:
+                nbytes = sum(o.GetActualMemorySize() for o in outputs)
+                return outputs, nbytes*1024
+        # Read the time step with the VTK reader.
+        return super(VTKXMLFileReader, self)._read_timestep(file_name)
+
+    def _new_timestep_loader(self):
+        vtk_loader = super(VTKXMLFileReader, self)._new_timestep_loader()
+        if not self.read_pieces_in_parallel:
+            return vtk_loader
+        # The settings are copied here, on the main thread.  The time
+        # steps read ahead do not report their progress.
+        n_threads, bounds, merge = self._piece_settings()
+        def _loader(file_name):
+            if not is_parallel_file(file_name):
+                return vtk_loader(file_name)
+            outputs = PieceLoader(file_name, n_threads).load_selected(
+                bounds, merge)
+            if outputs is None:
+                raise ValueError('Reading %s was cancelled.'%file_name)
+            nbytes = sum(o.GetActualMemorySize() for o in outputs)
+            return outputs, nbytes*1024
+        return _loader
+
+    def _set_timestep_outputs(self, outputs):
+        self._cached_output = outputs[0]
+        self._setup_outputs(list(outputs))
+
+    def _get_reader_output(self):
+        """Returns the dataset whose attributes are assigned."""
+        if self._cached_output is not None:
+            return self._cached_output
+        return self.reader.output
 
     def _set_data_name(self, data_type, attr_type, value):
         if value is None:
             return
 
-        reader_output = self.reader.output
+        reader_output = self._get_reader_output()
         if len(value) == 0:
             # If the value is empty then we deactivate that attribute.
             d = getattr(reader_output, attr_type + '_data')
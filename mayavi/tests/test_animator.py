@@ -0,0 +1,196 @@
+"""
+Tests for the frame statistics of the animator.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+import unittest
+
+from traits.api import HasTraits, Bool, Any
+from mayavi.tools import animator
+from mayavi.tools.animator import Animator, FrameStats
+
+
+class Clock(object):
+    """A clock advanced by the tests."""
+    def __init__(self):
+        self.now = 1000.0
+
+    def __call__(self):
+        return self.now
+
+
+class FakeTimer(animator.Timer):
+    """Records the intervals it is started with."""
+    def __init__(self, millisec, callable):
+        self.running = False
+        self.starts = []
+
+    def Start(self, millisec=None):
+        self.running = True
+        self.starts.append(millisec)
+
+    def Stop(self):
+        self.running = False
+
+    def IsRunning(self):
+        return self.running
+
+
+class RenderWindow(object):
+    def __init__(self):
+        self.observers = {}
+
+    def add_observer(self, event, callback):
+        self.observers[event] = callback
+        return len(self.observers)
+
+
+class Scene(HasTraits):
+    """Renders, taking `render_time` seconds, when `disable_render` is
+    reset like a TVTK scene."""
+    disable_render = Bool(False)
+    render_window = Any
+    clock = Any
+    render_time = 0.0
+    n_renders = 0
+
+    def render(self):
+        if self.disable_render:
+            return
+        obs = self.render_window.observers
+        obs['StartEvent'](None, 'StartEvent')
+        self.clock.now += self.render_time
+        obs['EndEvent'](None, 'EndEvent')
+        self.n_renders += 1
+
+    def _disable_render_changed(self, value):
+        if not value:
+            self.render()
+
+
+class TestFrameStats(unittest.TestCase):
+    def test_record(self):
+        s = FrameStats(window=4)
+        for i in range(1, 7):
+            s.record(0.1*i, 0.01*i, skipped=1)
+        self.assertEqual(s.n_frames, 6)
+        self.assertEqual(s.n_skipped, 6)
+        # Only the last 4 frames are in the window.
+        self.assertAlmostEqual(s.compute_mean, 0.45)
+        self.assertAlmostEqual(s.compute_max, 0.6)
+        self.assertAlmostEqual(s.render_max, 0.06)
+        self.assertAlmostEqual(s.frame_p95, 0.66)
+        d = s.to_dict()
+        self.assertAlmostEqual(d['render_mean'], 0.045)
+        self.assertEqual(d['n_frames'], 6)
+
+    def test_reset(self):
+        s = FrameStats()
+        s.record(1.0)
+        s.reset()
+        self.assertEqual(s.n_frames, 0)
+        self.assertEqual(s.frame_max, 0.0)
+        self.assertEqual(s.fps, 0.0)
+
+    def test_window_change(self):
+        s = FrameStats(window=10)
+        for i in range(10):
+            s.record(float(i))
+        s.window = 2
+        self.assertAlmostEqual(s.compute_mean, 8.5)
+
+
+class TestAnimatorPacing(unittest.TestCase):
+
+    def setUp(self):
+        self.clock = Clock()
+        self._old = animator.time, animator.Timer
+        animator.time = self.clock
+        animator.Timer = FakeTimer
+        self.scene = Scene(render_window=RenderWindow(), clock=self.clock)
+        # The time a step of the animation takes and the steps taken.
+        self.step_time = 0.0
+        self.steps = []
+        self.anim = Animator(100, self._animate)
+        self.anim.scene = self.scene
+
+    def tearDown(self):
+        animator.time, animator.Timer = self._old
+
+    def _animate(self):
+        self.clock.now += self.step_time
+        self.steps.append(self.scene.disable_render)
+        self.scene.render()
+
+    def test_fixed_delay(self):
+        a = self.anim
+        a.start = True
+        self.step_time = 0.5
+        a._step()
+        a._step()
+        # The timer keeps its delay whatever the frames take.
+        self.assertEqual(a.timer.starts, [100])
+        self.assertEqual(self.steps, [False, False])
+        self.assertEqual(a.stats.n_frames, 2)
+        self.assertEqual(a.stats.n_skipped, 0)
+
+    def test_fast_frames_wait(self):
+        a = self.anim
+        a.set(adaptive=True, target_fps=2)
+        a.start = True
+        self.assertEqual(a.timer.starts, [500])
+        self.step_time = 0.25
+        self.scene.render_time = 0.125
+        a._step()
+        self.assertEqual(a._n_steps, 1)
+        # The rest of the frame budget is waited for.
+        self.assertEqual(a.timer.starts[-1], 125)
+        self.assertAlmostEqual(a.stats.compute_max, 0.25)
+        self.assertAlmostEqual(a.stats.render_max, 0.125)
+
+    def test_slow_frames_merge_steps(self):
+        a = self.anim
+        a.set(adaptive=True, target_fps=2)
+        a.start = True
+        self.step_time = 1.25
+        a._step()
+        self.assertEqual(a._n_steps, 3)
+        self.assertEqual(a.timer.starts[-1], 1)
+        self.assertTrue(a.timer.IsRunning())
+
+        # The 3 steps are rendered once, when rendering is re-enabled.
+        del self.steps[:]
+        self.step_time = 0.0625
+        self.scene.n_renders = 0
+        a._step()
+        self.assertEqual(self.steps, [True, True, True])
+        self.assertFalse(self.scene.disable_render)
+        self.assertEqual(self.scene.n_renders, 1)
+        self.assertEqual(a.stats.n_frames, 2)
+        self.assertEqual(a.stats.n_skipped, 2)
+        # Caught up.
+        self.assertEqual(a._n_steps, 1)
+
+    def test_max_skip(self):
+        a = self.anim
+        a.set(adaptive=True, target_fps=2, max_skip=4)
+        a.start = True
+        self.step_time = 4.0
+        a._step()
+        self.assertEqual(a._n_steps, 5)
+
+    def test_stop_iteration(self):
+        a = self.anim
+        a.set(adaptive=True, target_fps=10)
+        a.start = True
+        def stop():
+            raise StopIteration
+        a._callable = stop
+        self.assertRaises(StopIteration, a._step)
+        # Not restarted after the end of the animation.
+        self.assertFalse(a.timer.IsRunning())
+
+
+if __name__ == '__main__':
+    unittest.main()
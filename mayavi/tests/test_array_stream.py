@@ -0,0 +1,189 @@
+"""
+Tests for the binary array frames of the Mayavi server.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import json
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from traits.api import HasTraits, Any, Int
+from mayavi.core.null_engine import NullEngine
+from mayavi.sources.array_source import ArraySource
+from mayavi.tools.array_stream import ArrayStreamReceiver, \
+     encode_frame, find_source, MAGIC, PREFIX
+
+
+class Target(HasTraits):
+    """Counts the updates of its arrays."""
+    scalars = Any
+    vectors = Any
+    n_set = Int(0)
+    n_update = Int(0)
+
+    def set(self, **traits):
+        self.n_set += 1
+        return super(Target, self).set(**traits)
+
+    def update(self):
+        self.n_update += 1
+
+
+def frame(*args, **kw):
+    header, payload = encode_frame(*args, **kw)
+    return header + payload.tostring()
+
+
+class TestArrayStreamReceiver(unittest.TestCase):
+
+    def setUp(self):
+        self.target = Target(scalars=numpy.zeros((4, 3, 2)))
+        self.receiver = ArrayStreamReceiver(self._find)
+
+    def _find(self, source_id):
+        if source_id == 'src':
+            return self.target
+        return None
+
+    def _feed(self, data, chunk=None):
+        """Feeds `data` in chunks and returns the text received."""
+        if chunk is None:
+            return self.receiver.feed(data)
+        return ''.join(self.receiver.feed(data[i:i + chunk])
+                       for i in range(0, len(data), chunk))
+
+    def test_in_place(self):
+        arr = self.target.scalars
+        a = numpy.random.rand(4, 3, 2)
+        for chunk in (None, 1, 7, 100):
+            arr[...] = 0
+            self.assertEqual(self._feed(frame('src', 'scalars', a), chunk),
+                             '')
+            self.assertFalse(self.receiver.in_frame())
+            # Received in the array of the target.
+            self.assertTrue(self.target.scalars is arr)
+            testing.assert_array_equal(arr, a)
+        self.assertEqual(self.receiver.flush(), 1)
+        self.assertEqual(self.target.n_update, 1)
+        self.assertEqual(self.target.n_set, 0)
+        self.assertFalse(self.receiver.is_dirty())
+        self.assertEqual(self.receiver.flush(), 0)
+
+    def test_new_array(self):
+        a = numpy.arange(10, dtype='int32')
+        self._feed(frame('src', 'scalars', a) + frame('src', 'vectors', a))
+        # Set when flushed.
+        self.assertEqual(self.target.scalars.shape, (4, 3, 2))
+        self.receiver.flush()
+        testing.assert_array_equal(self.target.scalars, a)
+        testing.assert_array_equal(self.target.vectors, a)
+        self.assertEqual(self.target.n_set, 1)
+        self.assertEqual(self.target.n_update, 0)
+
+    def test_region(self):
+        arr = self.target.scalars
+        a = numpy.random.rand(4, 3, 2)
+        # Contiguous and non-contiguous regions.
+        for region in ([(1, 3), (0, 3), (0, 2)], [(0, 4), (1, 2), (1, 2)]):
+            arr[...] = 0
+            self._feed(frame('src', 'scalars', a, region=region), 5)
+            expected = numpy.zeros_like(a)
+            s = tuple(slice(*r) for r in region)
+            expected[s] = a[s]
+            testing.assert_array_equal(arr, expected)
+
+    def test_coalesced(self):
+        a = numpy.random.rand(4, 3, 2)
+        data = ''.join(frame('src', 'scalars', a*i) for i in range(5))
+        self._feed(data, 33)
+        self.receiver.flush()
+        self.assertEqual(self.target.n_update, 1)
+        testing.assert_array_almost_equal(self.target.scalars, a*4)
+
+    def test_text(self):
+        a = numpy.random.rand(4, 3, 2)
+        self.assertEqual(self._feed('camera.azimuth(10)\n'),
+                         'camera.azimuth(10)\n')
+        self.assertEqual(self._feed(frame('src', 'scalars', a) +
+                                    'mlab.clf()'), 'mlab.clf()')
+
+    def test_text_and_frame(self):
+        a = numpy.random.rand(4, 3, 2)
+        data = 'mlab.clf()\n' + frame('src', 'scalars', a) + 'x = 1\n'
+        for chunk in (None, 5, 12):
+            self.target.scalars[...] = 0
+            self.assertEqual(self._feed(data, chunk), 'mlab.clf()\nx = 1\n')
+            self.assertFalse(self.receiver.in_frame())
+            testing.assert_array_equal(self.target.scalars, a)
+
+    def test_invalid_region(self):
+        a = numpy.random.rand(4, 3, 2)
+        self.assertRaises(ValueError, encode_frame, 'src', 'scalars', a,
+                          region=[(0, 5), (0, 3), (0, 2)])
+        data = ''
+        # Regions out of the array, with the payload their size gives.
+        for region, size in (([(2, 6), (0, 3), (0, 2)], 24),
+                             ([(-1, 1), (0, 3), (0, 2)], 12),
+                             ([(0, 2), (0, 3)], 6)):
+            header = json.dumps(dict(source='src', array='scalars',
+                                     dtype=a.dtype.str, shape=a.shape,
+                                     region=region))
+            data += PREFIX.pack(MAGIC, len(header)) + header + \
+                    'x'*8*size
+        data += frame('src', 'scalars', a) + 'mlab.clf()'
+        for chunk in (None, 7):
+            self.target.scalars[...] = 0
+            self.assertEqual(self._feed(data, chunk), 'mlab.clf()')
+            testing.assert_array_equal(self.target.scalars, a)
+
+    def test_dropped(self):
+        a = numpy.random.rand(4, 3, 2)
+        data = frame('nothing', 'scalars', a) + \
+               frame('src', 'scalars', a, region=[(0, 1)]*3)
+        b = numpy.random.rand(5)
+        # A region of an array of another shape is dropped too.
+        data += frame('src', 'vectors', b, region=[(0, 2)])
+        self._feed(data + frame('src', 'scalars', a), 11)
+        testing.assert_array_equal(self.target.scalars, a)
+        self.assertEqual(self.target.vectors, None)
+
+
+class TestArraySourceStream(unittest.TestCase):
+
+    def test_array_source(self):
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        src = ArraySource(scalar_data=numpy.zeros((4, 3, 2)))
+        e.add_source(src)
+        src.name = 'data'
+        receiver = ArrayStreamReceiver(lambda x: find_source(e, x))
+        self.assertTrue(find_source(e, 'data') is src)
+        self.assertEqual(find_source(e, 'nothing'), None)
+
+        a = numpy.random.rand(4, 3, 2)
+        receiver.feed(frame('data', 'scalar_data', a))
+        receiver.flush()
+        scalars = src.image_data.point_data.scalars
+        self.assertEqual(scalars.range, (a.min(), a.max()))
+
+        # Changed in place, VTK has a transposed copy.
+        receiver.feed(frame('data', 'scalar_data', a*2))
+        receiver.flush()
+        testing.assert_array_almost_equal(scalars.to_array(),
+                                          numpy.ravel(a.T*2))
+
+        b = numpy.random.rand(5, 5, 5)
+        receiver.feed(frame('data', 'scalar_data', b))
+        receiver.flush()
+        self.assertEqual(src.image_data.dimensions, (5, 5, 5))
+        e.stop()
+
+
+if __name__ == '__main__':
+    unittest.main()
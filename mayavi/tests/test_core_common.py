@@ -5,9 +5,10 @@ Tests for the mayavi.core.common module.
 # Copyright (c) 2008, Enthought, Inc.
 # License: BSD Style.
 
+import threading
 import unittest
 
-from mayavi.core.common import get_object_path, get_engine
+from mayavi.core.common import get_object_path, get_engine, parallel_map
 from mayavi.sources.parametric_surface import \
     ParametricSurface
 from mayavi.modules.outline import Outline
@@ -85,5 +86,44 @@ class TestCoreCommon(unittest.TestCase):
         self.assertEqual(o1.parent, mm)
 
 
+class TestParallelMap(unittest.TestCase):
+    def test_order(self):
+        "Test if the results of parallel_map are in order."
+        self.assertEqual(parallel_map(lambda x: x*x, range(20), 4),
+                         [x*x for x in range(20)])
+        self.assertEqual(parallel_map(lambda x: x, []), [])
+        def _fail(x):
+            raise ValueError(x)
+        self.assertRaises(ValueError, parallel_map, _fail, range(4), 2)
+
+    def test_state(self):
+        "Test if each worker gets its own state."
+        states = []
+        def _new_state():
+            states.append([])
+            return states[-1]
+        def _func(state, x):
+            state.append(x)
+            return x + 1
+        result = parallel_map(_func, range(10), 3, _new_state)
+        self.assertEqual(result, range(1, 11))
+        self.assertEqual(len(states), 3)
+        self.assertEqual(sorted(sum(states, [])), range(10))
+
+    def test_cancel(self):
+        "Test if a cancelled map returns None."
+        cancel = threading.Event()
+        cancel.set()
+        self.assertEqual(parallel_map(lambda x: x, range(4), 2,
+                                      cancel=cancel), None)
+        fractions = []
+        def _progress(fraction):
+            fractions.append(fraction)
+            return False
+        self.assertEqual(parallel_map(lambda x: x, range(4), 2,
+                                      progress=_progress), None)
+        self.assertTrue(len(fractions) > 0)
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,91 @@
+"""
+Tests for the binary sidecar cache of CSV files.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+import os
+import shutil
+import tempfile
+import time
+import unittest
+
+import numpy
+
+from mayavi.tools.data_wizards.csv_sniff import Sniff
+from mayavi.tools.data_wizards.loadtxt import loadtxt
+from mayavi.tools.data_wizards import csv_cache
+
+
+class TestCSVCache(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        self.fname = os.path.join(self.tmpdir, 'data.csv')
+        self._write([(1, 2.5), (3, 4.5)])
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def _write(self, rows):
+        f = open(self.fname, 'w')
+        f.write('"a", "b"\n')
+        for row in rows:
+            f.write('%r, %r\n' % row)
+        f.close()
+
+    def test_sniff(self):
+        kwds = csv_cache.cached_sniff(self.fname)
+        self.assertEqual(kwds, Sniff(self.fname).kwds())
+        self.assertTrue(os.path.exists(os.path.join(
+            csv_cache.cache_dir(self.fname), 'sniff.json')))
+        # Read back from the cache.
+        self.assertEqual(csv_cache.cached_sniff(self.fname), kwds)
+
+    def test_loadtxt(self):
+        kwds = csv_cache.cached_sniff(self.fname)
+        self.assertEqual(csv_cache.load(self.fname, kwds), None)
+        x = csv_cache.cached_loadtxt(self.fname, **kwds)
+        columns = csv_cache.load_columns(self.fname, kwds)
+        self.assertEqual(sorted(columns.keys()), ['a', 'b'])
+        self.assertTrue(isinstance(columns['a'], numpy.memmap))
+        y = csv_cache.cached_loadtxt(self.fname, **kwds)
+        self.assertEqual(x.dtype, y.dtype)
+        for name in ('a', 'b'):
+            numpy.testing.assert_equal(x[name], y[name])
+
+        # Other options use another entry.
+        other = dict(kwds, skiprows=2)
+        self.assertEqual(csv_cache.load(self.fname, other), None)
+
+    def test_load_columns(self):
+        "Test if the columns are memory-mapped, not copied."
+        kwds = csv_cache.cached_sniff(self.fname)
+        fractions = []
+        x = csv_cache.cached_load_columns(self.fname,
+                                          progress=fractions.append, **kwds)
+        self.assertEqual(fractions[-1], 1.0)
+        y = csv_cache.cached_load_columns(self.fname, **kwds)
+        for name in ('a', 'b'):
+            self.assertTrue(isinstance(x[name], numpy.memmap))
+            self.assertTrue(isinstance(y[name], numpy.memmap))
+            numpy.testing.assert_equal(x[name], y[name])
+        numpy.testing.assert_equal(y['a'], [1, 3])
+        # Writing to a column does not change the cache.
+        y['a'][0] = 42
+        z = csv_cache.cached_load_columns(self.fname, **kwds)
+        self.assertEqual(z['a'][0], 1)
+
+    def test_invalidation(self):
+        kwds = csv_cache.cached_sniff(self.fname)
+        csv_cache.cached_loadtxt(self.fname, **kwds)
+        self._write([(1, 2.5), (3, 4.5), (5, 6.5)])
+        st = os.stat(self.fname)
+        os.utime(self.fname, (st.st_atime, st.st_mtime + 10))
+        self.assertEqual(csv_cache.load(self.fname, kwds), None)
+        x = csv_cache.cached_loadtxt(self.fname, **kwds)
+        self.assertEqual(len(x), 3)
+        numpy.testing.assert_equal(x['a'], loadtxt(self.fname, **kwds)['a'])
+
+
+if __name__ == '__main__':
+    unittest.main()
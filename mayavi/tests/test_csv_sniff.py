@@ -16,6 +16,7 @@ from numpy import array, ndarray
 
 from mayavi.tools.data_wizards.csv_sniff import \
      Sniff, loadtxt, loadtxt_unknown, array2dict
+from mayavi.tools.data_wizards.loadtxt import fast_loadtxt
 
 
 class Util(object):
@@ -133,6 +134,119 @@ class Test(unittest.TestCase, Util):
         os.unlink(TESTFN)
 
 
+class TestFastLoadtxt(unittest.TestCase, Util):
+
+    def setUp(self):
+        fo = open(TESTFN, 'wb')
+        fo.write('# x, y, z\n"x", "y", "z"\n')
+        for i in range(500):
+            fo.write('%d, %r, %r  # row %d\n' % (i, i*0.5, -i*1e-3, i)
+                     if i % 100 == 0 else
+                     '%d, %r, %r\n' % (i, i*0.5, -i*1e-3))
+        fo.close()
+        self.kwds = {'comments': '#', 'delimiter': ',', 'skiprows': 2}
+
+    def tearDown(self):
+        os.unlink(TESTFN)
+
+    def test_same_as_loadtxt(self):
+        "Test if the chunked loader gives the same result as loadtxt."
+        dtype = {'names': ('x', 'y', 'z'), 'formats': (int, float, float)}
+        fractions = []
+        x = fast_loadtxt(TESTFN, dtype=dtype, chunk_size=256,
+                         progress=fractions.append, **self.kwds)
+        y = loadtxt(TESTFN, dtype=dtype, **self.kwds)
+        self.assertEqual(x.dtype, y.dtype)
+        self.assertNamedClose(x, y)
+        # The unused rows of the estimated size are not kept.
+        owner = x if x.base is None else x.base
+        self.assertEqual(owner.nbytes, x.nbytes)
+        self.assertTrue(len(fractions) > 1)
+        self.assertEqual(fractions, sorted(fractions))
+        self.assertEqual(fractions[-1], 1.0)
+
+    def test_usecols(self):
+        "Test the usecols and unpack options."
+        y, z = fast_loadtxt(TESTFN, usecols=(1, 2), unpack=True,
+                            chunk_size=100, **self.kwds)
+        self.assertEqual(len(y), 500)
+        self.assertAllClose(y[:3], [0.0, 0.5, 1.0])
+        self.assertAllClose(z[:3], [0.0, -1e-3, -2e-3])
+
+    def test_fallback(self):
+        "Test if files with strings are read by loadtxt."
+        fo = open(TESTFN, 'wb')
+        fo.write('Hello;54;87\nWorld;42;86.5')
+        fo.close()
+        kwds = Sniff(TESTFN).kwds()
+        self.assertNamedClose(fast_loadtxt(TESTFN, **kwds),
+                              loadtxt(TESTFN, **kwds))
+
+    def test_ragged_rows(self):
+        "Test if rows with a wrong number of values are not shifted."
+        fo = open(TESTFN, 'wb')
+        fo.write('1 2 3\n4 5\n6 7 8 9\n')
+        fo.close()
+        self.assertRaises((ValueError, IndexError), loadtxt, TESTFN)
+        self.assertRaises((ValueError, IndexError), fast_loadtxt, TESTFN)
+
+
+class TestSample(unittest.TestCase, Util):
+
+    def setUp(self):
+        fo = open(TESTFN, 'wb')
+        fo.write('"i", "x", "s"\n')
+        for i in range(5000):
+            # The strings get longer and the second column gets
+            # floats far from the head of the file.
+            x = i + 0.5 if i >= 4000 else i
+            fo.write('%d, %r, %s\n' % (i, x, 'a'*(1 + i//1000)))
+        fo.close()
+
+    def tearDown(self):
+        os.unlink(TESTFN)
+
+    def test_head_only(self):
+        s = Sniff(TESTFN)
+        self.assertEqual(s.sample_report(), None)
+        self.assertEqual(s.dtype()['formats'], (float, float, 'S1'))
+
+    def test_sample(self):
+        s = Sniff(TESTFN, sample_size=16*1024)
+        kwds = s.kwds()
+        self.assertEqual(kwds['skiprows'], 1)
+        self.assertEqual(kwds['dtype'],
+                         {'names': ('i', 'x', 's'),
+                          'formats': ('i8', float, 'S6')})
+        r = s.sample_report()
+        self.assertEqual(r['file_size'], os.path.getsize(TESTFN))
+        self.assertTrue(r['bytes_sampled'] <= 16*1024 + 1024)
+        self.assertEqual(r['irregular_lines'], 0)
+        names = [c[0] for c in r['columns']]
+        self.assertEqual(names, ['i', 'x', 's'])
+        conf = [c[2] for c in r['columns']]
+        # Blocks of integers agree with a float column but the strings
+        # are wider towards the end.
+        self.assertEqual(conf[:2], [1.0, 1.0])
+        self.assertTrue(conf[2] < 0.5)
+        self.assertEqual(r['confidence'], min(conf))
+
+        x = fast_loadtxt(TESTFN, **kwds)
+        self.assertEqual(len(x), 5000)
+        self.assertEqual(x['i'][-1], 4999)
+        self.assertEqual(x['s'][-1], ' aaaaa')
+        self.assertEqual(x['x'][-1], 4999.5)
+
+    def test_whole_file(self):
+        "Test if small files are read completely."
+        s = Sniff(TESTFN, sample_size=1024*1024)
+        r = s.sample_report()
+        self.assertEqual(r['bytes_sampled'], r['file_size'])
+        self.assertEqual(r['lines'], 5000)
+        self.assertEqual(r['confidence'], 1.0)
+        self.assertEqual(s.dtype()['formats'], ('i8', float, 'S6'))
+
+
 class Test_csv_py_files(unittest.TestCase, Util):
     """
         These tests require files in csv_files/
@@ -0,0 +1,69 @@
+"""
+Tests for the DataSourceFactory.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+import unittest
+import numpy
+
+from tvtk.api import tvtk
+from mayavi.tools.data_wizards.data_source_factory import \
+    DataSourceFactory, _interleave
+
+
+class TestDataSourceFactory(unittest.TestCase):
+
+    def setUp(self):
+        x, y, z = numpy.mgrid[0:3, 0:4, 0:5]
+        self.x = x + 0.5
+        self.y = numpy.asfortranarray(y, dtype=float)
+        self.z = z.astype(float)
+        self.s = numpy.random.random(x.shape)
+
+    def test_interleave(self):
+        "Test if the interleaved columns are those of c_."
+        points = _interleave(self.x, self.y, self.z)
+        expect = numpy.c_[self.x.ravel(), self.y.ravel(), self.z.ravel()]
+        self.assertTrue(numpy.all(points == expect))
+        self.assertTrue(points.flags.c_contiguous)
+
+    def test_polydata(self):
+        "Test the points and data of unstructured data."
+        src = DataSourceFactory().build_data_source(
+                    unstructured=True, position_x=self.x,
+                    position_y=self.y, position_z=self.z,
+                    scalar_data=self.s, has_vector_data=True,
+                    vector_u=self.x, vector_v=self.y, vector_w=self.z)
+        data = src.outputs[0]
+        self.assertTrue(isinstance(data, tvtk.PolyData))
+        points = data.points.to_array()
+        self.assertTrue(numpy.all(points[:, 1] == self.y.ravel()))
+        vectors = data.point_data.vectors.to_array()
+        self.assertTrue(numpy.all(vectors == points))
+        scalars = data.point_data.scalars.to_array()
+        self.assertTrue(numpy.all(scalars == self.s.ravel()))
+
+    def test_single_precision(self):
+        "Test if single precision output is given."
+        src = DataSourceFactory().build_data_source(
+                    single_precision=True, position_x=self.x,
+                    position_y=self.y, position_z=self.z,
+                    scalar_data=self.s)
+        data = src.outputs[0]
+        self.assertTrue(isinstance(data, tvtk.StructuredGrid))
+        self.assertEqual(data.points.to_array().dtype, numpy.float32)
+        scalars = data.point_data.scalars.to_array()
+        self.assertEqual(scalars.dtype, numpy.float32)
+        self.assertTrue(numpy.allclose(scalars, self.s.ravel()))
+
+    def test_image_data(self):
+        "Test if the scalars of image data are those of the ArraySource."
+        src = DataSourceFactory().build_data_source(scalar_data=self.s,
+                                                    position_implicit=True)
+        scalars = src.image_data.point_data.scalars.to_array()
+        self.assertTrue(numpy.all(scalars == self.s.T.ravel()))
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,198 @@
+"""
+Tests for the binary storage of datasets in saved visualizations.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+from os.path import abspath
+from StringIO import StringIO
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.core import dataset_store
+from mayavi.core.dataset_store import DatasetStore
+from mayavi.core.null_engine import NullEngine
+from mayavi.sources.vtk_data_source import VTKDataSource
+
+
+def make_image_data():
+    data = tvtk.ImageData(origin=(1, 2, 3), spacing=(0.5, 1, 2),
+                          dimensions=(3, 4, 5))
+    s = numpy.arange(60, dtype='int16')
+    data.point_data.scalars = s
+    data.point_data.scalars.name = 'scalars'
+    data.point_data.vectors = numpy.random.rand(60, 3)
+    data.point_data.vectors.name = 'vectors'
+    data.scalar_type = data.point_data.scalars.data_type
+    return data
+
+
+def make_poly_data():
+    points = numpy.random.rand(4, 3)
+    data = tvtk.PolyData(points=points, polys=[[0, 1, 2], [1, 2, 3]],
+                         lines=[[0, 3]])
+    data.point_data.scalars = numpy.arange(4.0)
+    data.point_data.scalars.name = 't'
+    data.cell_data.scalars = numpy.arange(3, dtype='int32')
+    data.cell_data.scalars.name = 'c'
+    return data
+
+
+def make_unstructured_grid():
+    points = numpy.random.rand(5, 3)
+    cells = numpy.array([4, 0, 1, 2, 3, 4, 1, 2, 3, 4])
+    ca = tvtk.CellArray()
+    ca.set_cells(2, cells)
+    ug = tvtk.UnstructuredGrid(points=points)
+    ug.set_cells(numpy.array([10, 10], 'uint8'), numpy.array([0, 5]), ca)
+    ug.point_data.scalars = numpy.arange(5.0)
+    ug.point_data.scalars.name = 's'
+    return ug
+
+
+def make_rectilinear_grid():
+    data = tvtk.RectilinearGrid(dimensions=(3, 2, 1))
+    data.x_coordinates = numpy.array([0.0, 1, 3])
+    data.y_coordinates = numpy.array([0.0, 2])
+    data.z_coordinates = numpy.array([0.0])
+    data.point_data.scalars = numpy.arange(6.0)
+    data.point_data.scalars.name = 's'
+    return data
+
+
+def make_structured_grid():
+    data = tvtk.StructuredGrid(dimensions=(2, 2, 1))
+    data.points = numpy.random.rand(4, 3)
+    data.point_data.vectors = numpy.random.rand(4, 3)
+    data.point_data.vectors.name = 'v'
+    return data
+
+
+class TestDatasetStore(unittest.TestCase):
+
+    def _round_trip(self, data, compress=False):
+        store = DatasetStore(compress)
+        ref = store.add_dataset(data)
+        self.assertTrue(dataset_store.is_reference(ref))
+        f = StringIO()
+        f.write('state')
+        store.write(f)
+        loaded = DatasetStore.from_buffer(f.getvalue())
+        self.assertEqual(loaded.state_size(), len('state'))
+        return loaded.get_dataset(ref)
+
+    def _check_attributes(self, data, out):
+        for kind in ('point_data', 'cell_data'):
+            a, b = getattr(data, kind), getattr(out, kind)
+            self.assertEqual(a.number_of_arrays, b.number_of_arrays)
+            for name in ('scalars', 'vectors'):
+                x, y = getattr(a, name), getattr(b, name)
+                if x is None:
+                    self.assertEqual(y, None)
+                    continue
+                self.assertEqual(x.name, y.name)
+                self.assertEqual(x.data_type, y.data_type)
+                testing.assert_array_equal(x.to_array(), y.to_array())
+
+    def test_image_data(self):
+        data = make_image_data()
+        for compress in (False, True):
+            out = self._round_trip(data, compress)
+            self.assertTrue(isinstance(out, tvtk.ImageData))
+            self.assertEqual(out.extent, data.extent)
+            self.assertEqual(out.origin, data.origin)
+            self.assertEqual(out.spacing, data.spacing)
+            self.assertEqual(out.scalar_type, data.scalar_type)
+            self._check_attributes(data, out)
+
+    def test_poly_data(self):
+        data = make_poly_data()
+        for compress in (False, True):
+            out = self._round_trip(data, compress)
+            testing.assert_array_equal(out.points.to_array(),
+                                       data.points.to_array())
+            self.assertEqual(out.polys.number_of_cells, 2)
+            self.assertEqual(out.lines.number_of_cells, 1)
+            testing.assert_array_equal(out.polys.to_array(),
+                                       data.polys.to_array())
+            self._check_attributes(data, out)
+
+    def test_unstructured_grid(self):
+        data = make_unstructured_grid()
+        for compress in (False, True):
+            out = self._round_trip(data, compress)
+            self.assertEqual(out.number_of_cells, 2)
+            self.assertEqual(list(out.get_cell_types_array().to_array()),
+                             [10, 10])
+            testing.assert_array_equal(out.get_cells().to_array(),
+                                       data.get_cells().to_array())
+            self._check_attributes(data, out)
+
+    def test_grids(self):
+        for data in (make_rectilinear_grid(), make_structured_grid()):
+            out = self._round_trip(data, True)
+            self.assertEqual(out.dimensions, data.dimensions)
+            self.assertEqual(out.bounds, data.bounds)
+            self._check_attributes(data, out)
+
+    def test_plain_state(self):
+        self.assertEqual(DatasetStore.from_buffer('a pickled state'),
+                         None)
+        self.assertEqual(DatasetStore.from_buffer(''), None)
+
+    def test_unsupported(self):
+        store = DatasetStore()
+        self.assertEqual(store.add_dataset(tvtk.MultiBlockDataSet()),
+                         None)
+
+
+class TestSaveVisualization(unittest.TestCase):
+
+    def setUp(self):
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+        self.data = make_image_data()
+        e.add_source(VTKDataSource(data=self.data))
+
+    def tearDown(self):
+        self.e.stop()
+
+    def _save_and_load(self, **kw):
+        e = self.e
+        f = StringIO()
+        f.name = abspath('test.mv2') # We simulate a file.
+        e.save_visualization(f, **kw)
+        f.seek(0)
+        e.close_scene(e.current_scene)
+        e.load_visualization(f)
+        self.assertEqual(dataset_store.get_active_store(), None)
+        src = e.current_scene.children[0]
+        out = src.data
+        self.assertEqual(out.dimensions, self.data.dimensions)
+        testing.assert_array_equal(out.point_data.scalars.to_array(),
+                                   self.data.point_data.scalars.to_array())
+        return f.getvalue()
+
+    def test_binary(self):
+        value = self._save_and_load()
+        self.assertEqual(value[-dataset_store.TRAILER.size:][:8],
+                         dataset_store.MAGIC)
+
+    def test_compressed(self):
+        self._save_and_load(compress=True)
+
+    def test_ascii(self):
+        value = self._save_and_load(binary_data=False)
+        self.assertNotEqual(value[-dataset_store.TRAILER.size:][:8],
+                            dataset_store.MAGIC)
+
+
+if __name__ == '__main__':
+    unittest.main()
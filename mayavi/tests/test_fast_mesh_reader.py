@@ -0,0 +1,145 @@
+"""
+Tests for the fast mesh file parsers.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+
+from mayavi.sources.fast_mesh_reader import parse_obj, parse_stl, \
+     parse_ply, parse_points, merge_points, make_poly_data, \
+     FastMeshReader
+
+
+class TestParsers(unittest.TestCase):
+
+    def test_obj(self):
+        "Test mixed polygons, texture indices and comments."
+        obj = '\n'.join(['# A square', 'v 0 0 0', 'v 1 0 0', 'vt 0.5 0.5',
+                         'v 1 1 0', 'v 0 1 0', 'f 1/1 2/1 3/1',
+                         'f 1//2 3 4 # comment', 'f 1 2 3 4', ''])
+        points, cells, n_cells, kind = parse_obj(obj, chunk_size=20)
+        self.assertEqual(points.shape, (4, 3))
+        self.assertEqual(n_cells, 3)
+        self.assertEqual(cells.tolist(),
+                         [3, 0, 1, 2, 3, 0, 2, 3, 4, 0, 1, 2, 3])
+        pd = make_poly_data(points, cells, n_cells, kind)
+        self.assertEqual(pd.number_of_polys, 3)
+        # Relative indices are left to the VTK reader.
+        self.assertEqual(parse_obj(obj + 'f -1 -2 -3\n'), None)
+        # So are indices past the last vertex.
+        self.assertEqual(parse_obj(obj + 'f 1 2 5\n'), None)
+
+    def test_stl(self):
+        "Test ASCII and binary STL files and the merging of points."
+        tris = [[[0, 0, 0], [1, 0, 0], [1, 1, 0]],
+                [[0, 0, 0], [1, 1, 0], [-0.0, 1, 0]]]
+        lines = ['solid s']
+        for tri in tris:
+            lines += ['facet normal 0 0 1', 'outer loop']
+            lines += ['vertex %r %r %r' % tuple(p) for p in tri]
+            lines += ['endloop', 'endfacet']
+        ascii = '\n'.join(lines + ['endsolid s', ''])
+        rec = numpy.zeros(2, [('n', '<f4', (3,)), ('p', '<f4', (3, 3)),
+                              ('a', '<u2')])
+        rec['p'] = tris
+        binary = '\0'*80 + numpy.array([2], '<u4').tostring() + \
+                 rec.tostring()
+        for buf in (ascii, binary):
+            points, cells, n_cells, kind = parse_stl(buf)
+            self.assertEqual(points.tolist(), [[0, 0, 0], [1, 0, 0],
+                                               [1, 1, 0], [0, 1, 0]])
+            self.assertEqual(cells.tolist(), [[0, 1, 2], [0, 2, 3]])
+        points, cells, n_cells, kind = parse_stl(ascii, merge=False)
+        self.assertEqual(len(points), 6)
+        # Padded binary files.
+        points, cells, n_cells, kind = parse_stl(binary + '\0'*16)
+        self.assertEqual(n_cells, 2)
+        # Files without any vertex are left to the VTK reader.
+        self.assertEqual(parse_stl('solid s\nendsolid s\n' + ' '*100),
+                         None)
+
+    def test_ply(self):
+        "Test ASCII and binary PLY files."
+        header = ['ply', 'format %s 1.0', 'element vertex 4',
+                  'property float x', 'property float y', 'property float z',
+                  'property uchar red', 'element face 2',
+                  'property list uchar int vertex_indices', 'end_header', '']
+        header = '\n'.join(header)
+        body = '0 0 0 1\n1 0 0 2\n1 1 0 3\n0 1 0 4\n3 0 1 2\n3 0 2 3\n'
+        v = numpy.array([(0, 0, 0, 1), (1, 0, 0, 2), (1, 1, 0, 3),
+                         (0, 1, 0, 4)], [('x', '>f4'), ('y', '>f4'),
+                                         ('z', '>f4'), ('red', 'u1')])
+        f = numpy.array([(3, (0, 1, 2)), (3, (0, 2, 3))],
+                        [('n', 'u1'), ('i', '>i4', (3,))])
+        for buf in (header % 'ascii' + body,
+                    header % 'binary_big_endian' + v.tostring() +
+                    f.tostring()):
+            points, cells, n_cells, kind = parse_ply(buf)
+            self.assertEqual(points[:, 0].tolist(), [0, 1, 1, 0])
+            self.assertEqual(cells.tolist(), [[0, 1, 2], [0, 2, 3]])
+        # Faces of different sizes.
+        buf = header % 'ascii' + body.replace('3 0 2 3', '4 0 1 2 3')
+        points, cells, n_cells, kind = parse_ply(buf)
+        self.assertEqual(n_cells, 2)
+        self.assertEqual(cells.tolist(), [3, 0, 1, 2, 4, 0, 1, 2, 3])
+        # Indices past the last vertex are left to the VTK reader.
+        self.assertEqual(parse_ply(header % 'ascii' +
+                                   body.replace('3 0 2 3', '3 0 2 4')),
+                         None)
+        self.assertEqual(parse_ply(header % 'ascii' +
+                                   body.replace('3 0 2 3', '4 0 1 2 4')),
+                         None)
+        f['i'][1] = (0, 2, 4)
+        self.assertEqual(parse_ply(header % 'binary_big_endian' +
+                                   v.tostring() + f.tostring()), None)
+
+    def test_points(self):
+        points, cells, n_cells, kind = parse_points('0 0 0\n1 2 3\n4 5 6\n',
+                                                    chunk_size=4)
+        self.assertEqual(points.tolist(), [[0, 0, 0], [1, 2, 3], [4, 5, 6]])
+        self.assertEqual(kind, 'verts')
+        self.assertEqual(n_cells, 3)
+
+    def test_merge_points(self):
+        points = numpy.array([[1, 2, 3], [0, 0, 0], [1, 2, 3], [-0.0, 0, 0]],
+                             'f')
+        uniq, index = merge_points(points)
+        self.assertEqual(uniq.tolist(), [[1, 2, 3], [0, 0, 0]])
+        self.assertEqual(index.tolist(), [0, 1, 0, 1])
+
+
+class TestFastMeshReader(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        self.fname = os.path.join(self.root, 'points.txt')
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def _write(self, text):
+        f = open(self.fname, 'w')
+        f.write(text)
+        f.close()
+
+    def test_reload(self):
+        "Test if the output is updated in place on a reload."
+        self._write('0 0 0\n1 2 3\n')
+        r = FastMeshReader(file_name=self.fname)
+        r.update()
+        output = r.output
+        self.assertEqual(output.number_of_points, 2)
+        self._write('0 0 0\n1 2 3\n4 5 6\n')
+        r.update()
+        self.assertTrue(r.output is output)
+        self.assertEqual(output.number_of_points, 3)
+
+
+if __name__ == '__main__':
+    unittest.main()
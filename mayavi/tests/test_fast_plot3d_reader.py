@@ -0,0 +1,124 @@
+"""
+Tests for the fast PLOT3D reader.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Local imports.
+from common import get_example_data
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.sources.fast_plot3d_reader import FastPLOT3DReader, \
+     grid_layout, q_layout, Block
+from mayavi.sources.plot3d_reader import PLOT3DReader
+
+
+class TestFastPLOT3DReader(unittest.TestCase):
+
+    def setUp(self):
+        self.xyz = get_example_data('tiny.xyz')
+        self.q = get_example_data('tiny.q')
+
+    def _vtk_reader(self):
+        r = tvtk.PLOT3DReader(xyz_file_name=self.xyz, q_file_name=self.q,
+                              has_byte_count=True, multi_grid=True,
+                              byte_order='little_endian')
+        r.update()
+        return r
+
+    def test_layout(self):
+        "Test if the layout of the files is found."
+        grid = grid_layout(open(self.xyz, 'rb').read())
+        self.assertEqual(grid['endian'], '<')
+        self.assertTrue(grid['records'])
+        self.assertTrue(grid['multi_grid'])
+        self.assertEqual(grid['dims'], [(2, 2, 2)]*5)
+        self.assertFalse(grid['iblank'])
+        q = q_layout(open(self.q, 'rb').read(), grid)
+        self.assertEqual(q['n_vars'], 5)
+        self.assertEqual(grid_layout('not a plot3d file'), None)
+
+    def test_same_as_vtk(self):
+        "Test if the points and functions match the VTK reader."
+        vr = self._vtk_reader()
+        fr = FastPLOT3DReader(xyz_file_name=self.xyz, q_file_name=self.q)
+        fr.update()
+        self.assertEqual(len(fr.outputs), 5)
+        for i, sg in enumerate(fr.outputs):
+            out = vr.get_output(i)
+            testing.assert_allclose(sg.points.to_array(),
+                                    out.points.to_array())
+            testing.assert_allclose(sg.point_data.scalars.to_array(),
+                                    out.point_data.scalars.to_array())
+            testing.assert_allclose(sg.point_data.vectors.to_array(),
+                                    out.point_data.vectors.to_array(),
+                                    rtol=1e-6)
+
+    def test_functions_without_reading(self):
+        "Test if changing the functions does not read the files."
+        fr = FastPLOT3DReader(xyz_file_name=self.xyz, q_file_name=self.q)
+        fr.update()
+        blocks = fr._blocks
+        density = blocks[0].density
+        fr.scalar_function_number = 110
+        fr.vector_function_number = 200
+        fr.update()
+        self.assertTrue(fr._blocks is blocks)
+        self.assertTrue(fr._blocks[0].density is density)
+        pd = fr.outputs[0].point_data
+        self.assertEqual(pd.scalars.name, 'Pressure')
+        self.assertEqual(pd.vectors.name, 'Velocity')
+
+    def test_vorticity(self):
+        "Test the vorticity on a sheared grid."
+        x, y, z = numpy.mgrid[0:1:5j, 0:2:6j, 0:1:4j]
+        x = x + 0.3*y
+        points = numpy.column_stack([a.ravel(order='F')
+                                     for a in (x, y, z)])
+        b = Block((5, 6, 4), points)
+        n = len(points)
+        b.density = numpy.ones(n)
+        b.energy = 10*numpy.ones(n)
+        b.momentum = numpy.column_stack((-points[:, 1], points[:, 0],
+                                         numpy.zeros(n)))
+        testing.assert_allclose(b.vector(201), [[0.0, 0.0, 2.0]]*n,
+                                atol=1e-12)
+        testing.assert_allclose(b.scalar(144),
+                                0.5*(points[:, :2]**2).sum(axis=1))
+
+    def test_plot3d_reader(self):
+        "Test the fast reader of the PLOT3DReader source."
+        r = PLOT3DReader(use_fast_reader=True)
+        r.initialize(self.xyz, self.q, configure=False)
+        self.assertTrue(r._using_fast_reader)
+        self.assertEqual(len(r.outputs), 5)
+        self.assertEqual(r.outputs[1].bounds,
+                         (2.0, 3.0, 1.0, 2.0, 1.0, 2.0))
+        blocks = r._fast_reader._blocks
+        r.scalars_name = 'pressure'
+        self.assertTrue(r._fast_reader._blocks is blocks)
+        self.assertEqual(r.outputs[0].point_data.scalars.name, 'Pressure')
+        # Files the fast reader does not know are read by VTK.
+        root = tempfile.mkdtemp()
+        try:
+            fname = os.path.join(root, 'bad.xyz')
+            open(fname, 'w').write('1 2 3\n')
+            fr = r._fast_reader
+            fr.xyz_file_name = fname
+            self.assertRaises(ValueError, fr.update)
+        finally:
+            shutil.rmtree(root)
+
+
+if __name__ == '__main__':
+    unittest.main()
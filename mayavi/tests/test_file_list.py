@@ -0,0 +1,104 @@
+"""
+Tests for the discovery of the files of a time series.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import json
+import shutil
+import tempfile
+import unittest
+
+# Local imports.
+from mayavi.core.file_data_source import get_file_list, get_manifest_name
+
+
+class TestGetFileList(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        for name in ('foo1.vtk', 'foo10.vtk', 'foo2.vtk', 'foo2s.vtk',
+                     'bar1.vtk', 'foo3.vti'):
+            self._touch(name)
+
+    def tearDown(self):
+        shutil.rmtree(self.tmpdir)
+
+    def _touch(self, name):
+        f = open(os.path.join(self.tmpdir, name), 'w')
+        f.write(name)
+        f.close()
+
+    def _names(self, files):
+        return [os.path.basename(x) for x in files]
+
+    def test_sort(self):
+        "Test if the series is found and sorted on the index."
+        files = get_file_list(os.path.join(self.tmpdir, 'foo2.vtk'))
+        self.assertEqual(self._names(files),
+                         ['foo1.vtk', 'foo2.vtk', 'foo10.vtk'])
+        self.assertEqual(os.path.dirname(files[0]), self.tmpdir)
+
+    def test_missing_directory(self):
+        "Test if a missing directory gives an empty series."
+        fname = os.path.join(self.tmpdir, 'nothing', 'foo1.vtk')
+        self.assertEqual(get_file_list(fname), [])
+
+    def _age_manifest(self, mname, dir_mtime):
+        """Makes the manifest look saved well after the last change of
+        the directory."""
+        os.utime(mname, (dir_mtime + 10, dir_mtime + 10))
+
+    def test_manifest(self):
+        "Test if the manifest is written, reused and updated."
+        fname = os.path.join(self.tmpdir, 'foo1.vtk')
+        files = get_file_list(fname, manifest=True)
+        mname = get_manifest_name(fname)
+        self.assertTrue(os.path.exists(mname))
+        self.assertEqual(get_file_list(fname), files)
+
+        # The manifest is used as long as the directory is unchanged.
+        f = open(mname)
+        m = json.load(f)
+        f.close()
+        self.assertEqual([x[1] for x in m['files']],
+                         self._names(files))
+        self.assertEqual(m['files'][0], [1, 'foo1.vtk'])
+        m['files'] = m['files'][:1]
+        f = open(mname, 'w')
+        json.dump(m, f)
+        f.close()
+        self._age_manifest(mname, m['dir_mtime'])
+        self.assertEqual(self._names(get_file_list(fname, manifest=True)),
+                         ['foo1.vtk'])
+
+        # New files are picked up once the directory changes.
+        self._touch('foo5.vtk')
+        st = os.stat(self.tmpdir)
+        os.utime(self.tmpdir, (st.st_atime, m['dir_mtime'] + 10))
+        self.assertEqual(self._names(get_file_list(fname, manifest=True)),
+                         ['foo1.vtk', 'foo2.vtk', 'foo5.vtk',
+                          'foo10.vtk'])
+
+    def test_fresh_manifest(self):
+        "Test if a manifest saved with the last change is not trusted."
+        fname = os.path.join(self.tmpdir, 'foo1.vtk')
+        files = get_file_list(fname, manifest=True)
+        mname = get_manifest_name(fname)
+        f = open(mname)
+        m = json.load(f)
+        f.close()
+        # A file added in the same tick as the manifest was saved.
+        self._touch('foo5.vtk')
+        st = os.stat(self.tmpdir)
+        os.utime(self.tmpdir, (st.st_atime, m['dir_mtime']))
+        os.utime(mname, (m['dir_mtime'], m['dir_mtime']))
+        self.assertEqual(self._names(get_file_list(fname, manifest=True)),
+                         ['foo1.vtk', 'foo2.vtk', 'foo5.vtk',
+                          'foo10.vtk'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,172 @@
+"""
+Tests for the lazy loading of saved visualizations.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+from os.path import abspath
+from StringIO import StringIO
+import tempfile
+import unittest
+
+import numpy
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.core import dataset_store
+from mayavi.core.null_engine import NullEngine
+from mayavi.sources.vtk_data_source import VTKDataSource
+from mayavi.modules.outline import Outline
+
+
+def make_data(n):
+    data = tvtk.ImageData(dimensions=(n, n, n))
+    data.point_data.scalars = numpy.arange(n**3, dtype=float)
+    data.point_data.scalars.name = 'scalars'
+    return data
+
+
+class TestLazyLoad(unittest.TestCase):
+
+    def setUp(self):
+        e = NullEngine()
+        e.start()
+        # Three scenes, the source of the second one is hidden.
+        for i in range(3):
+            e.new_scene()
+            src = VTKDataSource(data=make_data(i + 2))
+            e.add_source(src)
+            e.add_module(Outline())
+            if i == 1:
+                src.visible = False
+        f = StringIO()
+        f.name = abspath('test.mv2') # We simulate a file.
+        e.save_visualization(f)
+        f.seek(0)
+        e.stop()
+
+        self.e = NullEngine()
+        self.e.start()
+        self.progress = []
+        self.e.on_trait_change(self._on_progress, 'load_progress')
+        self.e.load_visualization(f, lazy=True)
+
+    def tearDown(self):
+        self.e.stop()
+
+    def _on_progress(self, value):
+        self.progress.append(value)
+
+    def _check_restored(self, scene, n):
+        self.assertTrue(scene.running)
+        src = scene.children[0]
+        self.assertTrue(src.running)
+        self.assertEqual(src.data.dimensions, (n, n, n))
+        mm = src.children[0]
+        self.assertTrue(isinstance(mm.children[0], Outline))
+
+    def test_tree(self):
+        e = self.e
+        self.assertEqual(len(e.scenes), 3)
+        for scene in e.scenes:
+            self.assertEqual(len(scene.children), 1)
+            self.assertTrue(isinstance(scene.children[0], VTKDataSource))
+        self.assertEqual(e.scenes[1].children[0].visible, False)
+        self.assertTrue(1.0 in self.progress)
+
+    def test_only_current_scene_loaded(self):
+        e = self.e
+        self.assertTrue(e.current_scene is e.scenes[-1])
+        self._check_restored(e.scenes[-1], 4)
+        scene = e.scenes[0]
+        self.assertFalse(scene.running)
+        self.assertEqual(scene.children[0].data, None)
+
+        # Activating the scene loads it.
+        e.current_scene = scene
+        self._check_restored(scene, 2)
+
+    def test_hidden_loaded_when_shown(self):
+        e = self.e
+        scene = e.scenes[1]
+        e.current_scene = scene
+        src = scene.children[0]
+        self.assertTrue(src.running)
+        self.assertEqual(src.data, None)
+        src.visible = True
+        self._check_restored(scene, 3)
+        self.assertTrue(src.visible)
+
+    def test_load_deferred(self):
+        e = self.e
+        e.load_deferred()
+        self._check_restored(e.scenes[0], 2)
+        src = e.scenes[1].children[0]
+        self.assertEqual(src.data.dimensions, (3, 3, 3))
+        self.assertEqual(src.visible, False)
+
+    def test_save_loads_deferred(self):
+        e = self.e
+        f = StringIO()
+        f.name = abspath('test.mv2')
+        e.save_visualization(f)
+        f.seek(0)
+        e2 = NullEngine()
+        e2.start()
+        e2.load_visualization(f)
+        self.assertEqual(len(e2.scenes), 3)
+        self._check_restored(e2.scenes[0], 2)
+        e2.stop()
+
+
+class TestLazyLoadFile(unittest.TestCase):
+
+    def setUp(self):
+        e = NullEngine()
+        e.start()
+        for i in range(2):
+            e.new_scene()
+            e.add_source(VTKDataSource(data=make_data(i + 2)))
+        fd, self.fname = tempfile.mkstemp(suffix='.mv2')
+        os.close(fd)
+        e.save_visualization(self.fname)
+        e.stop()
+        self.e = NullEngine()
+        self.e.start()
+        self.e.load_visualization(self.fname, lazy=True)
+
+    def tearDown(self):
+        self.e.stop()
+        os.remove(self.fname)
+
+    def _store(self):
+        return self.e._deferred_scenes[self.e.scenes[0]][1]
+
+    def test_file_released(self):
+        "Test if the file is not mapped while scenes are deferred."
+        e = self.e
+        store = self._store()
+        self.assertEqual(store._buf, None)
+        e.current_scene = e.scenes[0]
+        self.assertEqual(e.scenes[0].children[0].data.dimensions,
+                         (2, 2, 2))
+        self.assertEqual(store._buf, None)
+
+    def test_changed_file(self):
+        "Test if a file changed after loading is not read."
+        e = self.e
+        store = self._store()
+        f = open(self.fname, 'ab')
+        f.write('x'*16)
+        f.close()
+        self.assertRaises(IOError, store.get_dataset,
+                          dataset_store.REF_PREFIX + '0')
+        # The error is not swallowed when the scene is shown.
+        self.assertRaises(IOError, setattr, e, 'current_scene',
+                          e.scenes[0])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,107 @@
+"""
+Tests for the memory report of the pipeline.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import unittest
+
+import numpy
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.core.null_engine import NullEngine
+from mayavi.core.memory_report import MemoryReport, _dataset_arrays
+from mayavi.sources.vtk_data_source import VTKDataSource
+from mayavi.filters.poly_data_normals import PolyDataNormals
+from mayavi.modules.outline import Outline
+from mayavi.modules.surface import Surface
+
+
+class TestMemoryReport(unittest.TestCase):
+
+    def setUp(self):
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+
+        x, y = numpy.mgrid[0:1:50j, 0:1:50j]
+        sp = tvtk.StructuredPoints(dimensions=(50, 50, 1),
+                                   origin=(0, 0, 0), spacing=(1, 1, 1))
+        self.scalars = numpy.ravel(x*y)
+        sp.point_data.scalars = self.scalars
+        sp.point_data.scalars.name = 'scalars'
+        self.src = VTKDataSource(data=sp)
+        e.add_source(self.src)
+        self.normals = PolyDataNormals()
+        e.add_filter(self.normals)
+        e.add_module(Surface())
+        e.add_module(Outline(), self.src)
+
+    def tearDown(self):
+        self.e.stop()
+
+    def test_tree(self):
+        "Test if the report mirrors the pipeline tree."
+        report = self.e.memory_report()
+        d = report.to_dict()
+        self.assertEqual(d['path'], 'engine')
+        scene = d['children'][0]
+        self.assertEqual(scene['path'], 'engine.scenes[0]')
+        src = scene['children'][0]
+        self.assertEqual(src['path'], 'engine.scenes[0].children[0]')
+        self.assertEqual(src['type'], 'VTKDataSource')
+        self.assertEqual(src['n_datasets'], 1)
+        self.assertTrue(src['bytes'] >= self.scalars.nbytes)
+        self.assertEqual(d['total_bytes'], report.total_bytes)
+        names = [node.name for depth, node in report.nodes()]
+        self.assertEqual(len(names), len(set(id(n) for d, n in
+                                             report.nodes())))
+        # The table has a header, a separator and one line per node.
+        self.assertEqual(len(str(report).splitlines()), len(names) + 2)
+
+    def test_pinned_and_shared(self):
+        "Test if pinned and shared arrays are accounted correctly."
+        d = self.e.memory_report().to_dict()
+        src = d['children'][0]['children'][0]
+        # The scalars are passed to VTK without a copy.
+        self.assertTrue(src['pinned_bytes'] >= self.scalars.nbytes)
+        # A second source sharing the same scalars array only reports
+        # them as shared.
+        sp = tvtk.StructuredPoints(dimensions=(50, 50, 1),
+                                   origin=(0, 0, 0), spacing=(1, 1, 1))
+        sp.point_data.scalars = self.src.data.point_data.scalars
+        src2 = VTKDataSource(data=sp)
+        self.e.add_source(src2)
+        d = self.e.memory_report().to_dict()
+        d2 = d['children'][0]['children'][1]
+        self.assertEqual(d2['pinned_bytes'], 0)
+        self.assertTrue(d2['shared_bytes'] >= self.scalars.nbytes)
+        self.assertTrue(d2['bytes'] < self.scalars.nbytes)
+        # The total is the sum of what each node owns.
+        def _sum(node):
+            return node['bytes'] + sum(_sum(c) for c in node['children'])
+        self.assertEqual(_sum(d), d['total_bytes'])
+
+    def test_sub_tree(self):
+        "Test if a report can be made for part of the pipeline."
+        report = MemoryReport(self.normals, 'normals')
+        d = report.to_dict()
+        self.assertEqual(d['path'], 'normals')
+        self.assertEqual(d['type'], 'PolyDataNormals')
+        self.assertEqual(d['shared_bytes'], 0)
+
+    def test_composite(self):
+        "Test if the arrays of the blocks of composite data are found."
+        mb = tvtk.MultiBlockDataSet()
+        mb.set_block(0, self.src.data)
+        mb.set_block(1, tvtk.PolyData())
+        arrays = _dataset_arrays(tvtk.to_vtk(mb))
+        scalars = tvtk.to_vtk(self.src.data.point_data.scalars)
+        self.assertTrue(scalars.__this__ in [a.__this__ for a in arrays])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -253,6 +253,18 @@ class TestMlabHelperFunctions(TestMlabNullEngine):
         for bar in bar1, bar2, bar3:
             self.assertEqual(bar.glyph.glyph_source.glyph_source.y_length, 0.9)
 
+    def test_implicit_geometry(self):
+        x, y = np.mgrid[0:1:5j, 0:2:7j]
+        z = np.zeros_like(x)
+        m = mlab.mesh(x, y, z)
+        self.assertEqual(m.mlab_source.geometry, 'explicit')
+        m = mlab.mesh(x, y, z, implicit_geometry=True)
+        self.assertEqual(m.mlab_source.geometry, 'uniform')
+        self.assertEqual(m.mlab_source.dataset.class_name, 'vtkImageData')
+        # Functions deriving from mesh accept it too.
+        mlab.triangular_mesh(x.ravel()[:3], y.ravel()[:3], z.ravel()[:3],
+                             [(0, 1, 2)], implicit_geometry=True)
+
 
 
 ################################################################################
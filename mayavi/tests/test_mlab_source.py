@@ -8,6 +8,7 @@ Test for MlabSource and its subclasses.
 import unittest
 import numpy as N
 
+from tvtk.api import tvtk
 from mayavi.tools import sources
 
 ################################################################################
@@ -663,6 +664,147 @@ class TestMGridSource(unittest.TestCase):
         self.check_traits()
         self.check_dataset()
 
+################################################################################
+# `TestMGridSourceImplicit`
+################################################################################
+class TestMGridSourceImplicit(unittest.TestCase):
+    def test_uniform(self):
+        "Does an mgrid plane give ImageData?"
+        x, y = N.mgrid[0:1:5j, 0:2:7j]
+        z = N.zeros_like(x)
+        s = x*y
+        src = sources.MGridSource(implicit_geometry=True)
+        src.reset(x=x, y=y, z=z, scalars=s)
+        self.assertEqual(src.geometry, 'uniform')
+        self.assertEqual(src.points, None)
+        ds = src.dataset
+        self.assertEqual(ds.class_name, 'vtkImageData')
+        self.assertEqual(tuple(ds.dimensions), (5, 7, 1))
+        self.assertEqual(N.allclose(ds.spacing, (0.25, 1./3, 1.0)), True)
+        sc = ds.point_data.scalars.to_array()
+        self.assertEqual(N.allclose(sc, s.T.ravel()), True)
+
+    def test_rectilinear(self):
+        "Does a non uniform meshgrid give a RectilinearGrid?"
+        x, y = N.meshgrid(N.linspace(0, 1, 5), N.logspace(0, 1, 4))
+        z = N.ones_like(x)
+        src = sources.MGridSource(implicit_geometry=True)
+        src.reset(x=x, y=y, z=z, scalars=x + y)
+        self.assertEqual(src.geometry, 'rectilinear')
+        ds = src.dataset
+        self.assertEqual(ds.class_name, 'vtkRectilinearGrid')
+        self.assertEqual(tuple(ds.dimensions), (5, 4, 1))
+        self.assertEqual(N.allclose(ds.y_coordinates.to_array(),
+                                    N.logspace(0, 1, 4)), True)
+        sc = ds.point_data.scalars.to_array()
+        self.assertEqual(N.allclose(sc, (x + y).ravel()), True)
+
+    def test_switch_to_explicit(self):
+        "Is the geometry made explicit when the surface is not a plane?"
+        x, y = N.mgrid[0:1:5j, 0:2:7j]
+        z = N.zeros_like(x)
+        src = sources.MGridSource(implicit_geometry=True)
+        src.reset(x=x, y=y, z=z, scalars=z)
+        self.assertEqual(src.geometry, 'uniform')
+        src.z = x*y
+        self.assertEqual(src.geometry, 'explicit')
+        pts = src.dataset.points.to_array()
+        self.assertEqual(N.allclose(pts[:,2], (x*y).ravel()), True)
+
+    def test_disabled_by_default(self):
+        "Are the points kept unless the detection is asked for?"
+        x, y = N.mgrid[0:1:5j, 0:2:7j]
+        src = sources.MGridSource()
+        src.reset(x=x, y=y, z=N.zeros_like(x))
+        self.assertEqual(src.geometry, 'explicit')
+        self.assertEqual(src.dataset.class_name, 'vtkPolyData')
+        self.assertEqual(src.points.shape, (35, 3))
+
+
+################################################################################
+# `TestMArraySourceRectilinear`
+################################################################################
+class TestMArraySourceRectilinear(unittest.TestCase):
+    def test_rectilinear(self):
+        "Do non uniform coordinates give a RectilinearGrid?"
+        xc = N.array([0., 1., 3., 7.])
+        x, y, z = N.ix_(xc, N.arange(3.), N.arange(2.))
+        s = N.random.random((4, 3, 2))
+        src = sources.MArraySource(implicit_geometry=True)
+        src.reset(x=x, y=y, z=z, scalars=s)
+        self.assertEqual(src.geometry, 'rectilinear')
+        self.assertEqual(src.m_data, None)
+        ds = src.dataset
+        self.assertEqual(tuple(ds.dimensions), (4, 3, 2))
+        self.assertEqual(N.allclose(ds.x_coordinates.to_array(), xc), True)
+        sc = ds.point_data.scalars.to_array()
+        self.assertEqual(N.allclose(sc, s.T.ravel()), True)
+        # Change the scalars.
+        src.scalars = s*2
+        sc = src.dataset.point_data.scalars.to_array()
+        self.assertEqual(N.allclose(sc, 2*s.T.ravel()), True)
+
+    def test_image_data_by_default(self):
+        "Is an ImageData created unless the detection is asked for?"
+        xc = N.array([0., 1., 3., 7.])
+        x, y, z = N.ix_(xc, N.arange(3.), N.arange(2.))
+        src = sources.MArraySource()
+        src.reset(x=x, y=y, z=z, scalars=N.random.random((4, 3, 2)))
+        self.assertEqual(src.geometry, 'uniform')
+        self.assertEqual(src.dataset.class_name, 'vtkImageData')
+        self.assertNotEqual(src.m_data, None)
+
+
+################################################################################
+# `TestPrecision`
+################################################################################
+class TestPrecision(unittest.TestCase):
+    def test_glyph_source(self):
+        "Is the data stored as float32 with single precision?"
+        x, y, z = N.random.random((3, 10))
+        s = N.random.random(10)
+        src = sources.MGlyphSource(precision='single')
+        src.reset(x=x, y=y, z=z, u=x, v=y, w=z, scalars=s)
+        self.assertEqual(src.points.dtype, N.float32)
+        self.assertEqual(src.vectors.dtype, N.float32)
+        self.assertEqual(src.scalars.dtype, N.float32)
+        pts = src.dataset.points.to_array()
+        self.assertEqual(pts.dtype, N.float32)
+        self.assertEqual(N.allclose(pts[:,1], y), True)
+        # Setting new scalars also converts them.
+        src.scalars = s*2
+        self.assertEqual(src.scalars.dtype, N.float32)
+        report = src.memory_report()
+        self.assertEqual(report['precision'], 'single')
+        self.assertEqual(report['saved'], 4*(30 + 30 + 10))
+        self.assertEqual(report['nbytes'], 4*(30 + 30 + 10))
+
+    def test_array_source(self):
+        "Is single precision array data laid out correctly?"
+        x, y, z = N.ogrid[0:4, 0:3, 0:2]
+        s = N.random.random((4, 3, 2))
+        v = N.random.random((4, 3, 2, 3))
+        src = sources.MArraySource(precision='single')
+        src.reset(x=x, y=y, z=z, u=v[...,0], v=v[...,1], w=v[...,2],
+                  scalars=s)
+        self.assertEqual(src.scalars.dtype, N.float32)
+        sc = src.dataset.point_data.scalars.to_array()
+        self.assertEqual(sc.dtype, N.float32)
+        self.assertEqual(N.allclose(sc, s.T.ravel()), True)
+        vec = src.dataset.point_data.vectors.to_array()
+        v1 = v.transpose((2, 1, 0, 3)).reshape((-1, 3))
+        self.assertEqual(N.allclose(vec, v1), True)
+
+    def test_default(self):
+        "Is the data left alone with double precision?"
+        x, y, z = N.random.random((3, 10))
+        src = sources.MGlyphSource()
+        src.reset(x=x, y=y, z=z)
+        self.assertEqual(src.precision, 'double')
+        self.assertEqual(src.points.dtype, N.float64)
+        self.assertEqual(src.memory_report()['saved'], 0)
+
+
 ################################################################################
 # `TestMArray2DSourceNoArgs`
 ################################################################################
@@ -842,6 +984,38 @@ class TestMTriangularMeshSource(unittest.TestCase):
         self.check_traits()
 
 
+    def test_connectivity_reuse(self):
+        "Is the connectivity kept when the triangles are unchanged?"
+        x, y, z, triangles, s, src = self.get_data()
+        polys = tvtk.to_vtk(src.dataset.polys)
+        src.reset(x=x*2, y=y, z=z, triangles=triangles.copy(), scalars=s)
+        self.assertEqual(tvtk.to_vtk(src.dataset.polys).__this__,
+                         polys.__this__)
+        # Changed triangles must be used.
+        src.reset(triangles=triangles[:, ::-1].copy())
+        self.assertNotEqual(tvtk.to_vtk(src.dataset.polys).__this__,
+                            polys.__this__)
+        # Even when they have the same Adler-32 checksum.
+        src.reset(triangles=N.array([[0, 1, 2], [1, 1, 0]]))
+        src.reset(triangles=N.array([[1, 0, 2], [1, 0, 1]]))
+        self.assertEqual(src.dataset.polys.to_array().tolist(),
+                         [3, 1, 0, 2, 3, 1, 0, 1])
+
+    def test_update_points_only(self):
+        "Test the update_points_only method."
+        x, y, z, triangles, s, src = self.get_data()
+        points = N.random.random((3, 3))
+        src.update_points_only(points=points)
+        pts = src.dataset.points.to_array()
+        self.assertEqual(N.allclose(pts, points), True)
+        self.assertEqual(N.allclose(src.x, points[:,0]), True)
+        src.update_points_only(z=N.array([5., 6., 7.]))
+        pts = src.dataset.points.to_array()
+        self.assertEqual(N.allclose(pts[:,2], [5, 6, 7]), True)
+        self.assertEqual(N.allclose(pts[:,0], points[:,0]), True)
+        self.assertRaises(AssertionError, src.update_points_only,
+                          x=N.zeros(4))
+
     def test_set(self):
         "Test if the set method works correctly."
         x, y, z, triangles, s, src = self.get_data()
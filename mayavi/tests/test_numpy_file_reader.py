@@ -0,0 +1,119 @@
+"""
+Tests for the NumPy file reader.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from mayavi.core.registry import registry
+from mayavi.sources.numpy_file_reader import NumpyFileReader, \
+     load_arrays, image_layout
+
+
+class TestNumpyFileReader(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        self.s = numpy.random.random((3, 4, 5))
+        self.v = numpy.random.random((3, 4, 5, 3))
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def _path(self, name):
+        return os.path.join(self.root, name)
+
+    def test_load_arrays(self):
+        "Test if the arrays of .npy and .npz files are memory-mapped."
+        numpy.save(self._path('a.npy'), self.s)
+        numpy.savez(self._path('b.npz'), s=self.s, v=self.v)
+        numpy.savez_compressed(self._path('c.npz'), s=self.s)
+        arrays = load_arrays(self._path('a.npy'))
+        self.assertEqual([a[0] for a in arrays], ['scalar'])
+        self.assertTrue(isinstance(arrays[0][1], numpy.memmap))
+        arrays = dict(load_arrays(self._path('b.npz')))
+        self.assertEqual(sorted(arrays.keys()), ['s', 'v'])
+        for name, arr in arrays.items():
+            self.assertTrue(isinstance(arr, numpy.memmap))
+            testing.assert_equal(arr, getattr(self, name))
+        # Compressed arrays are read.
+        arrays = dict(load_arrays(self._path('c.npz')))
+        testing.assert_equal(arrays['s'], self.s)
+
+    def test_image_layout(self):
+        "Test the point order and the copies of the image layout."
+        f = numpy.asfortranarray(self.s)
+        dims, flat = image_layout(f)
+        self.assertEqual(dims, (3, 4, 5))
+        self.assertEqual(flat[1 + 3*(2 + 4*3)], self.s[1, 2, 3])
+        self.assertTrue(numpy.may_share_memory(flat, f))
+        dims, flat = image_layout(self.s, transpose=False)
+        self.assertEqual(dims, (5, 4, 3))
+        self.assertTrue(numpy.may_share_memory(flat, self.s))
+        dims, flat = image_layout(self.v, transpose=False)
+        self.assertEqual(flat.shape, (60, 3))
+        testing.assert_equal(flat[1 + 5*(2 + 4*1)], self.v[1, 2, 1])
+        dims, flat = image_layout(self.v)
+        self.assertEqual(dims, (3, 4, 5))
+        testing.assert_equal(flat[1 + 3*(2 + 4*3)], self.v[1, 2, 3])
+
+    def test_reader(self):
+        "Test the reader on a time series of .npz files."
+        for i in range(2):
+            numpy.savez(self._path('data_%d.npz' % i), s=self.s + i,
+                        v=self.v)
+        r = NumpyFileReader()
+        r.initialize(self._path('data_0.npz'))
+        self.assertEqual(len(r.file_list), 2)
+        img = r.outputs[0]
+        self.assertEqual(tuple(img.dimensions), (3, 4, 5))
+        self.assertEqual(r.scalars_name, 's')
+        self.assertEqual(r.vectors_name, 'v')
+        sc = img.point_data.scalars.to_array()
+        self.assertEqual(sc[1 + 3*(2 + 4*3)], self.s[1, 2, 3])
+        changes = []
+        r.on_trait_change(lambda: changes.append(1), 'pipeline_changed')
+        r.timestep = 1
+        # The image is updated in place.
+        self.assertTrue(r.outputs[0] is img)
+        self.assertEqual(changes, [])
+        sc = r.outputs[0].point_data.scalars.to_array()
+        self.assertEqual(sc[0], self.s[0, 0, 0] + 1)
+        # The mapped arrays are copy-on-write.
+        sc[0] = -1.0
+        saved = numpy.load(self._path('data_1.npz'))['s']
+        self.assertEqual(saved[0, 0, 0], self.s[0, 0, 0] + 1)
+
+    def test_bool_mask(self):
+        "Test if bool arrays are read as unsigned chars."
+        mask = self.s > 0.5
+        numpy.savez(self._path('m.npz'), s=self.s, mask=mask)
+        dims, flat = image_layout(numpy.load(self._path('m.npz'))['mask'])
+        self.assertEqual(flat.dtype, numpy.uint8)
+        r = NumpyFileReader()
+        r.initialize(self._path('m.npz'))
+        self.assertEqual(sorted(r._scalars_list), ['mask', 's'])
+        r.scalars_name = 'mask'
+        sc = r.outputs[0].point_data.scalars.to_array()
+        testing.assert_equal(sc, numpy.ravel(mask, order='F'))
+
+    def test_registry(self):
+        "Test if the reader is registered for .npy and .npz files."
+        for ext in ('npy', 'npz'):
+            readers = [m.class_name for m in registry.sources
+                       if ext in m.extensions]
+            self.assertEqual(readers,
+                    ['mayavi.sources.numpy_file_reader.NumpyFileReader'])
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,248 @@
+"""
+Tests for the reading of the pieces of parallel VTK XML files.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.sources.piece_reader import PieceLoader, \
+     read_parallel_header, bounds_intersect, extents_tile, merge_structured
+from mayavi.sources.vtk_xml_file_reader import VTKXMLFileReader
+
+
+PVTI = """<?xml version="1.0"?>
+<VTKFile type="PImageData" version="0.1">
+  <PImageData WholeExtent="0 4 0 2 0 1" GhostLevel="0"
+              Origin="0 0 0" Spacing="1 1 1">
+    <PPointData Scalars="s">
+      <PDataArray type="Float64" Name="s"/>
+    </PPointData>
+    <Piece Extent="0 2 0 2 0 1" Source="img_0.vti"/>
+    <Piece Extent="2 4 0 2 0 1" Source="img_1.vti"/>
+  </PImageData>
+</VTKFile>
+"""
+
+PVTR = """<?xml version="1.0"?>
+<VTKFile type="PRectilinearGrid" version="0.1">
+  <PRectilinearGrid WholeExtent="0 4 0 2 0 1" GhostLevel="0">
+    <PPointData Scalars="s">
+      <PDataArray type="Float64" Name="s"/>
+    </PPointData>
+    <PCoordinates>
+      <PDataArray type="Float64"/>
+      <PDataArray type="Float64"/>
+      <PDataArray type="Float64"/>
+    </PCoordinates>
+    <Piece Extent="0 2 0 2 0 1" Source="rg_0.vtr"/>
+    <Piece Extent="2 4 0 2 0 1" Source="rg_1.vtr"/>
+  </PRectilinearGrid>
+</VTKFile>
+"""
+
+PVTU = """<?xml version="1.0"?>
+<VTKFile type="PUnstructuredGrid" version="0.1">
+  <PUnstructuredGrid GhostLevel="0">
+    <PPoints>
+      <PDataArray type="Float32" NumberOfComponents="3"/>
+    </PPoints>
+%s  </PUnstructuredGrid>
+</VTKFile>
+"""
+
+
+class TestPieceReader(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        # The values of the whole image, x varying fastest.
+        self.values = numpy.arange(5*3*2, dtype=float)
+        whole = self.values.reshape(2, 3, 5)
+        for i, (x0, x1) in enumerate([(0, 2), (2, 4)]):
+            img = tvtk.ImageData(extent=(x0, x1, 0, 2, 0, 1),
+                                 origin=(0, 0, 0), spacing=(1, 1, 1))
+            img.point_data.scalars = whole[:, :, x0:x1 + 1].ravel()
+            img.point_data.scalars.name = 's'
+            w = tvtk.XMLImageDataWriter(input=img,
+                                        file_name=self._path('img_%d.vti'%i))
+            w.write()
+        self._write(self._path('img.pvti'), PVTI)
+
+        pieces = ''
+        for i in range(4):
+            ug = tvtk.UnstructuredGrid()
+            pts = numpy.array([[0, 0, 0], [1, 0, 0], [0, 1, 0], [0, 0, 1]],
+                              float)
+            pts[:, 0] += 2*i
+            ug.points = pts
+            ug.insert_next_cell(tvtk.Tetra().cell_type, [0, 1, 2, 3])
+            ug.point_data.scalars = numpy.ones(4)*i
+            ug.point_data.scalars.name = 'p'
+            w = tvtk.XMLUnstructuredGridWriter(input=ug,
+                                    file_name=self._path('ug_%d.vtu'%i))
+            w.write()
+            pieces += '    <Piece Source="ug_%d.vtu"/>\n'%i
+        self._write(self._path('ug.pvtu'), PVTU%pieces)
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def _path(self, name):
+        return os.path.join(self.root, name)
+
+    def _write(self, fname, text):
+        f = open(fname, 'w')
+        f.write(text)
+        f.close()
+
+    def test_header(self):
+        "Test the parsing of the parallel files."
+        h = read_parallel_header(self._path('img.pvti'))
+        self.assertEqual(h['type'], 'PImageData')
+        self.assertEqual(h['pieces'][1],
+                         (self._path('img_1.vti'), (2, 4, 0, 2, 0, 1)))
+        h = read_parallel_header(self._path('ug.pvtu'))
+        self.assertEqual(len(h['pieces']), 4)
+        self.assertEqual(h['pieces'][0][1], None)
+
+    def test_merge_image(self):
+        "Test if image pieces are merged into one image."
+        loader = PieceLoader(self._path('img.pvti'), n_threads=2)
+        fractions = []
+        outputs = loader.load(progress=fractions.append)
+        self.assertEqual(len(outputs), 1)
+        img = tvtk.to_tvtk(outputs[0])
+        self.assertEqual(tuple(img.extent), (0, 4, 0, 2, 0, 1))
+        testing.assert_equal(img.point_data.scalars.to_array(),
+                             self.values)
+        self.assertEqual(fractions[-1], 1.0)
+        outputs = loader.load(merge='pieces')
+        self.assertEqual(len(outputs), 2)
+
+    def test_merge_rectilinear(self):
+        "Test if rectilinear grid pieces are merged into one grid."
+        x = numpy.array([0.0, 1.0, 3.0, 6.0, 10.0])
+        whole = self.values.reshape(2, 3, 5)
+        for i, (x0, x1) in enumerate([(0, 2), (2, 4)]):
+            rg = tvtk.RectilinearGrid(extent=(x0, x1, 0, 2, 0, 1))
+            rg.x_coordinates = x[x0:x1 + 1]
+            rg.y_coordinates = numpy.array([0.0, 0.5, 2.0])
+            rg.z_coordinates = numpy.array([0.0, 1.0])
+            rg.point_data.scalars = whole[:, :, x0:x1 + 1].ravel()
+            rg.point_data.scalars.name = 's'
+            w = tvtk.XMLRectilinearGridWriter(input=rg,
+                                    file_name=self._path('rg_%d.vtr'%i))
+            w.write()
+        self._write(self._path('rg.pvtr'), PVTR)
+        outputs = PieceLoader(self._path('rg.pvtr')).load()
+        self.assertEqual(len(outputs), 1)
+        rg = tvtk.to_tvtk(outputs[0])
+        self.assertTrue(isinstance(rg, tvtk.RectilinearGrid))
+        self.assertEqual(tuple(rg.extent), (0, 4, 0, 2, 0, 1))
+        testing.assert_equal(rg.x_coordinates.to_array(), x)
+        testing.assert_equal(rg.y_coordinates.to_array(), [0.0, 0.5, 2.0])
+        testing.assert_equal(rg.point_data.scalars.to_array(),
+                             self.values)
+
+    def test_pieces_with_holes(self):
+        "Test if pieces that do not cover their union are not merged."
+        self.assertTrue(extents_tile((0, 4, 0, 2, 0, 1),
+                                     [(0, 2, 0, 2, 0, 1),
+                                      (2, 4, 0, 2, 0, 1)]))
+        self.assertFalse(extents_tile((0, 8, 0, 2, 0, 1),
+                                      [(0, 2, 0, 2, 0, 1),
+                                       (6, 8, 0, 2, 0, 1)]))
+        img = tvtk.ImageData(extent=(4, 8, 0, 2, 0, 1))
+        img.point_data.scalars = numpy.ones(30)
+        img.point_data.scalars.name = 's'
+        w = tvtk.XMLImageDataWriter(input=img,
+                                    file_name=self._path('img_2.vti'))
+        w.write()
+        text = PVTI.replace('WholeExtent="0 4', 'WholeExtent="0 8')
+        text = text.replace('  </PImageData>',
+                            '    <Piece Extent="4 8 0 2 0 1" '
+                            'Source="img_2.vti"/>\n  </PImageData>')
+        self._write(self._path('holes.pvti'), text)
+        loader = PieceLoader(self._path('holes.pvti'))
+        outputs = loader.load([0, 2])
+        self.assertEqual(len(outputs), 2)
+        self.assertEqual(tuple(outputs[1].GetExtent()), (4, 8, 0, 2, 0, 1))
+        self.assertRaises(ValueError, merge_structured, outputs,
+                          [(0, 2, 0, 2, 0, 1), (4, 8, 0, 2, 0, 1)])
+        # The pieces that tile are still merged.
+        outputs = loader.load()
+        self.assertEqual(len(outputs), 1)
+        self.assertEqual(tuple(outputs[0].GetExtent()), (0, 8, 0, 2, 0, 1))
+
+    def test_append_and_select(self):
+        "Test appending and selecting unstructured pieces."
+        loader = PieceLoader(self._path('ug.pvtu'), n_threads=3)
+        ug = tvtk.to_tvtk(loader.load()[0])
+        self.assertEqual(ug.number_of_cells, 4)
+        self.assertEqual(ug.number_of_points, 16)
+        indices = loader.select((3.5, 10.0, -1.0, 1.0, -1.0, 1.0))
+        self.assertEqual(indices, [2, 3])
+        self.assertTrue(bounds_intersect(loader.piece_bounds(2),
+                                         (3.5, 10.0, -1, 1, -1, 1)))
+        ug = tvtk.to_tvtk(loader.load(indices)[0])
+        self.assertEqual(ug.number_of_cells, 2)
+        self.assertEqual(ug.bounds[0], 4.0)
+
+    def test_cancel(self):
+        "Test if a cancelled load returns None."
+        loader = PieceLoader(self._path('ug.pvtu'))
+        loader.cancel()
+        self.assertEqual(loader.load(), None)
+
+    def test_vtk_xml_file_reader(self):
+        "Test the parallel piece reading of VTKXMLFileReader."
+        r = VTKXMLFileReader(read_pieces_in_parallel=True)
+        r.initialize(self._path('ug.pvtu'))
+        self.assertEqual(r.n_pieces, 4)
+        self.assertEqual(r.outputs[0].number_of_cells, 4)
+        self.assertEqual(r.point_scalars_name, 'p')
+        r.set(piece_bounds=(-1.0, 2.5, -1.0, 1.0, -1.0, 1.0),
+              select_pieces=True)
+        self.assertEqual(r.n_pieces_read, 2)
+        self.assertEqual(r.outputs[0].number_of_cells, 2)
+        r.merge_pieces = 'pieces'
+        self.assertEqual(len(r.outputs), 2)
+        # The VTK parallel reader gives the same result.
+        r.set(select_pieces=False, read_pieces_in_parallel=False)
+        self.assertEqual(r.outputs[0].number_of_cells, 4)
+
+    def test_read_ahead(self):
+        "Test if the time steps read ahead use the piece settings."
+        for i in range(3):
+            shutil.copy(self._path('ug.pvtu'), self._path('step%d.pvtu'%i))
+        r = VTKXMLFileReader(read_pieces_in_parallel=True, cache_size=4,
+                             read_ahead=2, select_pieces=True,
+                             piece_bounds=(-1.0, 2.5, -1.0, 1.0, -1.0, 1.0))
+        r.initialize(self._path('step0.pvtu'))
+        self.assertEqual(r.outputs[0].number_of_cells, 2)
+        step = r.file_list[2]
+        r._read_ahead.wait(step, 5.0)
+        outputs = r._cache.peek(step)
+        self.assertTrue(outputs is not None)
+        self.assertEqual(len(outputs), 1)
+        self.assertEqual(outputs[0].GetNumberOfCells(), 2)
+        r.timestep = 2
+        self.assertEqual(r.outputs[0].number_of_cells, 2)
+        # Changing the settings drops the time steps read ahead.
+        r.select_pieces = False
+        self.assertEqual(r.outputs[0].number_of_cells, 4)
+        self.assertFalse(step in r._cache)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -310,6 +310,51 @@ class TestSLCReader(DataReaderTestBase):
 
         self.check_deepcopying(self.scene, self.bounds)
 
+class TestFastReaders(DataReaderTestBase):
+    """Tests the fast parsers on the files of the tests above."""
+
+    # The files and their bounds.
+    files = [('shuttle.obj', (-7.65, 7.04, -4.68, 4.68, -1.35, 4.16)),
+             ('humanoid_tri.stla', (0.60, 3.47, -3.96, 3.95, 3.05, 17.39)),
+             ('pyramid.ply', (0.0, 1.0, 0.0, 1.0, 0.0, 1.60)),
+             ('points.txt', (0.0, 1.0, 0.0, 1.0, 0.0, 1.0))]
+
+    def setup_reader(self):
+        """"Setup the reader in here.  This is called after the engine
+        has been created and started.  The engine is available as
+        self.e.  This method is called by setUp().
+        """
+        r = PolyDataReader(use_fast_parsers=True)
+        r.initialize(get_example_data('shuttle.obj'))
+        self.e.add_source(r)
+        self.reader = r
+        self.bounds = self.files[0][1]
+
+    def test_fast_readers(self):
+        "Test if the fast parsers read the files"
+        r = self.reader
+        for name, bounds in self.files:
+            r.initialize(get_example_data(name))
+            self.assertEqual(r.reader.__class__.__name__, 'FastMeshReader')
+            self.assertFalse(r.reader.used_fallback)
+            self.assertTrue(r.reader.bytes_per_second > 0)
+            self.bounds = bounds
+            self.check(self.scene, self.bounds)
+
+    def test_stl_merged_points(self):
+        "Test if coincident STL points are merged"
+        r = self.reader
+        r.initialize(get_example_data('humanoid_tri.stla'))
+        output = r.outputs[0]
+        self.assertEqual(output.number_of_polys, 96)
+        self.assertTrue(output.number_of_points < 3*96)
+
+    def test_save_and_restore(self):
+        """Test if saving a visualization and restoring it works."""
+
+        self.check_saving(self.e, self.scene, self.bounds)
+
+
 if __name__ == '__main__':
     unittest.main()
 
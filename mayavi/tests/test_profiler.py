@@ -0,0 +1,106 @@
+"""
+Tests for the execution profiler of the pipeline.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import gc
+import unittest
+import weakref
+
+# Enthought library imports.
+from mayavi.core.null_engine import NullEngine
+from mayavi.core.profiler import get_profile
+from mayavi.sources.parametric_surface import ParametricSurface
+from mayavi.modules.outline import Outline
+
+
+class TestProfiler(unittest.TestCase):
+
+    def setUp(self):
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+        self.src = ParametricSurface()
+        e.add_source(self.src)
+        self.profiler = e.get_profiler()
+
+    def tearDown(self):
+        self.profiler.enabled = False
+        self.e.stop()
+
+    def _execute(self):
+        self.src.source.modified()
+        self.src.source.update()
+
+    def test_disabled(self):
+        "Test if nothing is recorded unless the profiler is enabled."
+        self._execute()
+        self.assertEqual(get_profile(self.src), None)
+        self.assertEqual(self.profiler.to_dict(), {})
+
+    def test_profile(self):
+        "Test if executions are attributed to the source."
+        self.profiler.enabled = True
+        self._execute()
+        self._execute()
+        stats = get_profile(self.src)
+        self.assertEqual(stats.n_calls, 2)
+        self.assertTrue(stats.total_time >= stats.max_time >= 0.0)
+        output = self.src.outputs[0]
+        self.assertEqual(stats.n_points, output.number_of_points)
+        self.assertEqual(stats.n_cells, output.number_of_cells)
+        d = self.profiler.to_dict()
+        self.assertEqual(d['engine.scenes[0].children[0]']['n_calls'], 2)
+
+        self.profiler.reset()
+        self.assertEqual(stats.n_calls, 0)
+
+        # Disabling removes the observers.
+        self.profiler.enabled = False
+        self._execute()
+        self.assertEqual(stats.n_calls, 0)
+
+    def test_new_objects(self):
+        "Test if objects added while profiling are profiled."
+        self.profiler.enabled = True
+        o = Outline()
+        self.e.add_module(o)
+        self.assertNotEqual(get_profile(o), None)
+        names = [node.name for depth, node, stats in self.profiler.nodes()]
+        self.assertTrue(o.name in names)
+        self.assertEqual(len(str(self.profiler).splitlines()),
+                         len(names) + 2)
+
+    def test_removed_objects(self):
+        "Test if objects removed from the pipeline are forgotten."
+        self.profiler.enabled = True
+        o = Outline()
+        self.e.add_module(o)
+        n_observed = len(self.profiler._observed)
+        n_nodes = len(self.profiler._nodes)
+        mm = o.parent
+        mm.remove()
+        self.assertTrue(len(self.profiler._observed) < n_observed)
+        self.assertTrue(len(self.profiler._nodes) < n_nodes)
+
+    def test_engine_not_kept_alive(self):
+        "Test if the profiler does not keep its engine alive."
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        e.add_source(ParametricSurface())
+        profiler = e.get_profiler()
+        profiler.enabled = True
+        ref = weakref.ref(e)
+        e.stop()
+        del e
+        gc.collect()
+        self.assertEqual(ref(), None)
+        self.assertEqual(profiler.engine, None)
+
+
+if __name__ == '__main__':
+    unittest.main()
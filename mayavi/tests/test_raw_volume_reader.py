@@ -0,0 +1,110 @@
+"""
+Tests for the raw volume reader.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from mayavi.core.registry import registry
+from mayavi.sources.raw_volume_reader import RawVolumeReader, \
+     map_raw_volume, to_native
+
+
+class TestRawVolumeReader(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        # x varies fastest in the file.
+        self.data = numpy.arange(3*4*5, dtype='int16').reshape(5, 4, 3)
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def _write(self, name, dtype, header=''):
+        fname = os.path.join(self.root, name)
+        f = open(fname, 'wb')
+        f.write(header)
+        f.write(self.data.astype(dtype).tostring())
+        f.close()
+        return fname
+
+    def test_map_raw_volume(self):
+        "Test if the file is memory-mapped after the header."
+        fname = self._write('a.vol', '<i2', header='h'*10)
+        arr = map_raw_volume(fname, (3, 4, 5), 'int16', 'little', 10)
+        self.assertTrue(isinstance(arr, numpy.memmap))
+        testing.assert_equal(arr, self.data.ravel())
+        # Written in memory only.
+        arr[0] = -1
+        self.assertEqual(map_raw_volume(fname, (3, 4, 5), 'int16',
+                                        'little', 10)[0], 0)
+        # Too small a file.
+        self.assertRaises(ValueError, map_raw_volume, fname, (3, 4, 6),
+                          'int16', 'little', 10)
+
+    def test_to_native(self):
+        "Test if only non-native arrays are swapped."
+        a = numpy.arange(10, dtype='=u2')
+        self.assertTrue(to_native(a) is a)
+        b = a.astype(a.dtype.newbyteorder('S'))
+        out = numpy.empty(10, '=u2')
+        self.assertTrue(to_native(b, out) is out)
+        testing.assert_equal(out, a)
+
+    def test_reader(self):
+        "Test the reader output for both byte orders."
+        for order, code in (('little', '<i2'), ('big', '>i2')):
+            fname = self._write('data_%s.vol' % order, code)
+            r = RawVolumeReader(dimensions=(3, 4, 5), data_type='int16',
+                                byte_order=order)
+            r.initialize(fname)
+            img = r.outputs[0]
+            self.assertEqual(tuple(img.dimensions), (3, 4, 5))
+            s = img.point_data.scalars.to_array()
+            testing.assert_equal(s, self.data.ravel())
+            self.assertEqual(img.point_data.scalars.range, (0.0, 59.0))
+            swapped = r._swapped
+            if numpy.little_endian == (order == 'little'):
+                self.assertTrue(swapped is None)
+            else:
+                # The swapped buffer is reused on update.
+                self.assertTrue(swapped is not None)
+                r.update()
+                self.assertTrue(r._swapped is swapped)
+
+    def test_header_size(self):
+        "Test changing the header size and the type."
+        fname = self._write('h.vol', '<f4', header='x'*8)
+        r = RawVolumeReader(dimensions=(3, 4, 5), data_type='float32',
+                            header_size=8)
+        r.initialize(fname)
+        s = r.outputs[0].point_data.scalars.to_array()
+        testing.assert_equal(s, self.data.ravel())
+        # A header of 12 bytes does not fit the file with the old
+        # dimensions, the file must only be read once both are set.
+        reads = []
+        load = r._load_file
+        r._load_file = lambda fname: (reads.append(fname), load(fname))
+        r.set(header_size=12, dimensions=(3, 4, 4))
+        self.assertEqual(reads, [fname])
+        s = r.outputs[0].point_data.scalars.to_array()
+        testing.assert_equal(s, self.data.ravel()[1:49])
+
+    def test_registry(self):
+        "Test if .vol files are opened with the reader."
+        meta = registry.get_file_reader('test.vol')
+        self.assertEqual(meta.class_name,
+                         'mayavi.sources.raw_volume_reader.RawVolumeReader')
+
+
+if __name__ == '__main__':
+    unittest.main()
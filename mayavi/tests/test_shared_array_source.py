@@ -0,0 +1,190 @@
+"""
+Tests for the shared memory array source.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from mayavi.core.null_engine import NullEngine
+from mayavi.sources.shared_array_source import SharedArraySource
+from mayavi.tools.shared_array import SharedArrayWriter, \
+     SharedArrayReader
+
+
+# Writes `n` frames, each filled with its number, and waits for the
+# file `done` to exist.
+PRODUCER = """
+import os, sys, time
+from mayavi.tools.shared_array import SharedArrayWriter
+path, n, done = sys.argv[1], int(sys.argv[2]), sys.argv[3]
+w = SharedArrayWriter(path, (8, 6, 4), 'float32')
+for i in range(1, n + 1):
+    w.next_frame()[...] = i
+    w.publish()
+    time.sleep(0.01)
+while not os.path.exists(done):
+    time.sleep(0.01)
+w.close(unlink=False)
+"""
+
+
+class TestSharedArray(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        self.path = os.path.join(self.root, 'segment')
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def test_layout(self):
+        w = SharedArrayWriter(self.path, (4, 3, 2), 'int16')
+        r = SharedArrayReader(self.path)
+        self.assertEqual(r.shape, (4, 3, 2))
+        self.assertEqual(r.dtype, numpy.dtype('int16'))
+        self.assertEqual(r.acquire(), (0, None))
+        a = numpy.arange(24, dtype='int16').reshape(4, 3, 2)
+        self.assertEqual(w.write(a), 1)
+        seq, arr = r.acquire()
+        self.assertEqual(seq, 1)
+        testing.assert_array_equal(arr, a)
+        # x varies fastest, as in VTK.
+        self.assertTrue(arr.T.flags.c_contiguous)
+
+    def test_vectors(self):
+        w = SharedArrayWriter(self.path, (4, 3), float, n_components=3)
+        r = SharedArrayReader(self.path)
+        a = numpy.random.rand(4, 3, 3)
+        w.write(a)
+        seq, arr = r.acquire()
+        testing.assert_array_equal(arr, a)
+        self.assertTrue(arr.transpose(1, 0, 2).flags.c_contiguous)
+
+    def test_frame_shown_not_overwritten(self):
+        w = SharedArrayWriter(self.path, (4, 3, 2), float)
+        r = SharedArrayReader(self.path)
+        w.write(numpy.ones((4, 3, 2)))
+        seq, arr = r.acquire()
+        for i in range(10):
+            w.write(numpy.zeros((4, 3, 2)))
+        testing.assert_array_equal(arr, 1.0)
+        seq, arr = r.acquire()
+        self.assertEqual(seq, 11)
+        testing.assert_array_equal(arr, 0.0)
+
+    def test_replaced_segment(self):
+        w = SharedArrayWriter(self.path, (40, 30, 20), float)
+        r = SharedArrayReader(self.path)
+        w.write(numpy.ones((40, 30, 20)))
+        seq, arr = r.acquire()
+        # A smaller segment of that name does not truncate the mapping
+        # of the reader.
+        w2 = SharedArrayWriter(self.path, (4, 3), 'int16')
+        testing.assert_array_equal(arr, 1.0)
+        self.assertEqual(os.listdir(self.root), ['segment'])
+        r2 = SharedArrayReader(self.path)
+        self.assertEqual(r2.shape, (4, 3))
+        self.assertEqual(r2.acquire(), (0, None))
+        w2.write(numpy.ones((4, 3)))
+        self.assertEqual(r.seq, 1)
+
+    def test_bad_segment(self):
+        f = open(self.path, 'wb')
+        f.write('x'*5000)
+        f.close()
+        self.assertRaises(ValueError, SharedArrayReader, self.path)
+
+
+class TestSharedArraySource(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        self.path = os.path.join(self.root, 'segment')
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+
+    def tearDown(self):
+        self.e.stop()
+        shutil.rmtree(self.root)
+
+    def test_poll(self):
+        w = SharedArrayWriter(self.path, (4, 3, 2), 'float32')
+        src = SharedArraySource(segment=self.path)
+        self.e.add_source(src)
+        self.assertEqual(src.seq, 0)
+        self.assertFalse(src.poll())
+        a = numpy.random.rand(4, 3, 2)
+        w.write(a)
+        self.assertTrue(src.poll())
+        self.assertFalse(src.poll())
+        self.assertEqual(src.seq, 1)
+        self.assertEqual(src.image_data.dimensions, (4, 3, 2))
+        scalars = src.image_data.point_data.scalars
+        testing.assert_array_almost_equal(scalars.to_array(),
+                                          numpy.ravel(a.T))
+        # VTK uses the shared memory.
+        src.scalar_data[0, 0, 0] = 42
+        self.assertEqual(scalars[0], 42)
+
+    def test_vectors(self):
+        w = SharedArrayWriter(self.path, (4, 3, 2), float, n_components=3)
+        src = SharedArraySource(segment=self.path)
+        self.e.add_source(src)
+        a = numpy.random.rand(4, 3, 2, 3)
+        w.write(a)
+        src.poll()
+        vectors = src.image_data.point_data.vectors
+        testing.assert_array_almost_equal(vectors.to_array(),
+                              numpy.reshape(a.transpose(2, 1, 0, 3),
+                                            (-1, 3)))
+
+    def test_two_processes(self):
+        done = os.path.join(self.root, 'done')
+        env = dict(os.environ)
+        env['PYTHONPATH'] = os.pathsep.join(sys.path)
+        p = subprocess.Popen([sys.executable, '-c', PRODUCER, self.path,
+                              '20', done], env=env)
+        try:
+            t = time.time()
+            # Wait for the segment to be created.
+            while time.time() - t < 30:
+                try:
+                    SharedArrayReader(self.path)
+                    break
+                except (IOError, ValueError):
+                    time.sleep(0.01)
+            src = SharedArraySource(segment=self.path)
+            self.e.add_source(src)
+            seen = []
+            while src.seq < 20 and time.time() - t < 30:
+                if src.poll():
+                    frame = src.scalar_data
+                    # A frame is never torn.
+                    self.assertEqual(frame.min(), frame.max())
+                    seen.append(src.seq)
+                time.sleep(0.005)
+            self.assertEqual(src.seq, 20)
+            testing.assert_array_equal(src.scalar_data, 20)
+            self.assertEqual(seen, sorted(seen))
+        finally:
+            open(done, 'w').close()
+            p.wait()
+        self.assertEqual(p.returncode, 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
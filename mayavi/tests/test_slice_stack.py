@@ -0,0 +1,173 @@
+"""
+Tests for the loading of image stacks.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from tvtk.api import tvtk
+from mayavi.sources.slice_stack import SliceStackLoader, make_image_data
+from mayavi.sources import image_reader
+from mayavi.sources.image_reader import ImageReader
+
+
+class FakeGUI(object):
+    """Queues the calls posted to the GUI thread."""
+
+    calls = []
+
+    @classmethod
+    def invoke_later(cls, func, *args, **kw):
+        cls.calls.append((func, args, kw))
+
+    @classmethod
+    def process_events(cls):
+        calls = cls.calls[:]
+        del cls.calls[:]
+        for func, args, kw in calls:
+            func(*args, **kw)
+
+
+class TestSliceStack(unittest.TestCase):
+
+    def setUp(self):
+        self.root = tempfile.mkdtemp()
+        self.n = 6
+        self.files = []
+        for i in range(self.n):
+            img = tvtk.ImageData(dimensions=(5, 4, 1))
+            s = (numpy.arange(20) + 10*i).astype('uint8')
+            img.point_data.scalars = s
+            img.scalar_type = 'unsigned_char'
+            fname = os.path.join(self.root, 'slice_%02d.png' % i)
+            w = tvtk.PNGWriter(file_name=fname, input=img)
+            w.write()
+            self.files.append(fname)
+
+    def tearDown(self):
+        shutil.rmtree(self.root)
+
+    def _expected(self):
+        return numpy.concatenate([numpy.arange(20) + 10*i
+                                  for i in range(self.n)])
+
+    def test_load(self):
+        "Test if the slices are loaded in order with progress."
+        cls = tvtk.to_vtk(tvtk.PNGReader()).__class__
+        loader = SliceStackLoader(self.files, cls, n_threads=3)
+        fractions = []
+        dims, spacing, origin, values = loader.load(fractions.append)
+        self.assertEqual(dims, (5, 4, self.n))
+        testing.assert_equal(values, self._expected())
+        self.assertEqual(fractions[-1], 1.0)
+        img = make_image_data(dims, spacing, origin, values)
+        self.assertEqual(img.point_data.scalars.range, (0.0, 69.0))
+
+    def test_cancel(self):
+        "Test if a cancelled load returns None."
+        cls = tvtk.to_vtk(tvtk.PNGReader()).__class__
+        loader = SliceStackLoader(self.files, cls)
+        loader.cancel()
+        self.assertEqual(loader.load(), None)
+        # Returning False from the progress callback cancels too.
+        loader = SliceStackLoader(self.files, cls)
+        self.assertEqual(loader.load(lambda f: False), None)
+
+    def test_mismatched_slice(self):
+        "Test if slices of different sizes are an error."
+        img = tvtk.ImageData(dimensions=(3, 3, 1))
+        img.point_data.scalars = numpy.zeros(9, 'uint8')
+        img.scalar_type = 'unsigned_char'
+        w = tvtk.PNGWriter(file_name=self.files[-1], input=img)
+        w.write()
+        loader = SliceStackLoader(self.files,
+                                  tvtk.to_vtk(tvtk.PNGReader()).__class__)
+        self.assertRaises(ValueError, loader.load)
+
+    def test_image_reader_stack(self):
+        "Test the stack mode of the ImageReader."
+        r = ImageReader()
+        r.initialize(self.files[0])
+        self.assertEqual(len(r.file_list), self.n)
+        self.assertEqual(tuple(r.outputs[0].dimensions), (5, 4, 1))
+        r.stack = True
+        img = r.outputs[0]
+        self.assertEqual(tuple(img.dimensions), (5, 4, self.n))
+        testing.assert_equal(img.point_data.scalars.to_array(),
+                             self._expected())
+        self.assertEqual(r.progress, 1.0)
+        # Changing the time step keeps the stack.
+        r.timestep = 2
+        self.assertTrue(r.outputs[0] is img)
+        r.stack = False
+        self.assertEqual(tuple(r.outputs[0].dimensions), (5, 4, 1))
+
+    def test_raw_stack(self):
+        "Test if raw images are not stacked."
+        fnames = []
+        for i in range(3):
+            fname = os.path.join(self.root, 'raw_%02d.raw'%i)
+            numpy.zeros(20, 'uint8').tofile(fname)
+            fnames.append(fname)
+        errors = []
+        orig_error = image_reader.error
+        image_reader.error = errors.append
+        try:
+            r = ImageReader()
+            r.initialize(fnames[0])
+            self.assertTrue(isinstance(r.reader, tvtk.ImageReader))
+            self.assertEqual(len(r.file_list), 3)
+            r.stack = True
+        finally:
+            image_reader.error = orig_error
+        self.assertEqual(len(errors), 1)
+        # The current file is shown instead.
+        self.assertTrue(r._stack_files is None)
+        self.assertTrue(r.outputs[0] is r.reader.output)
+
+    def test_image_reader_background(self):
+        "Test if the stack is loaded off the GUI thread."
+        old = image_reader.GUI, image_reader._event_loop_running
+        image_reader.GUI = FakeGUI
+        image_reader._event_loop_running = lambda: True
+        try:
+            r = ImageReader()
+            r.initialize(self.files[0])
+            old_output = r.outputs[0]
+            r.stack = True
+            # The output is only changed on the GUI thread.
+            thread = r._stack_thread
+            self.assertTrue(thread is not None)
+            thread.join()
+            self.assertTrue(r.outputs[0] is old_output)
+            FakeGUI.process_events()
+            img = r.outputs[0]
+            self.assertEqual(tuple(img.dimensions), (5, 4, self.n))
+            testing.assert_equal(img.point_data.scalars.to_array(),
+                                 self._expected())
+            self.assertEqual(r.progress, 1.0)
+            self.assertTrue(r._stack_loader is None)
+
+            # A cancelled load keeps the previous output.
+            r.update()
+            r.cancel_stack()
+            r._stack_thread.join()
+            FakeGUI.process_events()
+            self.assertTrue(r.outputs[0] is img)
+            self.assertTrue(r._stack_loader is None)
+        finally:
+            image_reader.GUI, image_reader._event_loop_running = old
+            del FakeGUI.calls[:]
+
+
+if __name__ == '__main__':
+    unittest.main()
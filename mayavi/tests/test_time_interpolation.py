@@ -0,0 +1,127 @@
+"""
+Tests for the interpolation of file data sources between time steps.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy
+from numpy import testing
+
+# Enthought library imports.
+from tvtk.api import tvtk, write_data
+from mayavi.core.null_engine import NullEngine
+from mayavi.core.time_interpolation import same_topology, \
+     same_arrays, interpolate_dataset, lerp_array
+from mayavi.sources.vtk_xml_file_reader import VTKXMLFileReader
+
+
+def make_data(t, n=4):
+    """A polydata whose points and scalars depend on `t`."""
+    points = numpy.zeros((n, 3), 'd')
+    points[:, 0] = numpy.arange(n) + t
+    pd = tvtk.PolyData(points=points, polys=[[0, 1, 2], [1, 2, 3]][:n-2])
+    pd.point_data.scalars = numpy.arange(n, dtype='d')*(1 + t)
+    pd.point_data.scalars.name = 'scalars'
+    ids = tvtk.IntArray(name='ids')
+    ids.from_array(numpy.arange(n, dtype='i')*(1 + int(t)))
+    pd.point_data.add_array(ids)
+    return pd
+
+
+class TestInterpolateDataset(unittest.TestCase):
+
+    def test_lerp_array(self):
+        a0 = numpy.arange(6.0)
+        a1 = a0*3
+        out = numpy.empty_like(a0)
+        lerp_array(out, a0, a1, 0.25)
+        testing.assert_allclose(out, a0*1.5)
+        # The output may be the second input.
+        lerp_array(a1, a0, a1, 1.0)
+        testing.assert_allclose(a1, a0*3)
+
+    def test_interpolate(self):
+        d0 = tvtk.to_vtk(make_data(0.0))
+        d1 = tvtk.to_vtk(make_data(1.0))
+        self.assertTrue(same_topology(d0, d1))
+        self.assertFalse(same_topology(d0, tvtk.to_vtk(make_data(0, 3))))
+        out = d0.NewInstance()
+        out.DeepCopy(d0)
+        interpolate_dataset(out, d0, d1, 0.5)
+        o = tvtk.to_tvtk(out)
+        testing.assert_allclose(o.points.to_array()[:, 0],
+                                numpy.arange(4) + 0.5)
+        testing.assert_allclose(o.point_data.scalars.to_array(),
+                                numpy.arange(4)*1.5)
+        # Integer arrays come from the nearest step.
+        testing.assert_equal(o.point_data.get_array('ids').to_array(),
+                             numpy.arange(4)*2)
+
+    def test_same_topology(self):
+        "Test if the connectivity and extents are compared."
+        d0 = make_data(0.0)
+        d1 = make_data(1.0)
+        d1.polys = [[0, 1, 3], [1, 2, 3]]
+        self.assertFalse(same_topology(tvtk.to_vtk(d0), tvtk.to_vtk(d1)))
+        i0 = tvtk.ImageData(extent=(0, 3, 0, 1, 0, 0))
+        i1 = tvtk.ImageData(extent=(0, 1, 0, 3, 0, 0))
+        self.assertFalse(same_topology(tvtk.to_vtk(i0), tvtk.to_vtk(i1)))
+        i1.extent = (0, 3, 0, 1, 0, 0)
+        self.assertTrue(same_topology(tvtk.to_vtk(i0), tvtk.to_vtk(i1)))
+        self.assertTrue(same_arrays(tvtk.to_vtk(d0), tvtk.to_vtk(d1)))
+        d1.point_data.remove_array('ids')
+        self.assertFalse(same_arrays(tvtk.to_vtk(d0), tvtk.to_vtk(d1)))
+
+
+class TestFileDataSourceInterpolation(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        for i in range(3):
+            write_data(make_data(float(i)),
+                       os.path.join(self.tmpdir, 'data%d.vtp'%i))
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+
+    def tearDown(self):
+        self.e.stop()
+        shutil.rmtree(self.tmpdir)
+
+    def test_interpolate(self):
+        r = VTKXMLFileReader()
+        r.initialize(os.path.join(self.tmpdir, 'data0.vtp'))
+        self.e.add_source(r)
+        r.interpolate = True
+        r.time = 0.5
+        output = r.outputs[0]
+        scalars = output.point_data.scalars.to_array()
+        testing.assert_allclose(scalars, numpy.arange(4)*1.5)
+        # The same output is reused within a bracket.
+        r.time = 0.75
+        self.assertTrue(r.outputs[0] is output)
+        output.update()
+        testing.assert_allclose(output.points.to_array()[:, 0],
+                                numpy.arange(4) + 0.75)
+        # The buffers are reused for the next bracket too.
+        r.time = 1.5
+        self.assertTrue(r.outputs[0] is output)
+        r.outputs[0].update()
+        testing.assert_allclose(r.outputs[0].point_data.scalars.to_array(),
+                                numpy.arange(4)*2.5)
+        self.assertEqual(len(r._interp_steps), 2)
+        # Going back to discrete steps.
+        r.interpolate = False
+        testing.assert_allclose(r.outputs[0].point_data.scalars.to_array(),
+                                numpy.arange(4))
+
+
+if __name__ == '__main__':
+    unittest.main()
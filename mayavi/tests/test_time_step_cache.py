@@ -0,0 +1,143 @@
+"""
+Tests for the time step cache and read-ahead of file data sources.
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import os
+import shutil
+import tempfile
+import threading
+import unittest
+
+# Local imports.
+from common import get_example_data
+
+# Enthought library imports.
+from mayavi.core.null_engine import NullEngine
+from mayavi.core.time_step_cache import TimeStepCache, ReadAhead
+from mayavi.sources.vtk_xml_file_reader import VTKXMLFileReader
+
+
+class TestTimeStepCache(unittest.TestCase):
+
+    def test_lru_count(self):
+        c = TimeStepCache(max_items=2)
+        c.put('a', 1)
+        c.put('b', 2)
+        self.assertEqual(c.get('a'), 1)
+        c.put('c', 3)
+        # 'b' was the least recently used.
+        self.assertTrue('b' not in c)
+        self.assertEqual(c.get('a'), 1)
+        self.assertEqual(c.get('c'), 3)
+        self.assertEqual(c.get('b'), None)
+        self.assertEqual((c.hits, c.misses), (3, 1))
+
+    def test_lru_bytes(self):
+        c = TimeStepCache(max_bytes=100)
+        c.put('a', 1, 60)
+        c.put('b', 2, 30)
+        self.assertEqual(c.nbytes, 90)
+        c.put('c', 3, 30)
+        self.assertEqual(len(c), 2)
+        self.assertEqual(c.nbytes, 60)
+        self.assertTrue('a' not in c)
+        # An item larger than the budget is still kept.
+        c.put('d', 4, 500)
+        self.assertEqual(len(c), 1)
+        self.assertEqual(c.peek('d'), 4)
+        c.set_limits(max_items=1)
+        c.clear()
+        self.assertEqual((len(c), c.nbytes), (0, 0))
+
+    def test_read_ahead(self):
+        c = TimeStepCache(max_items=10)
+        release = threading.Event()
+        def _loader(key):
+            release.wait()
+            return key*2, 1
+        r = ReadAhead(c, _loader)
+        r.request([1, 2, 3])
+        release.set()
+        self.assertTrue(r.wait(3, 5.0) or 3 in c)
+        for key in (1, 2, 3):
+            r.wait(key, 5.0)
+            self.assertEqual(c.peek(key), key*2)
+        r.shutdown()
+
+
+class TestFileDataSourceCache(unittest.TestCase):
+
+    def setUp(self):
+        self.tmpdir = tempfile.mkdtemp()
+        src = get_example_data('cube.vti')
+        for i in range(4):
+            shutil.copy(src, os.path.join(self.tmpdir, 'cube%d.vti'%i))
+        e = NullEngine()
+        e.start()
+        e.new_scene()
+        self.e = e
+
+    def tearDown(self):
+        self.e.stop()
+        shutil.rmtree(self.tmpdir)
+
+    def test_cached_stepping(self):
+        r = VTKXMLFileReader(cache_size=2)
+        r.initialize(os.path.join(self.tmpdir, 'cube0.vti'))
+        self.e.add_source(r)
+        self.assertEqual(len(r.file_list), 4)
+        n_points = r.outputs[0].number_of_points
+
+        r.timestep = 1
+        r.timestep = 2
+        self.assertEqual((r.cache_hits, r.cache_misses), (0, 2))
+        r.timestep = 1
+        self.assertEqual((r.cache_hits, r.cache_misses), (1, 2))
+        self.assertEqual(r.file_path.get(), r.file_list[1])
+        self.assertEqual(r.outputs[0].number_of_points, n_points)
+        self.assertTrue(len(r.point_scalars_name) > 0)
+
+        # Disabling the cache reads the files again.
+        r.cache_size = 0
+        r.timestep = 2
+        self.assertEqual(r.file_path.get(), r.file_list[2])
+        self.assertEqual(r.outputs[0].number_of_points, n_points)
+
+    def test_read_ahead(self):
+        r = VTKXMLFileReader(cache_size=4, read_ahead=2)
+        r.initialize(os.path.join(self.tmpdir, 'cube0.vti'))
+        self.e.add_source(r)
+        r.timestep = 1
+        r._read_ahead.wait(r.file_list[2], 5.0)
+        hits = r.cache_hits
+        r.timestep = 2
+        self.assertEqual(r.cache_hits, hits + 1)
+        r.read_ahead = 0
+        self.assertEqual(r._read_ahead, None)
+
+    def test_stop(self):
+        r = VTKXMLFileReader(cache_size=4, read_ahead=2)
+        r.initialize(os.path.join(self.tmpdir, 'cube0.vti'))
+        self.e.add_source(r)
+        r.timestep = 1
+        threads = list(r._read_ahead._threads)
+        self.assertTrue(len(threads) > 0)
+        # Removing the source stops the thread and frees the cache.
+        r.remove()
+        for t in threads:
+            t.join(5.0)
+            self.assertFalse(t.isAlive())
+        self.assertEqual(r._read_ahead, None)
+        self.assertEqual(r._cache, None)
+        # Adding it again restores the cache.
+        self.e.add_source(r)
+        self.assertTrue(r._cache is not None)
+        r.timestep = 2
+        self.assertEqual(r.file_path.get(), r.file_list[2])
+
+
+if __name__ == '__main__':
+    unittest.main()
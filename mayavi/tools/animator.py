@@ -6,10 +6,140 @@ Simple utility code for animations.
 # License: BSD Style.
 
 import types
+from collections import deque
+from math import ceil
+from time import time
 
 from pyface.timer.api import Timer
-from traits.api import HasTraits, Button, Instance, Range
+from traits.api import HasTraits, Button, Instance, Range, Bool, Int, \
+     Float, Any, Property
 from traitsui.api import View, Group, Item
+from tvtk.common import percentile
+
+
+################################################################################
+# `FrameStats` class.
+################################################################################
+class FrameStats(HasTraits):
+
+    """ Rolling statistics of the time taken by the frames of an
+        animation.  The compute time is the time spent in the animated
+        callable excluding rendering, the render time is the time spent
+        rendering the scene.  All times are in seconds and the
+        statistics are computed over the last `window` frames.
+    """
+
+    # The number of frames over which the statistics are computed.
+    window = Range(1, 100000, 100,
+                   desc='the number of frames the statistics are computed over')
+
+    # The total number of frames recorded so far.
+    n_frames = Int(0, desc='the number of frames recorded')
+
+    # The total number of animation steps merged into other frames
+    # (i.e. not rendered) to keep up with the target frame rate.
+    n_skipped = Int(0, desc='the number of steps that were not rendered')
+
+    # Statistics over the window.
+    compute_mean = Property(Float, depends_on='n_frames')
+    compute_p95 = Property(Float, depends_on='n_frames')
+    compute_max = Property(Float, depends_on='n_frames')
+    render_mean = Property(Float, depends_on='n_frames')
+    render_p95 = Property(Float, depends_on='n_frames')
+    render_max = Property(Float, depends_on='n_frames')
+    frame_mean = Property(Float, depends_on='n_frames')
+    frame_p95 = Property(Float, depends_on='n_frames')
+    frame_max = Property(Float, depends_on='n_frames')
+
+    # The achieved frame rate over the window.
+    fps = Property(Float, depends_on='n_frames')
+
+    def __init__(self, **traits):
+        super(FrameStats, self).__init__(**traits)
+        self._reset_buffers()
+
+    ######################################################################
+    # `FrameStats` interface
+    ######################################################################
+    def record(self, compute, render=0.0, skipped=0):
+        """Record the compute and render time of one frame.  `skipped`
+        is the number of additional animation steps that were merged
+        into this frame."""
+        self._compute.append(compute)
+        self._render.append(render)
+        self._frame.append(compute + render)
+        self._stamps.append(time())
+        self.n_skipped += skipped
+        self.n_frames += 1
+
+    def reset(self):
+        """Clear all the recorded statistics."""
+        self._reset_buffers()
+        self.n_skipped = 0
+        self.n_frames = 0
+
+    def to_dict(self):
+        """Return the statistics as a dictionary."""
+        result = dict(n_frames=self.n_frames, n_skipped=self.n_skipped,
+                      fps=self.fps)
+        for kind in ('compute', 'render', 'frame'):
+            for stat in ('mean', 'p95', 'max'):
+                name = '%s_%s'%(kind, stat)
+                result[name] = getattr(self, name)
+        return result
+
+    ######################################################################
+    # Non-public interface
+    ######################################################################
+    def _reset_buffers(self):
+        n = self.window
+        self._compute = deque(maxlen=n)
+        self._render = deque(maxlen=n)
+        self._frame = deque(maxlen=n)
+        self._stamps = deque(maxlen=n)
+
+    def _window_changed(self, value):
+        for name in ('_compute', '_render', '_frame', '_stamps'):
+            setattr(self, name, deque(getattr(self, name, ()), maxlen=value))
+
+    def _mean(self, values):
+        if len(values) == 0:
+            return 0.0
+        return sum(values)/float(len(values))
+
+    def _get_compute_mean(self):
+        return self._mean(self._compute)
+
+    def _get_compute_p95(self):
+        return percentile(self._compute, 95)
+
+    def _get_compute_max(self):
+        return max(self._compute) if self._compute else 0.0
+
+    def _get_render_mean(self):
+        return self._mean(self._render)
+
+    def _get_render_p95(self):
+        return percentile(self._render, 95)
+
+    def _get_render_max(self):
+        return max(self._render) if self._render else 0.0
+
+    def _get_frame_mean(self):
+        return self._mean(self._frame)
+
+    def _get_frame_p95(self):
+        return percentile(self._frame, 95)
+
+    def _get_frame_max(self):
+        return max(self._frame) if self._frame else 0.0
+
+    def _get_fps(self):
+        stamps = self._stamps
+        if len(stamps) < 2 or stamps[-1] == stamps[0]:
+            return 0.0
+        return (len(stamps) - 1)/(stamps[-1] - stamps[0])
+
 
 ################################################################################
 # `Animator` class.
@@ -39,6 +169,23 @@ class Animator(HasTraits):
 
         If you want to modify the data plotted by an `mlab` function call,
         please refer to the section on: :ref:`mlab-animating-data`
+
+        **Timing and adaptive pacing**
+
+        The animator measures the time taken by every frame and keeps
+        rolling statistics in its `stats` trait (a `FrameStats`
+        instance).  If the `scene` trait is set to the TVTK scene that
+        is being animated (for example ``mlab.gcf().scene``), the time
+        spent rendering is measured separately from the time spent in
+        the callable.
+
+        By default the timer fires every `delay` milliseconds
+        irrespective of how long a frame takes.  When `adaptive` is
+        True the timer instead aims at `target_fps` frames per second:
+        it is paused while a frame is being computed so that ticks do
+        not pile up, and if a frame takes longer than the frame budget
+        the next frame advances the callable several times (at most
+        `max_skip` extra steps) while rendering only once.
     """
 
     ########################################
@@ -49,6 +196,25 @@ class Animator(HasTraits):
     delay = Range(10, 100000, 500,
                   desc='frequency with which timer is called')
 
+    # Pace the animation to `target_fps` instead of using a fixed delay.
+    adaptive = Bool(False, desc='if the animation is paced adaptively')
+
+    # The frame rate to aim for in adaptive mode.
+    target_fps = Range(1, 200, 30,
+                       desc='the frame rate to aim for in adaptive mode')
+
+    # The maximum number of steps merged into a single rendered frame
+    # in adaptive mode.
+    max_skip = Range(0, 1000, 10,
+                     desc='the maximum number of steps merged into one frame')
+
+    # The TVTK scene being animated.  This is optional and is only used
+    # to time renders separately and to suppress renders of merged steps.
+    scene = Any
+
+    # The per-frame timing statistics.
+    stats = Instance(FrameStats, ())
+
     # The internal timer we manage.
     timer = Instance(Timer)
 
@@ -60,10 +226,30 @@ class Animator(HasTraits):
                              show_labels = False
                              ),
                              Item('_'),
-                       Item(name = 'delay'),
+                       Item(name = 'delay', enabled_when='not adaptive'),
+                       Item(name = 'adaptive'),
+                       Item(name = 'target_fps', enabled_when='adaptive'),
                        title = 'Animation Controller',
                        buttons = ['OK'])
 
+    ######################################################################
+    # Private traits.
+
+    # The callable being animated along with its arguments.
+    _callable = Any
+    _args = Any
+    _kwargs = Any
+
+    # The number of steps to take in the next frame (adaptive mode).
+    _n_steps = Int(1)
+
+    # Render time accumulated during the current frame.
+    _render_time = Float(0.0)
+    _render_start = Float(0.0)
+
+    # The observer ids registered on the scene's render window.
+    _observer_ids = Any
+
     ######################################################################
     # Initialize object
     def __init__(self, millisec, callable, *args, **kwargs):
@@ -84,30 +270,118 @@ class Animator(HasTraits):
         """
         HasTraits.__init__(self)
         self.delay = millisec
-        self.timer = Timer(millisec, callable, *args, **kwargs)
+        self._callable = callable
+        self._args = args
+        self._kwargs = kwargs
+        self.timer = Timer(millisec, self._step)
 
     ######################################################################
     # Non-public methods, Event handlers
     def _start_fired(self):
-        self.timer.Start(self.delay)
+        self._n_steps = 1
+        self.timer.Start(self._interval())
 
     def _stop_fired(self):
         self.timer.Stop()
 
     def _delay_changed(self, value):
         t = self.timer
-        if t is None:
+        if t is None or self.adaptive:
             return
         if t.IsRunning():
             t.Stop()
             t.Start(value)
 
+    def _adaptive_changed(self, value):
+        self._n_steps = 1
+        t = self.timer
+        if t is not None and t.IsRunning():
+            t.Stop()
+            t.Start(self._interval())
+
+    def _target_fps_changed(self, value):
+        if self.adaptive:
+            self._adaptive_changed(True)
+
+    def _scene_changed(self, old, new):
+        if old is not None and self._observer_ids is not None:
+            rw = old.render_window
+            if rw is not None:
+                for oid in self._observer_ids:
+                    rw.remove_observer(oid)
+        self._observer_ids = None
+        if new is not None:
+            rw = new.render_window
+            self._observer_ids = (
+                rw.add_observer('StartEvent', self._on_render_start),
+                rw.add_observer('EndEvent', self._on_render_end)
+            )
+
+    def _on_render_start(self, obj, event):
+        self._render_start = time()
+
+    def _on_render_end(self, obj, event):
+        if self._render_start > 0:
+            self._render_time += time() - self._render_start
+            self._render_start = 0.0
+
+    def _interval(self):
+        """The timer interval in milliseconds."""
+        if self.adaptive:
+            return max(1, int(1000.0/self.target_fps))
+        return self.delay
+
+    def _call_n(self, n):
+        """Call the callable `n` times, rendering only once."""
+        func, args, kw = self._callable, self._args, self._kwargs
+        scene = self.scene
+        if n == 1 or scene is None:
+            for i in range(n):
+                func(*args, **kw)
+            return
+        old = scene.disable_render
+        scene.disable_render = True
+        try:
+            for i in range(n):
+                func(*args, **kw)
+        finally:
+            # Re-enabling rendering renders the scene once.
+            scene.disable_render = old
+
+    def _step(self):
+        """Called by the timer; runs one frame and records its timing."""
+        adaptive = self.adaptive
+        if adaptive:
+            # Stop the timer so ticks do not queue up while we work.
+            self.timer.Stop()
+        n = self._n_steps
+        self._render_time = 0.0
+        self._render_start = 0.0
+        t0 = time()
+        # A StopIteration propagates to the timer which then stops.
+        self._call_n(n)
+        elapsed = time() - t0
+        render = min(self._render_time, elapsed)
+        self.stats.record(elapsed - render, render, skipped=n - 1)
+
+        if adaptive and self.adaptive:
+            budget = 1.0/self.target_fps
+            if elapsed > budget:
+                # Catch up by merging the steps we had no time for.
+                self._n_steps = min(int(ceil(elapsed/budget)),
+                                    self.max_skip + 1)
+                wait = 1
+            else:
+                self._n_steps = 1
+                wait = max(1, int(1000.0*(budget - elapsed)))
+            self.timer.Start(wait)
 
 
 ################################################################################
 # Decorators.
 
-def animate(func=None, delay=500, ui=True):
+def animate(func=None, delay=500, ui=True, adaptive=False, target_fps=30,
+            scene=None):
     """ A convenient decorator to animate a generator that performs an
         animation.  The `delay` parameter specifies the delay (in
         milliseconds) between calls to the decorated function. If `ui` is
@@ -125,9 +399,22 @@ def animate(func=None, delay=500, ui=True):
         :ui: bool specifying if a UI controlling the animation is to be
              provided.
 
+        :adaptive: bool specifying if the animation should be paced to
+                   `target_fps` instead of using a fixed delay.  Steps
+                   that cannot be rendered in time are merged into the
+                   next frame.
+
+        :target_fps: int specifying the frame rate to aim for when
+                     `adaptive` is True.
+
+        :scene: the TVTK scene being animated (e.g. ``mlab.gcf().scene``).
+                If given, render times are measured separately and
+                merged steps are not rendered.
+
         **Returns**
 
-        The decorated function returns an `Animator` instance.
+        The decorated function returns an `Animator` instance.  Its
+        `stats` trait holds the rolling frame time statistics.
 
         **Examples**
 
@@ -169,10 +456,15 @@ def animate(func=None, delay=500, ui=True):
             self.func = function
             self.ui = ui
             self.delay = delay
+            self.adaptive = adaptive
+            self.target_fps = target_fps
+            self.scene = scene
         def __call__(self, *args, **kw):
             f = self.func(*args, **kw)
             if isinstance(f, types.GeneratorType):
                 a = Animator(self.delay, f.next)
+                a.set(scene=self.scene, target_fps=self.target_fps,
+                      adaptive=self.adaptive)
                 if self.ui:
                     a.edit_traits()
                 return a
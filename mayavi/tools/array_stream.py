@@ -0,0 +1,304 @@
+"""Binary framing of arrays sent to the Mayavi server.
+
+The `mayavi.tools.server` protocols exec the text they receive.  Arrays
+can also be sent to them, as raw bytes, in frames made of:
+
+ - the magic string `MAGIC`, which cannot start a Python statement, and
+   the size of the header (a little endian unsigned 32 bit integer),
+
+ - the header, a JSON object giving the `source` (the name of a source
+   on the pipeline), the name of the `array` to set (e.g. 'scalars' for
+   an mlab source, 'scalar_data' for an `ArraySource`), its `dtype` (as
+   `numpy.dtype.str`), its `shape` and an optional dirty `region`, a
+   list of [start, stop) per axis,
+
+ - the C ordered bytes of the array, or of the region.
+
+The bytes are copied straight into the array of the source when it has
+the same shape and dtype, or else into a new array.  The sources
+changed are updated once when `ArrayStreamReceiver.flush` is called,
+however many frames they received.  Use `send_array` to send frames::
+
+    >>> s = socket.create_connection(('localhost', 8007))
+    >>> send_array(s, 'ScalarField', 'scalars', data)
+    >>> send_array(s, 'ScalarField', 'scalars', data,
+    ...            region=[(0, 10), (0, 64), (0, 64)])
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import json
+import logging
+import struct
+
+import numpy
+
+
+logger = logging.getLogger(__name__)
+
+# The magic string and the size of the header.
+MAGIC = '\x89M2A'
+PREFIX = struct.Struct('<4sI')
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def _slices(region):
+    return tuple(slice(start, stop) for start, stop in region)
+
+
+def _valid_region(region, shape):
+    """True if `region` has a [start, stop) range within each axis of
+    `shape`, numpy would otherwise clip it."""
+    if len(region) != len(shape):
+        return False
+    for (start, stop), n in zip(region, shape):
+        if not 0 <= start <= stop <= n:
+            return False
+    return True
+
+
+def encode_frame(source, name, arr, region=None):
+    """Returns the header and the payload (a contiguous array) of the
+    frame setting the array `name` of `source` to `arr`, or only its
+    given `region`."""
+    arr = numpy.asarray(arr)
+    payload = arr
+    if region is not None:
+        region = [[int(start), int(stop)] for start, stop in region]
+        if not _valid_region(region, arr.shape):
+            raise ValueError('Invalid region %s of an array of shape %s.'
+                             %(region, arr.shape))
+        payload = arr[_slices(region)]
+    header = json.dumps(dict(source=source, array=name,
+                             dtype=arr.dtype.str, shape=arr.shape,
+                             region=region))
+    return (PREFIX.pack(MAGIC, len(header)) + header,
+            numpy.ascontiguousarray(payload))
+
+
+def send_array(sock, source, name, arr, region=None):
+    """Sends the frame setting the array `name` of `source` (or its
+    `region`) to `arr` on the connected socket `sock`."""
+    header, payload = encode_frame(source, name, arr, region)
+    sock.sendall(header)
+    sock.sendall(buffer(payload))
+
+
+def _text_end(data, offset):
+    """Returns the offset of the first frame after `offset` in `data`,
+    or of its first bytes if they end `data`, or else the size of
+    `data`."""
+    end = data.find(MAGIC, offset)
+    if end >= 0:
+        return end
+    n = len(data)
+    for k in range(len(MAGIC) - 1, 0, -1):
+        if n - k > offset and data.endswith(MAGIC[:k]):
+            return n - k
+    return n
+
+
+def find_source(engine, source_id):
+    """Returns the object holding the arrays of the source named
+    `source_id` on the pipeline of `engine`: its mlab source if any,
+    or the source itself.  Returns None if there is no such source."""
+    objects = list(engine.scenes)
+    while objects:
+        obj = objects.pop(0)
+        if obj.name == source_id:
+            return getattr(obj, 'mlab_source', None) or obj
+        objects.extend(getattr(obj, 'children', []))
+    return None
+
+
+######################################################################
+# `ArrayStreamReceiver` class.
+######################################################################
+class ArrayStreamReceiver(object):
+    """Parses the frames from the data received.  `find_target` is
+    called with the source of a frame and returns the object whose
+    array is set, or None to drop the frame.
+    """
+
+    def __init__(self, find_target):
+        self.find_target = find_target
+        # The prefix and header of the frame being received.
+        self._buf = ''
+        # The frame whose payload is received, the bytes it receives
+        # into and the number of bytes received.
+        self._frame = None
+        self._dest = None
+        self._pos = 0
+        # The number of bytes of a dropped frame left to skip.
+        self._skip = 0
+        # The targets changed since the last flush, by id, with the
+        # arrays set: the new array or None if changed in place.
+        self._dirty = {}
+        # The pending call flushing the receiver, for the servers.
+        self.flush_call = None
+
+    ######################################################################
+    # `ArrayStreamReceiver` interface.
+    ######################################################################
+    def feed(self, data):
+        """Consumes the `data` received.  Returns the text received
+        outside of the frames."""
+        text = []
+        offset, n = 0, len(data)
+        while offset < n:
+            if self._dest is not None:
+                k = min(n - offset, len(self._dest) - self._pos)
+                self._dest[self._pos:self._pos + k] = \
+                        numpy.frombuffer(data, numpy.uint8, k, offset)
+                self._pos += k
+                offset += k
+                if self._pos == len(self._dest):
+                    self._end_frame()
+            elif self._skip > 0:
+                k = min(n - offset, self._skip)
+                self._skip -= k
+                offset += k
+            elif len(self._buf) == 0 and \
+                     not MAGIC.startswith(data[offset:offset + 4]):
+                # Text, up to the next frame.
+                end = _text_end(data, offset)
+                text.append(data[offset:end])
+                offset = end
+            else:
+                offset = self._read_header(data, offset)
+        return ''.join(text)
+
+    def in_frame(self):
+        """True if a frame is partly received."""
+        return len(self._buf) > 0 or self._dest is not None or \
+               self._skip > 0
+
+    def reset(self):
+        """Drops the frame partly received."""
+        self._buf = ''
+        self._frame = self._dest = None
+        self._skip = 0
+
+    def is_dirty(self):
+        """True if arrays were received since the last `flush`."""
+        return len(self._dirty) > 0
+
+    def flush(self):
+        """Sets the new arrays received on their targets and updates
+        the targets changed, each once.  Returns the number of targets
+        updated."""
+        dirty, self._dirty = self._dirty, {}
+        for target, arrays in dirty.values():
+            new = dict((name, arr) for name, (arr, resized) in
+                       arrays.iteritems() if arr is not None)
+            resized = [name for name, (arr, r) in arrays.iteritems() if r]
+            try:
+                if len(resized) > 0 and hasattr(target, 'reset'):
+                    # mlab sources need a reset when the shapes change.
+                    target.reset(**new)
+                elif len(new) > 0:
+                    target.set(**new)
+                if len(new) < len(arrays):
+                    target.update()
+            except:
+                logger.exception('Could not update %r', target)
+        return len(dirty)
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def _read_header(self, data, offset):
+        """Buffers the prefix and the header of a frame.  Returns the
+        offset of the data left."""
+        size = PREFIX.size
+        if len(self._buf) >= size:
+            size += PREFIX.unpack_from(self._buf)[1]
+        k = min(size - len(self._buf), len(data) - offset)
+        self._buf += data[offset:offset + k]
+        if len(self._buf) == PREFIX.size:
+            magic, header_size = PREFIX.unpack(self._buf)
+            if magic != MAGIC or header_size == 0:
+                logger.error('Invalid array frame dropped.')
+                self._buf = ''
+        elif len(self._buf) == size and size > PREFIX.size:
+            header = self._buf[PREFIX.size:]
+            self._buf = ''
+            try:
+                self._begin_frame(json.loads(header))
+            except (ValueError, TypeError, KeyError):
+                logger.exception('Invalid array frame header %r', header)
+                # The rest of the stream cannot be parsed.
+                self.reset()
+                return len(data)
+        return offset + k
+
+    def _begin_frame(self, header):
+        """Sets up the array receiving the payload of the frame."""
+        source, name = header['source'], str(header['array'])
+        dtype = numpy.dtype(str(header['dtype']))
+        shape = tuple(header['shape'])
+        region = header.get('region')
+        size = int(numpy.prod(shape))
+        if region is not None:
+            size = int(numpy.prod([max(stop - start, 0)
+                                   for start, stop in region]))
+        nbytes = size*dtype.itemsize
+        if region is not None and not _valid_region(region, shape):
+            # The region of the array would not have the size of the
+            # payload.
+            logger.error('Invalid region %r of %s.%s, array frame '
+                         'dropped.', region, source, name)
+            self._skip = nbytes
+            return
+
+        target = self.find_target(source)
+        if target is None:
+            logger.error('No source %r, array frame dropped.', source)
+            self._skip = nbytes
+            return
+        # An array received since the last flush is used again.
+        arrays = self._dirty.get(id(target), (target, {}))[1]
+        arr, resized = arrays.get(name, (None, False))
+        if arr is None:
+            arr = getattr(target, name, None)
+        new = not isinstance(arr, numpy.ndarray) or \
+              arr.dtype != dtype or arr.shape != shape or \
+              not arr.flags.writeable
+        if new:
+            if region is not None:
+                logger.error('Region of %s.%s with another shape or '
+                             'dtype, array frame dropped.', source, name)
+                self._skip = nbytes
+                return
+            resized = not isinstance(arr, numpy.ndarray) or \
+                      arr.shape != shape
+            arr = numpy.empty(shape, dtype)
+        elif name in arrays:
+            new = arrays[name][0] is not None
+        view = arr
+        if region is not None:
+            view = arr[_slices(region)]
+        scratch = None
+        if view.flags.c_contiguous:
+            dest = view.reshape(-1).view(numpy.uint8)
+        else:
+            # Received and then copied into the region.
+            scratch = numpy.empty(view.shape, dtype)
+            dest = scratch.reshape(-1).view(numpy.uint8)
+        self._frame = (target, name, arr if new else None, resized,
+                       view, scratch)
+        self._dest = dest
+        self._pos = 0
+        if nbytes == 0:
+            self._end_frame()
+
+    def _end_frame(self):
+        target, name, arr, resized, view, scratch = self._frame
+        self._frame = self._dest = None
+        if scratch is not None:
+            view[...] = scratch
+        arrays = self._dirty.setdefault(id(target), (target, {}))[1]
+        arrays[name] = (arr, resized)
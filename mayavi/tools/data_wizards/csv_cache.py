@@ -0,0 +1,230 @@
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+""" A binary sidecar cache for parsed CSV files.
+
+    The sniffed options and the parsed columns of a CSV file are saved
+    in a directory next to the file, one `.npy` file per column.  The
+    cached columns are memory-mapped when the file is opened again, so
+    reopening is fast and the pages are shared between processes.  An
+    entry is only used if the path, size and modification time of the
+    CSV file and the parse options are unchanged.
+
+    Example::
+
+        kwds = cached_sniff('mydata.csv')
+        columns = cached_load_columns('mydata.csv', **kwds)
+
+    `cached_loadtxt` returns a structured array like `loadtxt`, which
+    is a copy of the cached columns.
+"""
+
+import os
+import json
+import hashlib
+from os.path import abspath, basename, dirname, exists, join
+
+import numpy as np
+
+from mayavi.tools.data_wizards.csv_sniff import Sniff, array2dict
+from mayavi.tools.data_wizards.loadtxt import fast_loadtxt
+
+# The version of the format of the cache.
+CACHE_VERSION = 1
+
+
+def cache_dir(fname):
+    """ Returns the directory holding the cache of the file `fname`.
+    """
+    fname = abspath(fname)
+    return join(dirname(fname), '.%s.mvcache' % basename(fname))
+
+
+def _file_id(fname):
+    st = os.stat(fname)
+    return [abspath(fname), st.st_size, repr(st.st_mtime)]
+
+
+def _options_id(kwds):
+    """ A string identifying the parse options.
+    """
+    kwds = dict(kwds)
+    dtype = kwds.pop('dtype', float)
+    items = sorted((k, repr(v)) for k, v in kwds.items())
+    return repr((items, np.dtype(dtype).descr))
+
+
+def cache_key(fname, kwds):
+    """ Returns the key of the cache entry for `fname` parsed with the
+        keyword arguments `kwds`.
+    """
+    return hashlib.md5(repr((_file_id(fname),
+                             _options_id(kwds)))).hexdigest()
+
+
+def _read_json(fname):
+    try:
+        f = open(fname, 'r')
+        try:
+            return json.load(f)
+        finally:
+            f.close()
+    except (IOError, OSError, ValueError):
+        return None
+
+
+def _write_json(fname, obj):
+    f = open(fname, 'w')
+    try:
+        json.dump(obj, f)
+    finally:
+        f.close()
+
+
+def _encode_dtype(dtype):
+    """ Makes the dtype dict of `Sniff.dtype()` JSON friendly.
+    """
+    formats = [f if isinstance(f, basestring) else np.dtype(f).str
+               for f in dtype['formats']]
+    return {'names': list(dtype['names']), 'formats': formats}
+
+
+def _decode_dtype(dtype):
+    formats = tuple(float if f == np.dtype(float).str else str(f)
+                    for f in dtype['formats'])
+    return {'names': tuple(str(n) for n in dtype['names']),
+            'formats': formats}
+
+
+def cached_sniff(fname, sample_size=0):
+    """ Returns `Sniff(fname, sample_size).kwds()`, from the cache if
+        the file did not change since it was last sniffed.
+    """
+    d = cache_dir(fname)
+    meta_name = join(d, 'sniff.json')
+    file_id = _file_id(fname)
+    meta = _read_json(meta_name)
+    if meta is not None and meta.get('version') == CACHE_VERSION and \
+           meta['file'] == file_id and \
+           meta.get('sample_size', 0) == sample_size:
+        kwds = dict((str(k), v) for k, v in meta['kwds'].items())
+        for k in ('comments', 'delimiter'):
+            if kwds[k] is not None:
+                kwds[k] = str(kwds[k])
+        kwds['dtype'] = _decode_dtype(kwds['dtype'])
+        return kwds
+
+    kwds = Sniff(fname, sample_size).kwds()
+    try:
+        if not exists(d):
+            os.mkdir(d)
+        cached = dict(kwds)
+        cached['dtype'] = _encode_dtype(kwds['dtype'])
+        _write_json(meta_name, {'version': CACHE_VERSION, 'file': file_id,
+                                'sample_size': sample_size,
+                                'kwds': cached})
+    except (IOError, OSError):
+        pass
+    return kwds
+
+
+def load_columns(fname, kwds, mmap_mode='r'):
+    """ Returns a dict mapping the column names to the memory-mapped
+        cached columns of `fname` parsed with `kwds`, or None if there is
+        no valid cache entry.
+    """
+    d = cache_dir(fname)
+    key = cache_key(fname, kwds)
+    meta = _read_json(join(d, key + '.json'))
+    if meta is None or meta.get('version') != CACHE_VERSION:
+        return None
+    try:
+        return dict((name, np.load(join(d, '%s_%d.npy' % (key, i)),
+                                   mmap_mode=mmap_mode))
+                    for i, name in enumerate(meta['names']))
+    except (IOError, OSError, ValueError):
+        return None
+
+
+def load(fname, kwds):
+    """ Returns the cached array of `fname` parsed with `kwds` (as
+        `loadtxt` would return it) or None.  The columns are copied
+        into a structured array, use `load_columns` to avoid the copy.
+    """
+    columns = load_columns(fname, kwds)
+    if columns is None:
+        return None
+    dtype = np.dtype(kwds.get('dtype', float))
+    if dtype.names is None:
+        return columns['0']
+    first = columns[dtype.names[0]]
+    data = np.empty(first.shape, dtype)
+    for name in dtype.names:
+        data[name] = columns[name]
+    return data
+
+
+def save(fname, kwds, data):
+    """ Saves the array `data` read from `fname` with `kwds`.  Errors
+        (e.g. a read-only directory) are ignored.
+    """
+    d = cache_dir(fname)
+    key = cache_key(fname, kwds)
+    data = np.asarray(data)
+    if data.dtype.names is None:
+        names = ['0']
+        columns = [data]
+    else:
+        names = list(data.dtype.names)
+        columns = [data[name] for name in names]
+    try:
+        if not exists(d):
+            os.mkdir(d)
+        # Remove the stale entries of this file.
+        for name in os.listdir(d):
+            if name != 'sniff.json' and not name.startswith(key):
+                os.remove(join(d, name))
+        for i, column in enumerate(columns):
+            np.save(join(d, '%s_%d.npy' % (key, i)),
+                    np.ascontiguousarray(column))
+        # The metadata is written last: an entry is valid once it exists.
+        _write_json(join(d, key + '.json'),
+                    {'version': CACHE_VERSION, 'names': names})
+    except (IOError, OSError):
+        pass
+
+
+def cached_load_columns(fname, progress=None, mmap_mode='c', **kwds):
+    """ Returns a dict mapping the column names of `fname` parsed with
+        `kwds` to the columns.  The columns are memory-mapped from the
+        cache, which is written first if needed, so that nothing is
+        copied and the pages are shared between processes.  The
+        default `mmap_mode` copies the pages that are written to.
+    """
+    columns = load_columns(fname, kwds, mmap_mode)
+    if columns is None:
+        data = fast_loadtxt(fname, progress=progress, **kwds)
+        save(fname, kwds, data)
+        columns = load_columns(fname, kwds, mmap_mode)
+        if columns is None:
+            # The cache could not be written.
+            if data.dtype.names is None:
+                columns = {'0': data}
+            else:
+                columns = array2dict(data)
+    if progress is not None:
+        progress(1.0)
+    return columns
+
+
+def cached_loadtxt(fname, progress=None, **kwds):
+    """ Like `fast_loadtxt` but using the sidecar cache of `fname`.
+    """
+    data = load(fname, kwds)
+    if data is not None:
+        if progress is not None:
+            progress(1.0)
+        return data
+    data = fast_loadtxt(fname, progress=progress, **kwds)
+    save(fname, kwds, data)
+    return data
@@ -3,8 +3,10 @@
 # License: BSD Style.
 
 
+import numpy as np
+
 from traits.api import HasTraits, Str, Int, Array, List, \
-    Instance, on_trait_change, Property, Button
+    Instance, on_trait_change, Property, Button, Range, Bool, Any
 
 from pyface.api import GUI
 
@@ -13,8 +15,11 @@ from traitsui.api import View, Item, HGroup, Group, \
 
 from traitsui.tabular_adapter import TabularAdapter
 
-from mayavi.tools.data_wizards.csv_sniff import Sniff, loadtxt, \
+from mayavi.tools.data_wizards.csv_sniff import Sniff, fast_loadtxt, \
         array2dict
+from mayavi.tools.data_wizards.csv_cache import cached_sniff, \
+        cached_load_columns
+from mayavi.core.common import process_ui_events
 
 ##############################################################################
 # ListItem class
@@ -59,16 +64,43 @@ class CSVLoader(HasTraits):
 
     columns = List(ListItem)
 
+    # Keep the sniffed options and the parsed data in a binary cache
+    # next to the file, so that reopening it does not parse it again.
+    # The columns are then memory-mapped from the cache and `data` only
+    # holds the first `preview_rows` rows.
+    use_cache = Bool(False,
+        desc="if the parsed data is cached in binary files next to the file")
+
+    # If not zero, the column types are guessed from blocks of this
+    # size (in bytes) in total, spread across the file, rather than
+    # from the first lines only.
+    sample_size = Int(0,
+        desc="the number of bytes sampled across the file to guess types")
+
+    # The number of rows shown in the preview when the cache is used.
+    preview_rows = Int(1000)
+
+    # The fraction of the file loaded by the last call to `load_data`.
+    progress = Range(0.0, 1.0, desc="The fraction of the file loaded")
+
     data = Array
 
     data_dict = Property(depends_on='data')
 
+    # The columns memory-mapped from the cache.
+    _columns = Any
+
     def _get_data_dict(self):
+        if self._columns is not None:
+            return self._columns
         return array2dict(self.data)
 
     def guess_defaults(self):
         try:
-            kwds = Sniff(self.filename).kwds()
+            if self.use_cache:
+                kwds = cached_sniff(self.filename, self.sample_size)
+            else:
+                kwds = Sniff(self.filename, self.sample_size).kwds()
         except:
             kwds = { 'comments': '#',
                      'delimiter': ',',
@@ -100,10 +132,35 @@ class CSVLoader(HasTraits):
         kwds['dtype'] = dict(names=self.names,
                              formats=self.formats)
 
+        self.progress = 0.0
         try:
-            self.data = loadtxt(self.filename, **kwds)
+            if self.use_cache:
+                self._columns = cached_load_columns(self.filename,
+                                    progress=self._update_progress, **kwds)
+                self.data = self._preview(kwds['dtype'])
+            else:
+                self._columns = None
+                self.data = fast_loadtxt(self.filename,
+                                    progress=self._update_progress, **kwds)
         except:
             pass
+        self.progress = 1.0
+
+    def _preview(self, dtype):
+        """Returns the first rows of the cached columns as a structured
+        array."""
+        dtype = np.dtype(dtype)
+        columns = self._columns
+        n = min(len(columns[name]) for name in dtype.names)
+        n = min(n, self.preview_rows)
+        data = np.empty(n, dtype)
+        for name in dtype.names:
+            data[name] = columns[name][:n]
+        return data
+
+    def _update_progress(self, fraction):
+        self.progress = fraction
+        process_ui_events()
 
 
 
@@ -163,6 +220,9 @@ class CSVLoaderController(Controller):
                            spring,
                            Item('handler.update_preview',
                                                 show_label=False),
+                           Item('progress', style='readonly',
+                                label='Loaded',
+                                format_func=lambda v: '%d%%' % (100*v)),
                        ),
                        Group(
                            Item('columns',
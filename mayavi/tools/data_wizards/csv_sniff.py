@@ -4,10 +4,36 @@
 
 # TODO: should derive from HasTraits
 
+import os
 import csv
+import mmap
 
 # FIXME: see loadtxt.py (should really be the loadtxt from numpy)
-from mayavi.tools.data_wizards.loadtxt import loadtxt
+from mayavi.tools.data_wizards.loadtxt import loadtxt, fast_loadtxt
+
+
+# The number of blocks spread across the file that are read when
+# sampling.
+SAMPLE_BLOCKS = 16
+
+# The ranks of the column types inferred from a sample, a column gets the
+# widest type of its values.
+_INT, _FLOAT, _STR = 0, 1, 2
+
+
+def _kind_of(s):
+    """ Returns the type rank of the string value `s`.
+    """
+    try:
+        int(s)
+        return _INT
+    except ValueError:
+        pass
+    try:
+        float(s)
+        return _FLOAT
+    except ValueError:
+        return _STR
 
 
 class Sniff(object):
@@ -27,9 +53,21 @@ class Sniff(object):
 
             from numpy import loadtxt     # make sure it's numpy 1.1.0 or higher
             b = loadtxt('mydata.csv', **s.kwds())
+
+        The properties are normally determined from the first lines of
+        the file only.  For large files, a `sample_size` (in bytes) may
+        be given: blocks spread across the whole file are then read
+        (memory-mapped) up to this budget and the column types (int,
+        float or strings of a given width) are inferred from all the
+        sampled lines.  `sample_report()` tells how reliable this is::
+
+            s = Sniff('huge.csv', sample_size=1024*1024)
+            print s.sample_report()['confidence']
     """
-    def __init__(self, filename):
+    def __init__(self, filename, sample_size=0):
         self._filename = filename
+        self._split_cache = {}
+        self._types_cache = {}
         self._lines = self._read_few_lines()
         self._reallines = [line for line in self._lines if line.strip()]
         self._dialect = csv.Sniffer().sniff(self._reallines[-1])
@@ -44,6 +82,10 @@ class Sniff(object):
 
         self._datatypes = self._datatypes_of_line(self._reallines[-1])
 
+        self._sample = None
+        if sample_size > 0:
+            self._sample = self._sample_file(sample_size)
+
     def _get_comment(self):
         self._comment = '#'
         line0 = self._reallines[0]
@@ -57,7 +99,10 @@ class Sniff(object):
     def _read_few_lines(self):
         res = []
         f = open(self._filename, 'rb')
+        # The offset of the end of the lines read.
+        self._head_size = 0
         for line in f:
+            self._head_size += len(line)
             line = line.strip()
             res.append(line)
             if len(res) > 20:
@@ -66,10 +111,17 @@ class Sniff(object):
         return res
 
     def _split(self, line):
+        # The few lines read are split many times.
+        try:
+            return self._split_cache[line]
+        except KeyError:
+            pass
         if self._usePySplit:
-            return line.split()
+            res = line.split()
         else:
-            return csv.reader([line], self._dialect).next()
+            res = csv.reader([line], self._dialect).next()
+        self._split_cache[line] = res
+        return res
 
     def _names(self):
         if self._datatypes != self._numcols * (str,):
@@ -83,6 +135,9 @@ class Sniff(object):
         return tuple('Column %i' % (i+1) for i in xrange(self._numcols))
 
     def _formats(self):
+        if self._sample is not None:
+            return tuple(col[1] for col in self._sample['columns'])
+
         res = []
         for c, t in enumerate(self._datatypes):
             if t == str:
@@ -100,6 +155,13 @@ class Sniff(object):
         return tuple(res)
 
     def _datatypes_of_line(self, line):
+        try:
+            return self._types_cache[line]
+        except KeyError:
+            res = self._types_cache[line] = self._compute_datatypes(line)
+            return res
+
+    def _compute_datatypes(self, line):
 
         def isFloat(s):
             try:
@@ -117,6 +179,120 @@ class Sniff(object):
 
         return tuple(res)
 
+    def _sample_lines(self, sample_size):
+        """ Returns a list with the lines of each block sampled from the
+            part of the file after the first lines, and the number of
+            bytes read.
+        """
+        f = open(self._filename, 'rb')
+        try:
+            size = os.fstat(f.fileno()).st_size
+            start = self._head_size
+            if size <= start:
+                return [], 0
+            buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        finally:
+            f.close()
+
+        try:
+            n_blocks = SAMPLE_BLOCKS
+            block = max(sample_size//n_blocks, 1)
+            if (size - start) <= sample_size:
+                # Read all the rest in one go.
+                n_blocks, block = 1, size - start
+            stride = (size - start - block)//max(n_blocks - 1, 1)
+            blocks = []
+            nbytes = 0
+            for i in xrange(n_blocks):
+                begin = start + i*stride
+                end = min(begin + block, size)
+                if begin > start:
+                    # Drop the partial first line.
+                    nl = buf.find('\n', begin - 1, end)
+                    if nl == -1:
+                        continue
+                    begin = nl + 1
+                if end < size:
+                    # Drop the partial last line.
+                    end = buf.rfind('\n', begin, end) + 1
+                    if end <= begin:
+                        continue
+                nbytes += end - begin
+                blocks.append(buf[begin:end].splitlines())
+        finally:
+            buf.close()
+        return blocks, nbytes
+
+    def _sample_file(self, sample_size):
+        """ Infers the types of the columns from the data lines among the
+            first lines and from a sample of the rest of the file.
+        """
+        blocks, nbytes = self._sample_lines(sample_size)
+        skip = self.skiprows()
+        blocks.insert(0, self._lines[skip:])
+
+        ncols = self._numcols
+        comment = self._comment
+        # The values are split the way the loaders do, so that the string
+        # widths fit what they read.
+        delimiter = self.delimiter()
+        # The type rank and the width of each column for each block.
+        stats = []
+        n_lines = n_irregular = 0
+        for lines in blocks:
+            lines = [line.split(comment, 1)[0].strip() for line in lines]
+            lines = [line for line in lines if line]
+            kinds = [_INT]*ncols
+            widths = [1]*ncols
+            for line in lines:
+                values = line.split(delimiter)
+                n_lines += 1
+                if len(values) != ncols:
+                    n_irregular += 1
+                    continue
+                for c, v in enumerate(values):
+                    if kinds[c] != _STR:
+                        kinds[c] = max(kinds[c], _kind_of(v))
+                    widths[c] = max(widths[c], len(v))
+            if lines:
+                stats.append((kinds, widths))
+
+        size = os.path.getsize(self._filename)
+        complete = nbytes + self._head_size >= size
+        columns = []
+        names = self._names()
+        for c in xrange(ncols):
+            kind = max(s[0][c] for s in stats) if stats else _STR
+            width = max(s[1][c] for s in stats) if stats else 1
+            if kind == _INT:
+                fmt = 'i8'
+                agree = [s for s in stats if s[0][c] == _INT]
+            elif kind == _FLOAT:
+                fmt = float
+                agree = [s for s in stats if s[0][c] != _STR]
+            else:
+                fmt = 'S%i' % width
+                agree = [s for s in stats if s[0][c] == _STR and
+                                             s[1][c] == width]
+            if complete:
+                # The types are known, not guessed.
+                confidence = 1.0
+            elif stats:
+                confidence = float(len(agree))/len(stats)
+            else:
+                confidence = 0.0
+            columns.append((names[c], fmt, confidence))
+
+        regular = 1.0 - float(n_irregular)/max(n_lines, 1)
+        confidence = min([col[2] for col in columns] or [0.0])*regular
+        return {'file_size': size,
+                'bytes_sampled': nbytes + min(self._head_size, size),
+                'blocks': len(blocks) - 1,
+                'lines': n_lines,
+                'irregular_lines': n_irregular,
+                'columns': columns,
+                'confidence': confidence}
+
     def _debug(self):
         print '===== Sniffed information for file %r:' % self._filename
         print 'delimiter = %r' % self.delimiter()
@@ -157,6 +333,27 @@ class Sniff(object):
         return {'names': self._names(),
                 'formats': self._formats()}
 
+    def sample_report(self):
+        """ Return a dict describing the sample the column types were
+            inferred from (or None if the file was not sampled):
+
+            file_size, bytes_sampled: the sizes of the file and of the
+                data read.
+            blocks: the number of blocks sampled after the first lines.
+            lines, irregular_lines: the number of sampled lines and of
+                those with a different number of values.
+            columns: a list of (name, format, confidence) tuples, the
+                confidence of a column is the fraction of the sampled
+                blocks whose values give the same type (and string
+                width) as the whole sample, or 1 if the whole file was
+                read.  A low value means that the type varies along the
+                file, and that the unsampled parts may need a wider
+                type.
+            confidence: the lowest column confidence, scaled by the
+                fraction of regular lines.
+        """
+        return self._sample
+
     def kwds(self):
         """ Return a dict of the keyword argument needed by numpy.loadtxt
         """
@@ -165,11 +362,13 @@ class Sniff(object):
                 'skiprows' : self.skiprows(),
                 'dtype'    : self.dtype()}
 
-    def loadtxt(self):
+    def loadtxt(self, progress=None):
         """ Return the array (by using numpy.loadtxt), using the sniffed
-            information in the keyword arguments.
+            information in the keyword arguments.  `progress`, if given,
+            is called with the fraction of the file loaded.
         """
-        return loadtxt(self._filename, **self.kwds())
+        return fast_loadtxt(self._filename, progress=progress,
+                            **self.kwds())
 
 
 
@@ -1,5 +1,6 @@
 
-from numpy import c_, zeros, arange
+from numpy import zeros, arange, empty, asarray, result_type, \
+    float32
 
 from traits.api import HasStrictTraits, \
     true, false, CArray, Trait, Instance
@@ -12,6 +13,34 @@ from tvtk.api import tvtk
 
 ArrayOrNone = Trait(None, (None, CArray))
 
+
+def _flat(a, dtype=None):
+    """ Returns the array `a` flattened (in C order) and of type `dtype`
+        (if given), without copying it when it is already contiguous and
+        of the right type.
+    """
+    a = asarray(a)
+    if dtype is not None and a.dtype != dtype:
+        a = a.astype(dtype)
+    return a.ravel()
+
+
+def _interleave(x, y, z, dtype=None):
+    """ Returns a contiguous (N, 3) array made of the flattened arrays
+        `x`, `y` and `z`.  Each component is copied once, straight into
+        its strided column of the result.
+    """
+    x, y, z = asarray(x), asarray(y), asarray(z)
+    if dtype is None:
+        dtype = result_type(x, y, z)
+    out = empty((x.size, 3), dtype)
+    for i, a in enumerate((x, y, z)):
+        column = out[:, i]
+        # Setting the shape never copies, the column stays a view.
+        column.shape = a.shape
+        column[...] = a
+    return out
+
 ############################################################################
 # The DataSourceFactory class
 ############################################################################
@@ -55,6 +84,10 @@ class DataSourceFactory(HasStrictTraits):
     vector_v = ArrayOrNone
     vector_w = ArrayOrNone
 
+    # Whether the points and the data are stored as single precision
+    # floats, halving the memory of double precision columns.
+    single_precision = false
+
 
     #----------------------------------------------------------------------
     # Private traits
@@ -69,11 +102,32 @@ class DataSourceFactory(HasStrictTraits):
     # Private interface
     #----------------------------------------------------------------------
 
+    def _float_type(self):
+        """ The type of the floating point arrays given to VTK, None to
+            keep the type of the input.
+        """
+        if self.single_precision:
+            return float32
+        return None
+
+
+    def _points(self):
+        """ The interleaved positions of the points.
+        """
+        dtype = self._float_type()
+        if dtype is None:
+            dtype = result_type(self.position_x, self.position_y,
+                                self.position_z, float32)
+        return _interleave(self.position_x, self.position_y,
+                           self.position_z, dtype)
+
+
     def _add_scalar_data(self):
         """ Adds the scalar data to the vtk source.
         """
-        if self.scalar_data is not None:
-            scalars = self.scalar_data.ravel()
+        if self.scalar_data is not None and not self.position_implicit:
+            # Contiguous scalars are handed to VTK without a copy.
+            scalars = _flat(self.scalar_data, self._float_type())
             self._vtk_source.point_data.scalars = scalars
 
 
@@ -81,10 +135,8 @@ class DataSourceFactory(HasStrictTraits):
         """ Adds the vector data to the vtk source.
         """
         if self.has_vector_data:
-            vectors = c_[ self.vector_u.ravel(),
-                          self.vector_v.ravel(),
-                          self.vector_w.ravel(),
-                        ]
+            vectors = _interleave(self.vector_u, self.vector_v,
+                                  self.vector_w, self._float_type())
             self._vtk_source.point_data.vectors = vectors
 
 
@@ -92,10 +144,7 @@ class DataSourceFactory(HasStrictTraits):
         """ Creates a PolyData vtk data set using the factory's
             attributes.
         """
-        points = c_[ self.position_x.ravel(),
-                     self.position_y.ravel(),
-                     self.position_z.ravel(),
-                   ]
+        points = self._points()
         lines = None
         if self.lines:
             np = len(points) - 1
@@ -115,8 +164,12 @@ class DataSourceFactory(HasStrictTraits):
         """ Creates an ImageData VTK data set and the associated ArraySource
             using the factory's attributes.
         """
+        # The ArraySource also sets the scalars of the image data.
+        scalars = self.scalar_data
+        if self.single_precision and scalars.dtype != float32:
+            scalars = scalars.astype(float32)
         self._mayavi_source = ArraySource(  transpose_input_array=True,
-                                            scalar_data=self.scalar_data,
+                                            scalar_data=scalars,
                                             origin=[0., 0., 0],
                                             spacing=[1, 1, 1])
         self._vtk_source = self._mayavi_source.image_data
@@ -138,9 +191,10 @@ class DataSourceFactory(HasStrictTraits):
             z = z[0, 0, :]
         # FIXME: We should check array size here.
         rg.dimensions = (x.size, y.size, z.size)
-        rg.x_coordinates = x
-        rg.y_coordinates = y
-        rg.z_coordinates = z
+        dtype = self._float_type()
+        rg.x_coordinates = _flat(x, dtype)
+        rg.y_coordinates = _flat(y, dtype)
+        rg.z_coordinates = _flat(z, dtype)
         self._vtk_source = rg
         self._mayavi_source = VTKDataSource(data=self._vtk_source)
 
@@ -152,10 +206,7 @@ class DataSourceFactory(HasStrictTraits):
         # FIXME: We need to figure out the dimensions of the data
         # here, if any.
         sg = tvtk.StructuredGrid(dimensions=self.scalar_data.shape)
-        sg.points = c_[ self.position_x.ravel(),
-                        self.position_y.ravel(),
-                        self.position_z.ravel(),
-                      ]
+        sg.points = self._points()
         self._vtk_source = sg
         self._mayavi_source = VTKDataSource(data=self._vtk_source)
 
@@ -4,6 +4,8 @@
 #   In the future this file can be removed, once Mayavi depends on
 #   numpy 1.1.0 (or higher).
 
+import os
+import mmap
 import numpy as np
 
 def _string_like(obj):
@@ -123,3 +125,202 @@ def loadtxt(fname, dtype=float, comments='#', delimiter=None, converters=None,
     X = np.squeeze(X)
     if unpack: return X.T
     else: return X
+
+
+#-----------------------------------------------------------------------------
+# Chunked loader for large numerical files.
+#-----------------------------------------------------------------------------
+
+# The size of the blocks of the file parsed at once.
+CHUNK_SIZE = 8*1024*1024
+
+
+def _is_numeric(dtype):
+    """True if all the fields of `dtype` are integers or floats."""
+    if dtype.names is None:
+        return dtype.kind in 'if'
+    return all(dtype.fields[name][0].kind in 'if' for name in dtype.names)
+
+
+def _strip_comments(text, comments):
+    return '\n'.join(line.split(comments, 1)[0]
+                     for line in text.split('\n'))
+
+
+def _count_values(text):
+    """Returns the number of values on each line of `text` that has
+    any, the values being separated by blanks."""
+    a = np.frombuffer(text, np.uint8)
+    blank = (a == ord(' ')) | (a == ord('\t')) | (a == ord('\r'))
+    newline = a == ord('\n')
+    blank |= newline
+    # A value starts where a blank is followed by something else.
+    starts = ~blank
+    starts[1:] &= blank[:-1]
+    lines = np.searchsorted(np.flatnonzero(newline), np.flatnonzero(starts))
+    counts = np.bincount(lines)
+    return counts[counts > 0]
+
+
+def _parse_chunk(text, comments, delimiter, ncols):
+    """Parses a block of complete lines and returns a 2D float array, or
+    None if the block is not a regular table of `ncols` numbers."""
+    if comments and text.find(comments) != -1:
+        text = _strip_comments(text, comments)
+    if delimiter is not None:
+        text = text.replace(delimiter, ' ')
+    # Every line must have `ncols` values, a missing value would
+    # otherwise shift the values of the next rows.
+    counts = _count_values(text)
+    if (counts != ncols).any():
+        return None
+    nrows = len(counts)
+    try:
+        values = np.fromstring(text, dtype=float, sep=' ')
+    except ValueError:
+        return None
+    if values.size != nrows*ncols:
+        return None
+    return values.reshape(nrows, ncols)
+
+
+def _chunks(buf, start, chunk_size):
+    """Yields (begin, end) offsets of blocks of complete lines of the
+    buffer `buf` starting at `start`."""
+    size = len(buf)
+    while start < size:
+        end = min(start + chunk_size, size)
+        if end < size:
+            nl = buf.find('\n', end)
+            end = size if nl == -1 else nl + 1
+        yield start, end
+        start = end
+
+
+def fast_loadtxt(fname, dtype=float, comments='#', delimiter=None,
+                 skiprows=0, usecols=None, unpack=False, progress=None,
+                 chunk_size=CHUNK_SIZE):
+    """
+    Load a table of numbers from the file `fname`, like `loadtxt`, but
+    memory-mapping the file and parsing it in large blocks with
+    numpy's C text parser instead of converting every value in
+    Python.
+
+    The keyword arguments are those of `loadtxt` (and thus those given
+    by `Sniff.kwds()`).  `progress`, if given, is called with the
+    fraction of the file parsed after each block.
+
+    Files that are not a plain table of numbers (string columns,
+    missing values, quoted fields, gzipped files) are handed to
+    `loadtxt`.
+    """
+    dtype = np.dtype(dtype)
+    if not _string_like(fname) or fname.endswith('.gz') or \
+           not _is_numeric(dtype):
+        return loadtxt(fname, dtype=dtype, comments=comments,
+                       delimiter=delimiter, skiprows=skiprows,
+                       usecols=usecols, unpack=unpack)
+
+    f = open(fname, 'rb')
+    try:
+        size = os.fstat(f.fileno()).st_size
+        if size == 0:
+            buf = ''
+        else:
+            buf = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        try:
+            result = _fast_load(buf, dtype, comments, delimiter, skiprows,
+                                usecols, progress, chunk_size)
+        finally:
+            if size != 0:
+                buf.close()
+    finally:
+        f.close()
+
+    if result is None:
+        return loadtxt(fname, dtype=dtype, comments=comments,
+                       delimiter=delimiter, skiprows=skiprows,
+                       usecols=usecols, unpack=unpack)
+    X = np.squeeze(result)
+    if unpack: return X.T
+    else: return X
+
+
+def _fast_load(buf, dtype, comments, delimiter, skiprows, usecols,
+               progress, chunk_size):
+    size = len(buf)
+    # Skip the first rows.
+    start = 0
+    for i in xrange(skiprows):
+        nl = buf.find('\n', start)
+        if nl == -1:
+            start = size
+            break
+        start = nl + 1
+
+    # The number of values on the first line with data.
+    ncols = 0
+    pos = start
+    while pos < size and ncols == 0:
+        nl = buf.find('\n', pos)
+        if nl == -1:
+            nl = size
+        line = buf[pos:nl]
+        if comments:
+            line = line.split(comments, 1)[0]
+        ncols = len(line.split(delimiter)) if line.strip() else 0
+        pos = nl + 1
+    if ncols == 0:
+        return np.array([], dtype)
+
+    if usecols is None:
+        cols = range(ncols)
+    else:
+        cols = list(usecols)
+    names = dtype.names
+    if names is not None and len(names) != len(cols):
+        return None
+
+    # The columns of each block are written into the typed result,
+    # whose size is estimated from the first block and grown if needed.
+    X = None
+    row = 0
+    for begin, end in _chunks(buf, start, chunk_size):
+        block = _parse_chunk(buf[begin:end], comments, delimiter, ncols)
+        if block is None:
+            return None
+        if usecols is not None:
+            block = block[:, cols]
+        n = len(block)
+        capacity = 0 if X is None else len(X)
+        if row + n > capacity:
+            estimate = int(1.05*(row + n)*(size - start)/(end - start)) + 1
+            X = _grow(X, row, max(estimate, int(1.5*capacity)), dtype,
+                      len(cols))
+        if names is None:
+            X[row:row + n] = block
+        else:
+            for j, name in enumerate(names):
+                X[name][row:row + n] = block[:, j]
+        row += n
+        if progress is not None:
+            progress(float(end)/size)
+
+    if X is None:
+        return np.array([], dtype)
+    if row < len(X):
+        # Do not keep the unused rows of the estimate alive.
+        return X[:row].copy()
+    return X
+
+
+def _grow(X, nrows, capacity, dtype, ncols):
+    """Returns an array of `capacity` rows holding the first `nrows`
+    rows of `X`."""
+    if dtype.names is None:
+        new = np.empty((capacity, ncols), dtype)
+    else:
+        new = np.empty(capacity, dtype)
+    if X is not None:
+        new[:nrows] = X[:nrows]
+    return new
@@ -193,6 +193,32 @@ def draw(figure=None):
     figure.render()
 
 
+def render_stats(figure=None, reset=False):
+    """ Returns the render statistics of the current figure: frame time
+        percentiles and histogram, renders per second, primitives drawn
+        and renders suppressed by `disable_render`.
+
+        **Keyword arguments**
+
+        :figure: the figure to use, the current figure by default.
+
+        :reset: if True, the statistics are cleared.
+
+        **Example**
+
+        ::
+
+            stats = mlab.render_stats()
+            print stats.p95_time, stats.to_dict()
+    """
+    if figure is None:
+        figure = gcf()
+    stats = figure.scene.render_stats
+    if reset:
+        stats.reset()
+    return stats
+
+
 def savefig(filename, size=None, figure=None, magnification='auto',
                     **kwargs):
     """ Save the current scene.
@@ -26,9 +26,16 @@ from mayavi.core.scene import Scene
 from auto_doc import traits_doc, dedent
 import tools
 from traits.api import Array, Callable, CFloat, HasTraits, \
-    List, Trait, Any, Instance, TraitError, true
+    List, Trait, Any, Instance, TraitError, true, Bool
 import numpy
 
+# The option of the functions plotting data on a grid.
+implicit_geometry = Bool(False,
+                help="""if True, coordinates that are equally spaced or
+                        on a rectilinear grid are stored as an image
+                        data or a rectilinear grid instead of as
+                        points.""")
+
 def document_pipeline(pipeline):
     def the_function(*args, **kwargs):
         return pipeline(*args, **kwargs)
@@ -61,6 +68,11 @@ class Pipeline(HasTraits):
     figure = Instance('mayavi.core.scene.Scene',
                 help='Figure to populate.')
 
+    precision = Trait(None, None, 'double', 'single',
+                help="""the precision used to store the data: 'single'
+                        stores it as float32, halving the memory used.
+                        Defaults to the mlab `precision` option.""")
+
     def __call__(self, *args, **kwargs):
         """ Calls the logics of the factory, but only after disabling
             rendering, if needed.
@@ -346,6 +358,8 @@ class Flow(Pipeline):
 
     scalars = Array(help="""optional scalar data.""")
 
+    implicit_geometry = implicit_geometry
+
     _source_function = Callable(vector_field)
 
     _pipeline = [ExtractVectorNormFactory, StreamlineFactory, ]
@@ -469,6 +483,8 @@ class Contour3d(Pipeline):
     can also be a callable, f, that returns vectors components (u, v, w)
     given the positions (x, y, z)."""
 
+    implicit_geometry = implicit_geometry
+
     _source_function = Callable(scalar_field)
 
     _pipeline = [IsoSurfaceFactory, ]
@@ -820,6 +836,8 @@ class Mesh(Pipeline):
                     'fancymesh',
                     desc="""the representation type used for the surface.""")
 
+    implicit_geometry = implicit_geometry
+
     _source_function = Callable(grid_source)
 
     _pipeline = [ExtractEdgesFactory, GlyphFactory, TubeFactory,
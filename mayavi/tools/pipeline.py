@@ -12,7 +12,7 @@ from modules import *
 from sources import *
 from filters import *
 from tools import add_dataset, set_extent, add_module_manager, \
-    get_vtk_src
+    get_vtk_src, memory_report, profile
 from probe_data import probe_data
 from tools import _traverse as traverse
 
@@ -35,6 +35,14 @@ The nice thing about this is that you do not loose any interactivity of
 your app and can continue to use its UI as before, any network commands
 will be simply run on top of this.
 
+Large arrays are best sent as binary frames, see
+`mayavi.tools.array_stream`, rather than as Python source::
+
+    import socket
+    from mayavi.tools.array_stream import send_array
+    s = socket.create_connection(('localhost', 8007))
+    send_array(s, 'ScalarField', 'scalars', data)
+
 **Warning** while this is very powerful it is also a **huge security
 hole** since the remote user can do pretty much anything they want.
 
@@ -55,6 +63,8 @@ from twisted.internet.protocol import Protocol, DatagramProtocol, Factory
 from twisted.internet import reactor
 from twisted.python import log
 
+from mayavi.tools.array_stream import ArrayStreamReceiver, find_source
+
 
 ################################################################################
 # `M2UDP` protocol.
@@ -74,11 +84,27 @@ class M2UDP(DatagramProtocol):
 
     And these will run just fine retaining the full interactivity of the
     mayavi app.
+
+    Arrays can also be sent as binary frames (see
+    `mayavi.tools.array_stream`), each frame fitting in a datagram.
     """
 
+    # The parser of the array frames.
+    receiver = None
+
     def datagramReceived(self, data, (host, port)):
         """Given a line of data, simply execs it to do whatever."""
-        log.msg("Received: %r from %s:%d" % (data, host, port))
+        if self.receiver is None:
+            self.receiver = ArrayStreamReceiver(self._find_target)
+        receiver = self.receiver
+        data = receiver.feed(data)
+        if receiver.in_frame():
+            log.msg('Truncated array frame from %s:%d dropped'%(host, port))
+            receiver.reset()
+        if receiver.is_dirty():
+            _schedule_flush(receiver, self.scene)
+        if len(data) > 0:
+            log.msg("Received: %r from %s:%d" % (data, host, port))
         c = data.strip()
         if len(c) > 0:
             mlab = self.mlab
@@ -91,6 +117,9 @@ class M2UDP(DatagramProtocol):
                 log.err()
             scene.render()
 
+    def _find_target(self, source_id):
+        return find_source(self.engine, source_id)
+
 
 ################################################################################
 # `M2TCP` protocol
@@ -110,6 +139,9 @@ class M2TCP(Protocol):
 
     And these will run just fine retaining the full interactivity of the
     mayavi app.
+
+    Arrays can also be sent as binary frames, see
+    `mayavi.tools.array_stream`.
     """
 
     # Maximum number of concurrent connections allowed.
@@ -117,6 +149,7 @@ class M2TCP(Protocol):
 
     def connectionMade(self):
         log.msg('ConnectionMade')
+        self.receiver = ArrayStreamReceiver(self._find_target)
         self.factory.numConnect += 1
         if self.factory.numConnect > self.maxConnect:
             self.transport.write("Server already in use, try later\n")
@@ -128,9 +161,12 @@ class M2TCP(Protocol):
 
     def dataReceived(self, data):
         """Given a line of data, simply execs it to do whatever."""
-        c = data.strip()
-        log.msg('Received:', c)
+        receiver = self.receiver
+        c = receiver.feed(data).strip()
+        if receiver.is_dirty():
+            _schedule_flush(receiver, self.factory.scene)
         if len(c) > 0:
+            log.msg('Received:', c)
             mlab = self.factory.mlab
             engine = self.factory.engine
             scene = self.factory.scene
@@ -141,10 +177,27 @@ class M2TCP(Protocol):
                 log.err()
             scene.render()
 
+    def _find_target(self, source_id):
+        return find_source(self.factory.engine, source_id)
+
 
 ################################################################################
 # Utility functions.
 ################################################################################
+def _schedule_flush(receiver, scene):
+    """Updates the sources changed by the arrays received, and renders,
+    once the data available is processed.  The frames received till
+    then are coalesced in a single update."""
+    if receiver.flush_call is not None:
+        return
+    def flush():
+        receiver.flush_call = None
+        try:
+            receiver.flush()
+        finally:
+            scene.render()
+    receiver.flush_call = reactor.callLater(0, flush)
+
 def serve_udp(engine=None, port=9007, logto=sys.stdout):
     """Serve the `M2UDP` protocol using the given `engine` on the
     specified `port` logging messages to given `logto` which is a
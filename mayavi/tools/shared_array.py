@@ -0,0 +1,247 @@
+"""Frames of an array shared through memory between two processes.
+
+A producer, typically a simulation running in another process, creates
+a segment with `SharedArrayWriter` and writes its frames into it.  The
+`SharedArraySource` (or `SharedArrayReader`) maps the same segment and
+shows the latest frame without copying it.  Only numpy is needed on
+the producer side::
+
+    >>> w = SharedArrayWriter('sim', (64, 64, 32), 'float32')
+    >>> for step in range(n_steps):
+    ...     w.write(compute(step))
+
+On Linux the segments live in the POSIX shared memory (`/dev/shm`),
+elsewhere in the temporary directory.  A name with a path separator is
+used as the path of the segment.
+
+The segment starts with a header holding the shape, the dtype and the
+number of the latest frame, followed by `n_slots` (at least 3) slots
+holding a frame each, laid out as VTK wants them (x varies fastest and
+the components of the vectors are contiguous).  The reader records the
+slot it shows in the header and the writer never writes into it, nor
+into the slot of the latest frame, so that a frame shown is never
+overwritten.
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+# Standard library imports.
+import mmap
+import os
+import struct
+import tempfile
+
+import numpy
+
+
+# The header: the magic string, the number of the latest frame, its
+# slot, the slot read, the number of slots, the dtype, the number of
+# components and the grid shape.
+MAGIC = 'MVSHM001'
+HEADER = struct.Struct('<8sQiiI16sII3Q')
+# The offsets of the frame number and of the slots in the header.
+SEQ_OFFSET = 8
+SLOT_OFFSET = 16
+READING_OFFSET = 20
+PUBLISHED = struct.Struct('<Qi')
+
+# The offset of the first slot and the alignment of the slots.
+DATA_OFFSET = 4096
+ALIGN = 64
+
+
+######################################################################
+# Utility functions.
+######################################################################
+def segment_path(name):
+    """Returns the path of the file of the segment `name`."""
+    if os.sep in name:
+        return name
+    if os.path.isdir('/dev/shm'):
+        return os.path.join('/dev/shm', name)
+    return os.path.join(tempfile.gettempdir(), name)
+
+
+def _slot_size(shape, dtype, n_components):
+    size = int(numpy.prod(shape))*n_components*numpy.dtype(dtype).itemsize
+    return size + (-size % ALIGN)
+
+
+def _replace(src, dst):
+    """Renames `src` to `dst`, replacing it."""
+    try:
+        os.rename(src, dst)
+    except OSError:
+        # Windows does not replace an existing file.
+        if not os.path.exists(dst):
+            raise
+        os.unlink(dst)
+        os.rename(src, dst)
+
+
+def vtk_ordered_view(buf, offset, shape, dtype, n_components):
+    """Returns a view of the frame at `offset` of `buf`, indexed as
+    `(x, y[, z][, component])` while x varies fastest in memory."""
+    shape = tuple(shape)
+    ndim = len(shape)
+    c_shape = shape[::-1]
+    axes = range(ndim)[::-1]
+    if n_components > 1:
+        c_shape += (n_components,)
+        axes.append(ndim)
+    count = int(numpy.prod(c_shape))
+    arr = numpy.frombuffer(buf, dtype, count, offset).reshape(c_shape)
+    return arr.transpose(axes)
+
+
+class _Segment(object):
+    """The mapping of a segment and the views of its slots."""
+
+    def _map(self, f, size):
+        self._mm = mmap.mmap(f.fileno(), size)
+        (magic, seq, slot, reading, n_slots, dtype, n_components,
+         ndim, nx, ny, nz) = HEADER.unpack_from(self._mm, 0)
+        if magic != MAGIC:
+            raise ValueError('%s is not a shared array segment.'
+                             %self.path)
+        self.n_slots = n_slots
+        self.dtype = numpy.dtype(dtype.rstrip('\0'))
+        self.n_components = n_components
+        self.shape = (nx, ny, nz)[:ndim]
+        slot_size = _slot_size(self.shape, self.dtype, n_components)
+        self._views = [vtk_ordered_view(self._mm,
+                                        DATA_OFFSET + i*slot_size,
+                                        self.shape, self.dtype,
+                                        n_components)
+                       for i in range(n_slots)]
+
+    def _published(self):
+        """The number and the slot of the latest frame."""
+        return PUBLISHED.unpack_from(self._mm, SEQ_OFFSET)
+
+    def _reading(self):
+        return struct.unpack_from('<i', self._mm, READING_OFFSET)[0]
+
+    def _get_seq(self):
+        return self._published()[0]
+
+    seq = property(_get_seq, doc='The number of the latest frame, 0 '
+                   'if none was written.')
+
+
+######################################################################
+# `SharedArrayWriter` class.
+######################################################################
+class SharedArrayWriter(_Segment):
+    """Creates a segment and writes frames of the given grid `shape`
+    (2 or 3 dimensions), `dtype` and number of components (1 or 3)
+    into it.  An existing segment of that name is replaced, readers
+    that mapped it keep showing its frames.
+    """
+
+    def __init__(self, name, shape, dtype=float, n_components=1,
+                 n_slots=3):
+        if len(shape) not in (2, 3):
+            raise ValueError('The grid must have 2 or 3 dimensions.')
+        if n_components not in (1, 3):
+            raise ValueError('The frames must hold scalars or vectors.')
+        if n_slots < 3:
+            raise ValueError('At least 3 slots are needed.')
+        dtype = numpy.dtype(dtype)
+        shape = tuple(int(x) for x in shape)
+        self.path = segment_path(name)
+        size = DATA_OFFSET + n_slots*_slot_size(shape, dtype,
+                                                n_components)
+        # The segment is created under another name and renamed, so
+        # that readers of a segment it replaces keep the old file
+        # instead of seeing it truncated.
+        directory, base = os.path.split(self.path)
+        fd, tmp_path = tempfile.mkstemp(prefix='.%s.'%base,
+                                        dir=directory or os.curdir)
+        f = os.fdopen(fd, 'w+b')
+        try:
+            f.truncate(size)
+            dims = shape + (1,)*(3 - len(shape))
+            f.write(HEADER.pack(MAGIC, 0, -1, -1, n_slots, dtype.str,
+                                n_components, len(shape), *dims))
+            f.flush()
+            self._map(f, size)
+            _replace(tmp_path, self.path)
+        except:
+            os.unlink(tmp_path)
+            raise
+        finally:
+            f.close()
+        # The slot being written.
+        self._writing = None
+
+    def next_frame(self):
+        """Returns the array to write the next frame into.  Call
+        `publish` when it is written."""
+        seq, slot = self._published()
+        busy = (slot, self._reading())
+        for i in range(self.n_slots):
+            if i not in busy:
+                self._writing = i
+                return self._views[i]
+
+    def publish(self):
+        """Makes the frame written in the array of `next_frame` the
+        latest one."""
+        seq = self.seq + 1
+        # The slot is set before the number, which the reader polls.
+        struct.pack_into('<i', self._mm, SLOT_OFFSET, self._writing)
+        struct.pack_into('<Q', self._mm, SEQ_OFFSET, seq)
+        self._writing = None
+        return seq
+
+    def write(self, arr):
+        """Writes `arr` as the next frame and returns its number."""
+        self.next_frame()[...] = arr
+        return self.publish()
+
+    def close(self, unlink=True):
+        """Removes the segment if `unlink` is True.  It is unmapped
+        when the arrays of its frames are not used anymore, readers
+        keep their own mapping."""
+        self._views = []
+        self._mm = None
+        if unlink:
+            os.unlink(self.path)
+
+
+######################################################################
+# `SharedArrayReader` class.
+######################################################################
+class SharedArrayReader(_Segment):
+    """Maps the segment `name` created by a `SharedArrayWriter`."""
+
+    def __init__(self, name):
+        self.path = segment_path(name)
+        f = open(self.path, 'r+b')
+        try:
+            size = os.fstat(f.fileno()).st_size
+            if size < DATA_OFFSET:
+                raise ValueError('%s is not a shared array segment.'
+                                 %self.path)
+            self._map(f, size)
+        finally:
+            f.close()
+
+    def acquire(self):
+        """Returns the number and the array of the latest frame, (0,
+        None) if none was written.  The array is a view of the segment
+        which the writer does not change until another frame is
+        acquired."""
+        while True:
+            seq, slot = self._published()
+            if seq == 0:
+                return 0, None
+            struct.pack_into('<i', self._mm, READING_OFFSET, slot)
+            # The writer may have published a frame in between.
+            if self._published() == (seq, slot):
+                return seq, self._views[slot]
+
+    def release(self):
+        """Lets the writer use the slot of the frame acquired."""
+        struct.pack_into('<i', self._mm, READING_OFFSET, -1)
@@ -8,23 +8,26 @@ Data sources classes and their associated functions for mlab.
 # License: BSD Style.
 
 import operator
+import hashlib
 
 import numpy as np
 
 from traits.api import (HasTraits, Instance, CArray, Either,
-            Bool, on_trait_change, NO_COMPARE)
+            Bool, Enum, Str, Any, on_trait_change, NO_COMPARE)
 from tvtk.api import tvtk
 from tvtk.common import camel2enthought
 
 from mayavi.sources.array_source import ArraySource
+from mayavi.sources.shared_array_source import SharedArraySource
 from mayavi.core.registry import registry
 
 import tools
-from engine_manager import engine_manager
+from engine_manager import engine_manager, options
 
 __all__ = [ 'vector_scatter', 'vector_field', 'scalar_scatter',
     'scalar_field', 'line_source', 'array2d_source', 'grid_source',
     'open', 'triangular_mesh_source', 'vertical_vectors_source',
+    'shared_array_source',
 ]
 
 ################################################################################
@@ -38,6 +41,173 @@ class CArrayOrNumber(CArray):
         return CArray.validate(self, object, name, value)
 
 
+def _array_fingerprint(a):
+    """Returns a fingerprint of the contents of the array `a` that can
+    be compared to detect changes.  A checksum like Adler-32 misses too
+    many changes of index arrays, so an MD5 digest is used."""
+    a = np.ascontiguousarray(a)
+    return a.shape, a.dtype.str, hashlib.md5(a.data).digest()
+
+
+################################################################################
+# Implicit geometry detection.
+################################################################################
+def _varying_axis(a):
+    """Returns the axis along which the 2D array `a` varies: -1 if `a`
+    is constant, 0 or 1 if it only varies along that axis and None if
+    it varies along both axes."""
+    # The checks on the last row/column are cheap and reject most
+    # non-separable arrays before the full comparison.
+    if (a[-1] == a[-1, 0]).all() and (a == a[:, :1]).all():
+        if (a[:, 0] == a[0, 0]).all():
+            return -1
+        return 0
+    if (a[:, -1] == a[0, -1]).all() and (a == a[:1, :]).all():
+        return 1
+    return None
+
+
+def _is_uniform(c):
+    """Returns True if the strictly increasing 1D coordinates `c` are
+    equally spaced."""
+    if len(c) < 3:
+        return True
+    d = np.diff(c)
+    step = float(c[-1] - c[0])/(len(c) - 1)
+    return bool(np.all(abs(d - step) <= 1e-5*abs(step)))
+
+
+def grid_geometry(x, y, z):
+    """Detects if the 2D coordinate arrays `x`, `y`, `z` of a surface
+    describe an axis-aligned orthogonal grid, as created for instance
+    by `numpy.mgrid` or `numpy.meshgrid`.
+
+    Returns a tuple `(kind, coordinates, order)`.  `kind` is one of
+    'uniform', 'rectilinear' or 'explicit'.  For the first two,
+    `coordinates` is a list of the three 1D coordinate arrays
+    (of length 1 for the constant coordinate) and `order` is the order
+    ('C' or 'F') in which an array of shape `x.shape` must be raveled
+    to match the VTK point ordering.  For 'explicit' geometry both are
+    None.
+    """
+    explicit = ('explicit', None, None)
+    if x.ndim != 2 or x.size < 4 or min(x.shape) < 2:
+        return explicit
+    axes = []
+    for a in (x, y, z):
+        axis = _varying_axis(a)
+        if axis is None:
+            return explicit
+        axes.append(axis)
+    varying = [axis for axis in axes if axis >= 0]
+    # We need a plane: two coordinates varying along distinct axes.
+    if sorted(varying) != [0, 1]:
+        return explicit
+
+    coords = []
+    uniform = True
+    for a, axis in zip((x, y, z), axes):
+        if axis == -1:
+            c = np.atleast_1d(a[0, 0])
+        elif axis == 0:
+            c = a[:, 0]
+        else:
+            c = a[0, :]
+        if len(c) > 1:
+            if not (np.diff(c) > 0).all():
+                return explicit
+            uniform = uniform and _is_uniform(c)
+        coords.append(np.array(c, 'd'))
+
+    # VTK orders points with x varying fastest.  If the coordinate
+    # varying along the first array axis comes first in (x, y, z), the
+    # arrays must be raveled in Fortran order.
+    order = 'F' if axes.index(0) < axes.index(1) else 'C'
+    kind = 'uniform' if uniform else 'rectilinear'
+    return kind, coords, order
+
+
+def _make_implicit_dataset(kind, coords, dataset=None):
+    """Creates (or updates `dataset` if it is of the right type) an
+    `ImageData` or a `RectilinearGrid` given the geometry found by
+    `grid_geometry`."""
+    dims = tuple(len(c) for c in coords)
+    if kind == 'uniform':
+        if not isinstance(dataset, tvtk.ImageData):
+            dataset = tvtk.ImageData()
+        spacing = [1.0, 1.0, 1.0]
+        for i, c in enumerate(coords):
+            if len(c) > 1:
+                spacing[i] = float(c[-1] - c[0])/(len(c) - 1)
+        dataset.set(origin=[c[0] for c in coords], spacing=spacing,
+                    dimensions=dims)
+    else:
+        if not isinstance(dataset, tvtk.RectilinearGrid):
+            dataset = tvtk.RectilinearGrid()
+        dataset.set(dimensions=dims, x_coordinates=coords[0],
+                    y_coordinates=coords[1], z_coordinates=coords[2])
+    return dataset
+
+
+################################################################################
+# Precision policy.
+################################################################################
+def _get_dtype(precision):
+    """Returns the type the data is converted to for the given
+    precision, None meaning that the data is kept as it is."""
+    if precision == 'single':
+        return np.float32
+    return None
+
+
+def _as_dtype(a, dtype):
+    """Converts the numerical array `a` to `dtype` if needed."""
+    if a is None or dtype is None:
+        return a
+    a = np.asanyarray(a)
+    if a.dtype == dtype or a.dtype.kind not in 'fiu':
+        return a
+    return a.astype(dtype)
+
+
+def _as_fortran(a, dtype):
+    """Returns `a` converted to `dtype` and laid out in Fortran order
+    in a single pass.  The transposition done by `ArraySource` is then
+    free."""
+    if a is None or dtype is None:
+        return a
+    return np.asfortranarray(a, dtype=dtype)
+
+
+def _interleave(dtype, *arrays):
+    """Interleaves the given arrays as the columns of a new array of
+    shape (N, len(arrays)).  The conversion to `dtype`, if not None, is
+    done while copying."""
+    if dtype is None:
+        dtype = np.result_type(*arrays)
+    out = np.empty((np.size(arrays[0]), len(arrays)), dtype)
+    for i, a in enumerate(arrays):
+        out[:, i] = np.ravel(a)
+    return out
+
+
+def _vtk_ordered_vectors(dtype, *components):
+    """Given 3D arrays u, v, w (or a single 4D vector array) returns a
+    vector array of shape (nx, ny, nz, 3) whose memory is laid out in
+    the order VTK expects (x index fastest after the components), so
+    that `ArraySource` does not need to copy it.  The conversion to
+    `dtype` is done while copying."""
+    if len(components) == 1:
+        components = [components[0][..., i] for i in range(3)]
+    shape = components[0].shape
+    if dtype is None:
+        dtype = np.result_type(*components)
+    buf = np.empty(shape[::-1] + (3,), dtype)
+    for i, c in enumerate(components):
+        buf[..., i] = np.transpose(c)
+    return np.transpose(buf, (2, 1, 0, 3))
+
+
 ################################################################################
 # `MlabSource` class.
 ################################################################################
@@ -54,6 +224,12 @@ class MlabSource(HasTraits):
     # The Mayavi data source we manage.
     m_data = Instance(HasTraits)
 
+    # The precision used to store the points, scalars and vectors.
+    # With 'single' they are converted to float32 once, when they are
+    # set.  The default is given by the mlab `precision` preference.
+    precision = Enum('double', 'single',
+                     desc='the floating point precision of the data')
+
     ########################################
     # Private traits.
 
@@ -117,9 +293,30 @@ class MlabSource(HasTraits):
             self.update()
         return self
 
+    def memory_report(self):
+        """Returns a dictionary giving the precision, the number of
+        bytes held by the points, scalars and vectors of the source
+        (`nbytes`) and the number of bytes saved by storing them with a
+        lower precision than float64 (`saved`)."""
+        nbytes = saved = 0
+        for name in ('points', 'scalars', 'vectors'):
+            a = getattr(self, name, None)
+            if a is None:
+                continue
+            nbytes += a.nbytes
+            if a.dtype.kind == 'f' and a.itemsize < 8:
+                saved += a.size*(8 - a.itemsize)
+        return dict(precision=self.precision, nbytes=nbytes, saved=saved)
+
     ######################################################################
     # Non-public interface.
     ######################################################################
+    def _precision_default(self):
+        return getattr(options, 'precision', 'double')
+
+    def _get_dtype(self):
+        return _get_dtype(self.precision)
+
     def _m_data_changed(self, ds):
         if not hasattr(ds, 'mlab_source'):
             ds.add_trait('mlab_source', Instance(MlabSource))
@@ -168,6 +365,7 @@ class MGlyphSource(MlabSource):
         # the notification handlers are not called.
         self.set(trait_change_notify=False, **traits)
 
+        dtype = self._get_dtype()
         vectors = self.vectors
         scalars = self.scalars
         points = self.points
@@ -177,14 +375,14 @@ class MGlyphSource(MlabSource):
         z = np.atleast_1d(z)
 
         if 'points' in traits:
+            points = _as_dtype(points, dtype)
             x=points[:,0].ravel()
             y=points[:,1].ravel()
             z=points[:,2].ravel()
-            self.set(x=x,y=y,z=z,trait_change_notify=False)
+            self.set(x=x,y=y,z=z,points=points,trait_change_notify=False)
 
         else:
-            points = np.c_[x.ravel(), y.ravel(), z.ravel()].ravel()
-            points.shape = (points.size/3, 3)
+            points = _interleave(dtype, x, y, z)
             self.set(points=points, trait_change_notify=False)
 
 
@@ -194,29 +392,27 @@ class MGlyphSource(MlabSource):
             v = np.atleast_1d(v)
             w = np.atleast_1d(w)
             if len(u) > 0:
-                vectors = np.c_[u.ravel(), v.ravel(),
-                                w.ravel()].ravel()
-                vectors.shape = (vectors.size/3, 3)
+                vectors = _interleave(dtype, u, v, w)
                 self.set(vectors=vectors, trait_change_notify=False)
 
         if 'vectors' in traits:
+            vectors = _as_dtype(vectors, dtype)
             u=vectors[:,0].ravel()
             v=vectors[:,1].ravel()
             w=vectors[:,2].ravel()
-            self.set(u=u,v=v,w=w,trait_change_notify=False)
+            self.set(u=u,v=v,w=w,vectors=vectors,trait_change_notify=False)
 
         else:
             if u is not None and len(u) > 0:
-                vectors = np.c_[u.ravel(), v.ravel(),
-                                   w.ravel()].ravel()
-                vectors.shape = (vectors.size/3, 3)
+                vectors = _interleave(dtype, u, v, w)
                 self.set(vectors=vectors, trait_change_notify=False)
 
 
         if vectors is not None and len(vectors) > 0:
             assert len(points) == len(vectors)
         if scalars is not None:
-            scalars = np.atleast_1d(scalars)
+            scalars = _as_dtype(np.atleast_1d(scalars), dtype)
+            self.set(scalars=scalars, trait_change_notify=False)
             if len(scalars) > 0:
                 assert len(points) == len(scalars)
 
@@ -274,7 +470,8 @@ class MGlyphSource(MlabSource):
         self.update()
 
     def _points_changed(self, p):
-        p = np.atleast_2d(p)
+        p = _as_dtype(np.atleast_2d(p), self._get_dtype())
+        self.trait_setq(points=p)
         self.dataset.points = p
         self.update()
 
@@ -283,12 +480,15 @@ class MGlyphSource(MlabSource):
             self.dataset.point_data.scalars = None
             self.dataset.point_data.remove_array('scalars')
         else:
-            s = np.atleast_1d(s)
+            s = _as_dtype(np.atleast_1d(s), self._get_dtype())
+            self.trait_setq(scalars=s)
             self.dataset.point_data.scalars = s
             self.dataset.point_data.scalars.name = 'scalars'
         self.update()
 
     def _vectors_changed(self, v):
+        v = _as_dtype(v, self._get_dtype())
+        self.trait_setq(vectors=v)
         self.dataset.point_data.vectors = v
         self.dataset.point_data.vectors.name = 'vectors'
         self.update()
@@ -316,6 +516,8 @@ class MVerticalGlyphSource(MGlyphSource):
 
 
     def _scalars_changed(self, s):
+        s = _as_dtype(s, self._get_dtype())
+        self.trait_setq(scalars=s)
         self.dataset.point_data.scalars = s
         self.dataset.point_data.scalars.name = 'scalars'
         self.set(vectors=np.c_[np.ones_like(s),
@@ -331,6 +533,12 @@ class MArraySource(MlabSource):
     """
     This class represents an array data source for Mlab objects and
     allows the user to set the x, y, z, scalar/vector attributes.
+
+    If `implicit_geometry` is True and the x, y, z coordinates are not
+    equally spaced, a `RectilinearGrid` is created instead of an
+    `ArraySource` (`ImageData`).  The kind of grid is decided the first
+    time the source is reset.  This is off by default as some modules
+    (e.g. the volume module) need an `ImageData`.
     """
 
     # The x, y, z arrays for the volume.
@@ -347,6 +555,14 @@ class MArraySource(MlabSource):
     w = ArrayOrNone
     vectors = ArrayOrNone
 
+    # Detect non-uniform coordinates and create a rectilinear grid for
+    # them.
+    implicit_geometry = Bool(False,
+                         desc='if rectilinear coordinates are detected')
+
+    # The kind of geometry of the dataset.
+    geometry = Enum('uniform', 'rectilinear')
+
     ######################################################################
     # `MlabSource` interface.
     ######################################################################
@@ -357,12 +573,21 @@ class MArraySource(MlabSource):
         # the notification handlers are not called.
         self.set(trait_change_notify=False, **traits)
 
+        dtype = self._get_dtype()
         vectors = self.vectors
         scalars = self.scalars
         x, y, z = [np.atleast_3d(a) for a in self.x, self.y, self.z]
 
+        if dtype is not None and scalars is not None:
+            # Convert and lay out the data as VTK needs it in one pass.
+            scalars = _as_fortran(scalars, dtype)
+            self.set(scalars=scalars, trait_change_notify=False)
+
         u, v, w = self.u, self.v, self.w
         if 'vectors' in traits:
+            if dtype is not None:
+                vectors = _vtk_ordered_vectors(dtype, vectors)
+                self.set(vectors=vectors, trait_change_notify=False)
             u=vectors[:,0].ravel()
             v=vectors[:,1].ravel()
             w=vectors[:,2].ravel()
@@ -370,18 +595,29 @@ class MArraySource(MlabSource):
 
         else:
             if u is not None and len(u) > 0:
-                #vectors = np.concatenate([u[..., np.newaxis],
-                #                             v[..., np.newaxis],
-                #                             w[..., np.newaxis] ],
-                #                axis=3)
-                vectors = np.c_[u.ravel(), v.ravel(),
-                                   w.ravel()].ravel()
-                vectors.shape = (u.shape[0] , u.shape[1], w.shape[2], 3)
+                if dtype is not None:
+                    vectors = _vtk_ordered_vectors(dtype, u, v, w)
+                else:
+                    vectors = np.c_[u.ravel(), v.ravel(),
+                                    w.ravel()].ravel()
+                    vectors.shape = (u.shape[0] , u.shape[1], w.shape[2], 3)
                 self.set(vectors=vectors, trait_change_notify=False)
 
         if vectors is not None and len(vectors) > 0 and scalars is not None:
             assert len(scalars) == len(vectors)
 
+        if self.m_data is None and self.dataset is None:
+            geometry = 'uniform'
+            if self.implicit_geometry:
+                coords = self._get_coordinates(x, y, z)
+                if not all(_is_uniform(c) for c in coords):
+                    geometry = 'rectilinear'
+            self.set(geometry=geometry, trait_change_notify=False)
+
+        if self.geometry == 'rectilinear':
+            self._reset_rectilinear(x, y, z, scalars, vectors)
+            return
+
         if x.shape[0] <= 1:
             dx = 1
         else:
@@ -413,9 +649,40 @@ class MArraySource(MlabSource):
     ######################################################################
     # Non-public interface.
     ######################################################################
+    def _get_coordinates(self, x, y, z):
+        """Returns the 1D coordinates of the 3D arrays x, y, z."""
+        return [np.atleast_1d(np.array(a, 'd')) for a in
+                (x[:, 0, 0], y[0, :, 0], z[0, 0, :])]
+
+    def _reset_rectilinear(self, x, y, z, scalars, vectors):
+        """Creates or updates the RectilinearGrid dataset."""
+        coords = self._get_coordinates(x, y, z)
+        for c in coords:
+            if len(c) > 1 and not (np.diff(c) > 0).all():
+                raise ValueError('The coordinates must be increasing.')
+        rg = _make_implicit_dataset('rectilinear', coords, self.dataset)
+        pd = rg.point_data
+        if scalars is not None:
+            scalars = np.atleast_3d(scalars)
+            pd.scalars = np.ravel(scalars, order='F')
+            pd.scalars.name = 'scalar'
+        if vectors is not None and len(vectors) > 0:
+            vectors = np.atleast_3d(vectors)
+            if vectors.ndim == 3:
+                vectors = vectors[:, :, np.newaxis]
+            pd.vectors = np.reshape(np.transpose(vectors, (2, 1, 0, 3)),
+                                    (-1, 3))
+            pd.vectors.name = 'vector'
+        self.dataset = rg
+
     @on_trait_change('[x, y, z]')
     def _xyz_changed(self):
         x, y, z = self.x, self.y, self.z
+        if self.geometry == 'rectilinear':
+            x, y, z = [np.atleast_3d(a) for a in (x, y, z)]
+            self._reset_rectilinear(x, y, z, None, None)
+            self.update()
+            return
         dx = x[1, 0, 0] - x[0, 0, 0]
         dy = y[0, 1, 0] - y[0, 0, 0]
         dz = z[0, 0, 1] - z[0, 0, 0]
@@ -426,25 +693,53 @@ class MArraySource(MlabSource):
             self.m_data.set(origin=ds.origin, spacing=ds.spacing)
         self.update()
 
+    def _rectilinear_attributes_changed(self, scalars=None, vectors=None):
+        x, y, z = [np.atleast_3d(a) for a in (self.x, self.y, self.z)]
+        self._reset_rectilinear(x, y, z, scalars, vectors)
+        self.update()
+
     def _u_changed(self, u):
         self.vectors[...,0] = u
+        if self.geometry == 'rectilinear':
+            self._rectilinear_attributes_changed(vectors=self.vectors)
+            return
         self.m_data._vector_data_changed(self.vectors)
 
     def _v_changed(self, v):
         self.vectors[...,1] = v
+        if self.geometry == 'rectilinear':
+            self._rectilinear_attributes_changed(vectors=self.vectors)
+            return
         self.m_data._vector_data_changed(self.vectors)
 
     def _w_changed(self, w):
         self.vectors[...,2] = w
+        if self.geometry == 'rectilinear':
+            self._rectilinear_attributes_changed(vectors=self.vectors)
+            return
         self.m_data._vector_data_changed(self.vectors)
 
     def _scalars_changed(self, s):
+        dtype = self._get_dtype()
+        if dtype is not None and s is not None:
+            s = _as_fortran(s, dtype)
+            self.trait_setq(scalars=s)
+        if self.geometry == 'rectilinear':
+            self._rectilinear_attributes_changed(scalars=s)
+            return
         old = self.m_data.scalar_data
         self.m_data.scalar_data = s
         if old is s:
             self.m_data._scalar_data_changed(s)
 
     def _vectors_changed(self, v):
+        dtype = self._get_dtype()
+        if dtype is not None and v is not None:
+            v = _vtk_ordered_vectors(dtype, v)
+            self.trait_setq(vectors=v)
+        if self.geometry == 'rectilinear':
+            self._rectilinear_attributes_changed(vectors=v)
+            return
         self.m_data.vector_data = v
 
 
@@ -476,20 +771,22 @@ class MLineSource(MlabSource):
         # the notification handlers are not called.
         self.set(trait_change_notify=False, **traits)
 
+        dtype = self._get_dtype()
         points = self.points
-        scalars = self.scalars
+        scalars = _as_dtype(self.scalars, dtype)
         x, y, z = self.x, self.y, self.z
 
         if 'points' in traits:
+            points = _as_dtype(points, dtype)
             x=points[:,0].ravel()
             y=points[:,1].ravel()
             z=points[:,2].ravel()
-            self.set(x=x,y=y,z=z,trait_change_notify=False)
+            self.set(x=x,y=y,z=z,points=points,trait_change_notify=False)
 
         else:
-            points = np.c_[x.ravel(), y.ravel(), z.ravel()].ravel()
-            points.shape = (len(x), 3)
+            points = _interleave(dtype, x, y, z)
             self.set(points=points, trait_change_notify=False)
+        self.set(scalars=scalars, trait_change_notify=False)
 
 
         # Create the dataset.
@@ -531,10 +828,14 @@ class MLineSource(MlabSource):
         self.update()
 
     def _points_changed(self, p):
+        p = _as_dtype(p, self._get_dtype())
+        self.trait_setq(points=p)
         self.dataset.points = p
         self.update()
 
     def _scalars_changed(self, s):
+        s = _as_dtype(s, self._get_dtype())
+        self.trait_setq(scalars=s)
         self.dataset.point_data.scalars = s.ravel()
         self.dataset.point_data.scalars.name = 'scalars'
         self.update()
@@ -586,6 +887,12 @@ class MArray2DSource(MlabSource):
             scalars = scalars.astype('float')
             self.set(scalars=scalars, trait_change_notify=False)
 
+        dtype = self._get_dtype()
+        if dtype is not None:
+            # Convert and lay out the data as VTK needs it in one pass.
+            scalars = _as_fortran(scalars, dtype)
+            self.set(scalars=scalars, trait_change_notify=False)
+
         z = np.array([0])
 
         self.set(x=x, y=y, z=z, trait_change_notify=False)
@@ -648,6 +955,10 @@ class MArray2DSource(MlabSource):
             # The NaN tric only works with floats.
             s = s.astype('float')
             self.set(scalars=s, trait_change_notify=False)
+        dtype = self._get_dtype()
+        if dtype is not None:
+            s = _as_fortran(s, dtype)
+            self.set(scalars=s, trait_change_notify=False)
         old = self.m_data.scalar_data
         self.m_data.scalar_data = s
         if s is old:
@@ -661,6 +972,13 @@ class MGridSource(MlabSource):
     """
     This class represents a grid source for Mlab objects and
     allows the user to set the x, y, scalar attributes.
+
+    If `implicit_geometry` is True and the x, y, z arrays describe an
+    axis-aligned plane (as created by `numpy.mgrid` for instance), an
+    `ImageData` or a `RectilinearGrid` is created instead of a
+    triangulated `PolyData`.  Only the 1D coordinates are then stored
+    and the `points` trait is None.  This is off by default so that
+    the dataset and the `points` trait stay what they always were.
     """
 
     # The x, y, z and points of the grid.
@@ -675,6 +993,20 @@ class MGridSource(MlabSource):
     # The masking array.
     mask = ArrayOrNone
 
+    # Detect uniform or rectilinear coordinates and create an implicit
+    # geometry for them.
+    implicit_geometry = Bool(False,
+                   desc='if uniform/rectilinear coordinates are detected')
+
+    # The kind of geometry of the dataset.
+    geometry = Enum('explicit', 'uniform', 'rectilinear')
+
+    ########################################
+    # Private traits.
+
+    # The order in which 2D arrays are raveled to match the dataset.
+    _order = Str('C')
+
     ######################################################################
     # `MlabSource` interface.
     ######################################################################
@@ -704,9 +1036,40 @@ class MGridSource(MlabSource):
         #Points in the grid source will always be created using x,y,z
         #Changing of points is not allowed because it cannot be used to modify values of x,y,z
 
+        kind, coords, order = 'explicit', None, 'C'
+        if self.implicit_geometry:
+            kind, coords, order = grid_geometry(x, y, z)
+            order = order or 'C'
+
+        if kind == 'explicit':
+            pd = self._make_explicit_dataset(x, y, z)
+        else:
+            pd = _make_implicit_dataset(kind, coords, self.dataset)
+            self.set(points=None, trait_change_notify=False)
+        self.set(geometry=kind, _order=order, trait_change_notify=False)
+
+        if scalars is not None and len(scalars) > 0:
+            dtype = self._get_dtype()
+            if dtype is not None:
+                # Convert and lay out the data as VTK needs it in one pass.
+                scalars = np.array(scalars, dtype, order=order)
+                self.set(scalars=scalars, trait_change_notify=False)
+            elif not scalars.flags.contiguous:
+                scalars = scalars.copy()
+                self.set(scalars=scalars, trait_change_notify=False)
+            assert x.shape == scalars.shape
+            pd.point_data.scalars = np.ravel(scalars, order=order)
+            pd.point_data.scalars.name = 'scalars'
+
+        self._set_dataset(pd)
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def _make_explicit_dataset(self, x, y, z):
+        """Creates the triangulated PolyData for the explicit points."""
         nx, ny = x.shape
-        points = np.c_[x.ravel(), y.ravel(), z.ravel()].ravel()
-        points.shape = (nx*ny, 3)
+        points = _interleave(self._get_dtype(), x, y, z)
         self.set(points=points, trait_change_notify=False)
 
         i, j = np.mgrid[0:nx-1,0:ny-1]
@@ -718,41 +1081,54 @@ class MGridSource(MlabSource):
         triangles[0:nt,0], triangles[0:nt,1], triangles[0:nt,2] = t1
         triangles[nt:,0], triangles[nt:,1], triangles[nt:,2] = t2
 
-        if self.dataset is None:
-            pd = tvtk.PolyData()
-        else:
+        if isinstance(self.dataset, tvtk.PolyData):
             pd = self.dataset
+        else:
+            pd = tvtk.PolyData()
         pd.set(points=points, polys=triangles)
+        return pd
+
+    def _set_dataset(self, dataset):
+        """Sets the dataset, replacing the one used by the Mayavi
+        source if the type of the dataset changed."""
+        old = self.dataset
+        self.dataset = dataset
+        md = self.m_data
+        if old is not None and dataset is not old and md is not None \
+               and hasattr(md, 'data'):
+            name = md.name
+            md.data = dataset
+            md.name = name
+
+    def _coordinates_changed(self, name, value):
+        if self.geometry == 'explicit' and self.points is not None:
+            self.trait_setq(**{name: value})
+            self.points[:, 'xyz'.index(name)] = value.ravel()
+            self.update()
+        else:
+            # The geometry may have changed, detect it again.
+            self.reset(**{name: value})
+            self.update()
 
-        if scalars is not None and len(scalars) > 0:
-            if not scalars.flags.contiguous:
-                scalars = scalars.copy()
-                self.set(scalars=scalars, trait_change_notify=False)
-            assert x.shape == scalars.shape
-            pd.point_data.scalars = scalars.ravel()
-            pd.point_data.scalars.name = 'scalars'
-
-        self.dataset = pd
-
-    ######################################################################
-    # Non-public interface.
-    ######################################################################
     def _x_changed(self, x):
-        self.trait_setq(x=x);
-        self.points[:,0] = x.ravel()
-        self.update()
+        self._coordinates_changed('x', x)
 
     def _y_changed(self, y):
-        self.trait_setq(y=y)
-        self.points[:,1] = y.ravel()
-        self.update()
+        self._coordinates_changed('y', y)
 
     def _z_changed(self, z):
-        self.trait_setq(z=z)
-        self.points[:,2] = z.ravel()
-        self.update()
+        self._coordinates_changed('z', z)
 
     def _points_changed(self, p):
+        if self.geometry != 'explicit':
+            # Setting the points forces an explicit geometry.
+            shape = self.x.shape
+            x, y, z = [p[:, i].reshape(shape) for i in range(3)]
+            self.trait_setq(geometry='explicit', _order='C')
+            self._set_dataset(self._make_explicit_dataset(x, y, z))
+            if self.scalars is not None:
+                self._scalars_changed(self.scalars)
+                return
         self.dataset.points = p
         self.update()
 
@@ -763,8 +1139,12 @@ class MGridSource(MlabSource):
             # The NaN tric only works with floats.
             s = s.astype('float')
             self.set(scalars=s, trait_change_notify=False)
+        dtype = self._get_dtype()
+        if dtype is not None:
+            s = np.array(s, dtype, order=self._order, copy=False)
+            self.set(scalars=s, trait_change_notify=False)
 
-        self.dataset.point_data.scalars = s.ravel()
+        self.dataset.point_data.scalars = np.ravel(s, order=self._order)
         self.dataset.point_data.scalars.name = 'scalars'
         self.update()
 
@@ -776,6 +1156,10 @@ class MTriangularMeshSource(MlabSource):
     """
     This class represents a triangular mesh source for Mlab objects and
     allows the user to set the x, y, scalar attributes.
+
+    The connectivity is only rebuilt when the contents of the triangles
+    array change.  For deforming meshes, `update_points_only` updates
+    the point coordinates without touching the connectivity.
     """
 
     # The x, y, z and points of the grid.
@@ -788,6 +1172,12 @@ class MTriangularMeshSource(MlabSource):
     # The scalars shown on the glyphs.
     scalars = ArrayOrNone
 
+    ########################################
+    # Private traits.
+
+    # The fingerprint of the triangles used to build the polys.
+    _triangles_fingerprint = Any
+
     ######################################################################
     # `MlabSource` interface.
     ######################################################################
@@ -802,8 +1192,7 @@ class MTriangularMeshSource(MlabSource):
         scalars = self.scalars
 
         x, y, z = self.x, self.y, self.z
-        points = np.c_[x.ravel(), y.ravel(), z.ravel()].ravel()
-        points.shape = (points.size/3, 3)
+        points = _interleave(self._get_dtype(), x, y, z)
         self.set(points=points, trait_change_notify=False)
 
         triangles = self.triangles
@@ -821,7 +1210,7 @@ class MTriangularMeshSource(MlabSource):
         # Set the points first, and the triangles after: so that the
         # polygone can refer to the right points, in the polydata.
         pd.set(points=points)
-        pd.set(polys=triangles)
+        self._set_polys(pd, triangles)
 
         if (not 'scalars' in traits
                     and scalars is not None
@@ -831,18 +1220,65 @@ class MTriangularMeshSource(MlabSource):
             scalars = z
 
         if scalars is not None and len(scalars) > 0:
+            scalars = _as_dtype(scalars, self._get_dtype())
             if not scalars.flags.contiguous:
                 scalars = scalars.copy()
-                self.set(scalars=scalars, trait_change_notify=False)
+            self.set(scalars=scalars, trait_change_notify=False)
             assert x.shape == scalars.shape
             pd.point_data.scalars = scalars.ravel()
             pd.point_data.scalars.name = 'scalars'
 
         self.dataset = pd
 
+    def update_points_only(self, points=None, x=None, y=None, z=None):
+        """Updates the coordinates of the points without rebuilding the
+        connectivity or the scalars.
+
+        Either an (N, 3) `points` array or any of the `x`, `y`, `z`
+        arrays may be given; the number of points may not change.  A
+        C-contiguous `points` array of the same type as the current
+        points is passed on to VTK without copying.  The coordinates
+        are otherwise written into the existing point buffer.
+        """
+        old = self.points
+        if points is not None:
+            points = _as_dtype(np.asarray(points), self._get_dtype())
+            assert points.shape == old.shape, \
+                "The number of points cannot change, use reset instead."
+            shape = self.x.shape
+            self.trait_setq(points=points,
+                            x=points[:,0].reshape(shape),
+                            y=points[:,1].reshape(shape),
+                            z=points[:,2].reshape(shape))
+            self.dataset.points = points
+        else:
+            for i, (name, value) in enumerate((('x', x), ('y', y),
+                                               ('z', z))):
+                if value is not None:
+                    value = np.asarray(value)
+                    assert value.size == len(old), \
+                        "The number of points cannot change, use reset "\
+                        "instead."
+                    old[:,i] = value.ravel()
+                    self.trait_setq(**{name: value})
+            # This does not copy the (contiguous) point buffer.
+            self.dataset.points = old
+        self.update()
+
     ######################################################################
     # Non-public interface.
     ######################################################################
+    def _set_polys(self, pd, triangles):
+        """Sets the polys of the polydata unless the triangles have the
+        same contents as the ones already used."""
+        fp = _array_fingerprint(triangles)
+        if fp == self._triangles_fingerprint and pd.polys is not None \
+               and pd.polys.number_of_cells == len(triangles):
+            return False
+        pd.set(polys=triangles)
+        self._triangles_fingerprint = fp
+        return True
+
     def _x_changed(self, x):
         self.trait_setq(x=x);
         self.points[:,0] = x.ravel()
@@ -859,10 +1295,14 @@ class MTriangularMeshSource(MlabSource):
         self.update()
 
     def _points_changed(self, p):
+        p = _as_dtype(p, self._get_dtype())
+        self.trait_setq(points=p)
         self.dataset.points = p
         self.update()
 
     def _scalars_changed(self, s):
+        s = _as_dtype(s, self._get_dtype())
+        self.trait_setq(scalars=s)
         self.dataset.point_data.scalars = s.ravel()
         self.dataset.point_data.scalars.name = 'scalars'
         self.update()
@@ -873,8 +1313,8 @@ class MTriangularMeshSource(MlabSource):
         if triangles.max() > self.x.size:
             raise ValueError, 'The triangles array has values larger than' \
                                         'the number of points'
-        self.dataset.polys = triangles
-        self.update()
+        if self._set_polys(self.dataset, triangles):
+            self.update()
 
 
 ############################################################################
@@ -973,6 +1413,34 @@ def process_regular_2d_scalars(*args, **kwargs):
     return x, y, s
 
 
+def _source_traits(kwargs, grid=False):
+    """ Pops the keyword arguments that are traits of the mlab source
+        from `kwargs` and returns them.  `grid` is True for the grid
+        sources, which also take `implicit_geometry`.
+    """
+    traits = {}
+    precision = kwargs.pop('precision', None)
+    if precision is not None:
+        traits['precision'] = precision
+    # Passed to the helper functions deriving from the grid ones (e.g.
+    # `triangular_mesh` from `mesh`), which have no implicit geometry.
+    implicit_geometry = kwargs.pop('implicit_geometry', False)
+    if grid:
+        traits['implicit_geometry'] = implicit_geometry
+    return traits
+
+
+def _add_array_source(data_source, name, **kwargs):
+    """ Adds the data of an `MArraySource` to the pipeline.  Rectilinear
+        grids have no `ArraySource` and are added as a dataset.
+    """
+    if data_source.m_data is None:
+        ds = tools.add_dataset(data_source.dataset, name, **kwargs)
+        data_source.m_data = ds
+        return ds
+    return tools.add_dataset(data_source.m_data, name, **kwargs)
+
+
 ############################################################################
 # Sources
 ############################################################################
@@ -996,6 +1464,10 @@ def vector_scatter(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :scalars: optional scalar data.
 
         :figure: optionally, the figure on which to add the data source.
@@ -1012,7 +1484,7 @@ def vector_scatter(*args, **kwargs):
         scalars = np.ravel(scalars)
     name = kwargs.pop('name', 'VectorScatter')
 
-    data_source = MGlyphSource()
+    data_source = MGlyphSource(**_source_traits(kwargs))
     data_source.reset(x=x, y=y, z=z, u=u, v=v, w=w, scalars=scalars)
 
     ds = tools.add_dataset(data_source.dataset, name, **kwargs)
@@ -1043,6 +1515,15 @@ def vector_field(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
+        :implicit_geometry: if True, coordinates that are not equally
+                            spaced give a `RectilinearGrid` instead of
+                            being assumed regularly spaced.  Defaults to
+                            False.
+
         :scalars: optional scalar data.
 
         :figure: optionally, the figure on which to add the data source.
@@ -1062,10 +1543,10 @@ def vector_field(*args, **kwargs):
     scalars = kwargs.pop('scalars', None)
     if scalars is not None:
         scalars = np.atleast_3d(scalars)
-    data_source = MArraySource()
+    data_source = MArraySource(**_source_traits(kwargs, grid=True))
     data_source.reset(x=x, y=y, z=z, u=u, v=v, w=w, scalars=scalars)
     name = kwargs.pop('name', 'VectorField')
-    return tools.add_dataset(data_source.m_data, name, **kwargs)
+    return _add_array_source(data_source, name, **kwargs)
 
 
 def scalar_scatter(*args, **kwargs):
@@ -1089,6 +1570,10 @@ def scalar_scatter(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :figure: optionally, the figure on which to add the data source.
                  If None, the source is not added to any figure, and will
                  be added automatically by the modules or
@@ -1101,7 +1586,7 @@ def scalar_scatter(*args, **kwargs):
     if s is not None:
         s = np.ravel(s)
 
-    data_source = MGlyphSource()
+    data_source = MGlyphSource(**_source_traits(kwargs))
     data_source.reset(x=x, y=y, z=z, scalars=s)
 
     name = kwargs.pop('name', 'ScalarScatter')
@@ -1134,6 +1619,15 @@ def scalar_field(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
+        :implicit_geometry: if True, coordinates that are not equally
+                            spaced give a `RectilinearGrid` instead of
+                            being assumed regularly spaced.  Defaults to
+                            False.
+
         :figure: optionally, the figure on which to add the data source.
                  If None, the source is not added to any figure, and will
                  be added automatically by the modules or
@@ -1149,11 +1643,11 @@ def scalar_field(*args, **kwargs):
     else:
         x, y, z, s = process_regular_scalars(*args)
 
-    data_source = MArraySource()
+    data_source = MArraySource(**_source_traits(kwargs, grid=True))
     data_source.reset(x=x, y=y, z=z, scalars=s)
 
     name = kwargs.pop('name', 'ScalarField')
-    return tools.add_dataset(data_source.m_data, name, **kwargs)
+    return _add_array_source(data_source, name, **kwargs)
 
 
 def line_source(*args, **kwargs):
@@ -1173,6 +1667,10 @@ def line_source(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :figure: optionally, the figure on which to add the data source.
                  If None, the source is not added to any figure, and will
                  be added automatically by the modules or
@@ -1184,7 +1682,7 @@ def line_source(*args, **kwargs):
         raise ValueError, "wrong number of arguments"
     x, y, z, s = process_regular_scalars(*args)
 
-    data_source = MLineSource()
+    data_source = MLineSource(**_source_traits(kwargs))
     data_source.reset(x=x, y=y, z=z, scalars=s)
 
     name = kwargs.pop('name', 'LineSource')
@@ -1220,6 +1718,10 @@ def array2d_source(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :figure: optionally, the figure on which to add the data source.
                  If None, the source is not added to any figure, and will
                  be added automatically by the modules or
@@ -1230,7 +1732,7 @@ def array2d_source(*args, **kwargs):
 
         :mask: Mask points specified in a boolean masking array.
     """
-    data_source = MArray2DSource()
+    data_source = MArray2DSource(**_source_traits(kwargs))
     mask = kwargs.pop('mask', None)
     if len(args) == 1 :
         args = convert_to_arrays(args)
@@ -1259,6 +1761,10 @@ def grid_source(x, y, z, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :scalars: optional scalar data.
 
         :figure: optionally, the figure on which to add the data source.
@@ -1271,6 +1777,12 @@ def grid_source(x, y, z, **kwargs):
                  
         :mask: Mask points specified in a boolean masking array.
 
+        :implicit_geometry: if True and the x, y, z arrays describe an
+                            axis-aligned plane (for instance when created
+                            with `numpy.mgrid`), an `ImageData` or a
+                            `RectilinearGrid` is created instead of
+                            storing every point.  Defaults to False.
+
         """
     scalars = kwargs.pop('scalars', None)
     if scalars is None:
@@ -1278,7 +1790,7 @@ def grid_source(x, y, z, **kwargs):
     mask = kwargs.pop('mask', None)
 
     x, y, z, scalars = convert_to_arrays((x, y, z, scalars))
-    data_source = MGridSource()
+    data_source = MGridSource(**_source_traits(kwargs, grid=True))
     data_source.reset(x=x, y=y, z=z, scalars=scalars, mask=mask)
 
     name = kwargs.pop('name', 'GridSource')
@@ -1318,6 +1830,10 @@ def vertical_vectors_source(*args, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :figure: optionally, the figure on which to add the data source.
                  If None, the source is not added to any figure, and will
                  be added automatically by the modules or
@@ -1339,7 +1855,7 @@ def vertical_vectors_source(*args, **kwargs):
     if s is not None:
         s = np.ravel(s)
 
-    data_source = MVerticalGlyphSource()
+    data_source = MVerticalGlyphSource(**_source_traits(kwargs))
     data_source.reset(x=x, y=y, z=z, scalars=s)
 
     name = kwargs.pop('name', 'VerticalVectorsSource')
@@ -1360,6 +1876,10 @@ def triangular_mesh_source(x, y, z, triangles, **kwargs):
 
         :name: the name of the vtk object created.
 
+        :precision: 'single' to store the data as float32, halving the
+                    memory used, or 'double'.  Defaults to the mlab
+                    `precision` option.
+
         :scalars: optional scalar data.
 
         :figure: optionally, the figure on which to add the data source.
@@ -1381,7 +1901,7 @@ def triangular_mesh_source(x, y, z, triangles, **kwargs):
     if scalars is None:
         scalars = z
 
-    data_source = MTriangularMeshSource()
+    data_source = MTriangularMeshSource(**_source_traits(kwargs))
     data_source.reset(x=x, y=y, z=z, triangles=triangles, scalars=scalars)
 
     name = kwargs.pop('name', 'TriangularMeshSource')
@@ -1390,6 +1910,42 @@ def triangular_mesh_source(x, y, z, triangles, **kwargs):
     return ds
 
 
+def shared_array_source(segment, **kwargs):
+    """
+    Creates a source showing the frames that another process writes in
+    a shared memory segment with
+    `mayavi.tools.shared_array.SharedArrayWriter`.  The frames are used
+    by VTK without a copy.
+
+    **Function signatures**::
+
+        shared_array_source(segment, ...)
+
+    **Keyword arguments**:
+
+        :name: the name of the vtk object created.
+
+        :live: if True (the default), the segment is polled for new
+               frames.  If False, call the `poll` method of the source
+               to show the latest frame.
+
+        :poll_interval: the polling interval in milliseconds.
+
+        :figure: optionally, the figure on which to add the data source.
+                 If None, the source is not added to any figure, and will
+                 be added automatically by the modules or
+                 filters. If False, no figure will be created by modules
+                 or filters applied to the source: the source can only
+                 be used for testing, or numerical algorithms, not
+                 visualization."""
+    traits = dict(segment=segment, live=kwargs.pop('live', True))
+    if 'poll_interval' in kwargs:
+        traits['poll_interval'] = kwargs.pop('poll_interval')
+    data_source = SharedArraySource(**traits)
+    name = kwargs.pop('name', 'SharedArray')
+    return tools.add_dataset(data_source, name, **kwargs)
+
+
 def open(filename, figure=None):
     """Open a supported data file given a filename.  Returns the source
     object if a suitable reader was found for the file.
@@ -107,6 +107,71 @@ def _traverse(node):
         pass
     yield node
 
+def memory_report(obj=None):
+    """ Returns a report of the memory used by the datasets of the
+        given object and all the objects below it on the pipeline.
+
+        **Parameters**
+
+        :obj: optional Mayavi object (engine, scene, source, filter or
+              module). Defaults to the current engine.
+
+        **Returns**
+
+        :report: A `MemoryReport`. Print it to get a table; use its
+                 `to_dict` method to get a nested dictionary with the
+                 bytes owned by each node, the part of those pinned by
+                 numpy arrays and the bytes shared with other nodes.
+
+        **Example**
+
+        ::
+
+            print mlab.pipeline.memory_report()
+
+    """
+    from mayavi.core.memory_report import MemoryReport
+    from mayavi.core.common import get_object_path
+    engine = get_engine()
+    if obj is None:
+        obj = engine
+    path = get_object_path(obj, engine) or 'engine'
+    return MemoryReport(obj, path)
+
+def profile(enable=True, reset=False):
+    """ Profiles the executions of the objects on the pipeline of the
+        current engine.
+
+        **Parameters**
+
+        :enable: optional boolean flag: starts (True) or stops (False)
+                 observing the VTK algorithms of the pipeline.
+
+        :reset: optional boolean flag: clears the statistics collected
+                so far.
+
+        **Returns**
+
+        :profiler: The `PipelineProfiler` of the engine. Print it to get
+                   a table of the wall time, number of executions and
+                   output size of each object; use its `to_dict` method
+                   to get them keyed on the path of the objects.
+
+        **Example**
+
+        ::
+
+            mlab.pipeline.profile()
+            # ... change the data or the pipeline ...
+            print mlab.pipeline.profile()
+
+    """
+    profiler = get_engine().get_profiler()
+    profiler.enabled = enable
+    if reset:
+        profiler.reset()
+    return profiler
+
 def get_vtk_src(mayavi_object, stop_at_filter=True):
     """ Goes up the Mayavi pipeline to find the data sources of a given
         object.
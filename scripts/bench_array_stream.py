@@ -0,0 +1,103 @@
+#!/usr/bin/env python
+"""
+Script measuring the throughput of the binary array frames of the
+Mayavi server.  By default the frames are sent over a loopback socket
+to a thread receiving them with an `ArrayStreamReceiver`, which
+measures the cost of the parsing and of the copies alone.  Given the
+address of a running server (`mlab.server.serve_tcp`) and the name of
+a source, the frames are sent to it instead.
+
+Usage::
+
+    python bench_array_stream.py [n_frames [size [host:port source]]]
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+import socket
+import sys
+import threading
+import time
+
+import numpy
+
+from mayavi.tools.array_stream import ArrayStreamReceiver, send_array
+
+
+class Target(object):
+    """Holds the array received."""
+
+    def __init__(self, size):
+        self.scalars = numpy.zeros((size, size, size), 'float32')
+        self.n_update = 0
+
+    def update(self):
+        self.n_update += 1
+
+
+def receive(conn, target, result):
+    receiver = ArrayStreamReceiver(lambda source_id: target)
+    n = 0
+    while True:
+        data = conn.recv(1 << 20)
+        if not data:
+            break
+        n += len(data)
+        receiver.feed(data)
+        receiver.flush()
+    result.append(n)
+    conn.close()
+
+
+def send(sock, name, data, n_frames):
+    t0 = time.time()
+    for i in range(n_frames):
+        data[0, 0, 0] = i
+        send_array(sock, name, 'scalars', data)
+    return time.time() - t0
+
+
+def main(n_frames=50, size=64, address=None, name='ScalarField'):
+    data = numpy.random.rand(size, size, size).astype('float32')
+    mb = n_frames*data.nbytes/1e6
+    if address is not None:
+        host, port = address.split(':')
+        sock = socket.create_connection((host, int(port)))
+        dt = send(sock, name, data, n_frames)
+        sock.close()
+        print '%d frames, %.1f MB sent in %.3f s: %.1f MB/s' % \
+              (n_frames, mb, dt, mb/dt)
+        return
+
+    server = socket.socket()
+    server.bind(('127.0.0.1', 0))
+    server.listen(1)
+    sock = socket.create_connection(server.getsockname())
+    conn, addr = server.accept()
+    server.close()
+    target = Target(size)
+    result = []
+    t = threading.Thread(target=receive, args=(conn, target, result))
+    t.start()
+    t0 = time.time()
+    send(sock, name, data, n_frames)
+    sock.close()
+    t.join()
+    dt = time.time() - t0
+    assert result[0] >= data.nbytes*n_frames
+    assert target.scalars[0, 0, 0] == n_frames - 1
+    print '%d frames, %.1f MB received in %.3f s: %.1f MB/s, %d updates' % \
+          (n_frames, mb, dt, mb/dt, target.n_update)
+
+
+if __name__ == '__main__':
+    args = sys.argv[1:]
+    n_frames, size = 50, 64
+    if len(args) > 0:
+        n_frames = int(args[0])
+    if len(args) > 1:
+        size = int(args[1])
+    if len(args) > 3:
+        main(n_frames, size, args[2], args[3])
+    else:
+        main(n_frames, size)
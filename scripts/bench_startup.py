@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+"""
+Script measuring the startup costs of mayavi: the time to import the
+api, to start an engine, to create the file readers and to open small
+files with `engine.open`.  Useful to check that batch jobs opening many
+files do not pay for work done per file.
+
+Usage::
+
+    python bench_startup.py [n_repeat]
+"""
+# Copyright (c) 2009, Enthought, Inc.
+# License: BSD Style.
+
+import os
+import sys
+import time
+
+# The example files opened, from mayavi/tests/data.
+FILES = ['caffeine.pdb', 'humanoid_tri.stla', 'pyramid.ply',
+         'foot.mha', 'prism.neu', 'cube.vti']
+
+DATA_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        os.pardir, 'mayavi', 'tests', 'data')
+
+
+def timeit(label, func, n=1):
+    """Calls `func` `n` times and prints the mean time per call."""
+    t0 = time.time()
+    for i in range(n):
+        func()
+    dt = (time.time() - t0)/n
+    print '%-40s %10.3f ms' % (label, dt*1e3)
+    return dt
+
+
+def main(n=20):
+    t0 = time.time()
+    from mayavi.core.null_engine import NullEngine
+    from mayavi.sources.poly_data_reader import PolyDataReader
+    from mayavi.sources.image_reader import ImageReader
+    from mayavi.sources.unstructured_grid_reader import \
+         UnstructuredGridReader
+    print '%-40s %10.3f ms' % ('import', (time.time() - t0)*1e3)
+
+    e = NullEngine()
+    timeit('engine start', e.start)
+    e.new_scene()
+
+    for cls in (PolyDataReader, ImageReader, UnstructuredGridReader):
+        timeit('%s()' % cls.__name__, cls, n)
+
+    for name in FILES:
+        fname = os.path.join(DATA_DIR, name)
+        if not os.path.exists(fname):
+            continue
+        def _open():
+            src = e.open(fname)
+            src.remove()
+        timeit('engine.open(%r)' % name, _open, n)
+
+    e.stop()
+
+
+if __name__ == '__main__':
+    n = 20
+    if len(sys.argv) > 1:
+        n = int(sys.argv[1])
+    main(n)
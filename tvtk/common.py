@@ -8,6 +8,15 @@ dependencies (apart from the standard library of course).
 
 import string
 import re
+import sys
+import time
+from math import ceil
+
+# The most accurate wall clock available.
+if sys.platform == 'win32':
+    clock = time.clock
+else:
+    clock = time.time
 
 ######################################################################
 # Utility functions.
@@ -75,3 +84,36 @@ class _Camel2Enthought:
 
 # Instantiate a converter.
 camel2enthought = _Camel2Enthought()
+
+
+def percentile(values, q):
+    """Returns the `q` th percentile (0 <= q <= 100) of a sequence
+    using the nearest-rank method, 0.0 for an empty sequence.
+
+    For example::
+
+      >>> percentile(range(1, 101), 95)
+      95
+
+    """
+    if len(values) == 0:
+        return 0.0
+    s = sorted(values)
+    idx = int(ceil(q/100.0*len(s))) - 1
+    return s[min(max(idx, 0), len(s) - 1)]
+
+
+def format_table(header, rows):
+    """Formats the rows (sequences of strings) as a text table under
+    the given header.  The first column is left justified, the others
+    right justified."""
+    rows = list(rows)
+    widths = [max(len(r[i]) for r in rows + [header])
+              for i in range(len(header))]
+    def fmt(row):
+        cells = [row[0].ljust(widths[0])]
+        cells.extend(c.rjust(w) for c, w in zip(row[1:], widths[1:]))
+        return '  '.join(cells)
+    lines = [fmt(header), '-'*len(fmt(header))]
+    lines.extend(fmt(r) for r in rows)
+    return '\n'.join(lines)
@@ -0,0 +1,185 @@
+"""Rolling statistics of the renders of a scene.
+
+"""
+# Copyright (c) 2008, Enthought, Inc.
+# License: BSD Style.
+
+from collections import deque
+
+from traits.api import HasTraits, Int, Float, Range, Property, \
+     Bool, List
+
+from tvtk.common import clock, percentile
+
+# The upper edges (in milliseconds) of the bins of the frame time
+# histogram.  The last bin collects all slower frames.
+HISTOGRAM_EDGES = (1, 2, 5, 10, 20, 50, 100, 200, 500, 1000)
+
+
+######################################################################
+# `RenderStats` class.
+######################################################################
+class RenderStats(HasTraits):
+    """Statistics of the renders of a scene.  Times are in seconds.  The
+    percentiles and the render rate are computed over the last `window`
+    renders, the counters and the histogram over all renders since the
+    last `reset`.
+    """
+
+    # Number of renders over which the rolling statistics are computed.
+    window = Range(1, 100000, 100,
+                   desc='the number of renders used for the statistics')
+
+    # Count the triangles and points of the visible actors at each
+    # render.  This walks the props of the renderer.
+    count_primitives = Bool(True,
+                  desc='if the primitives drawn at each render are counted')
+
+    # Number of renders done.
+    n_renders = Int(0)
+
+    # Number of renders that were requested while `disable_render` was
+    # set on the scene.
+    n_suppressed = Int(0)
+
+    # Duration of the last render.
+    last_time = Float(0.0)
+
+    # Polygons (triangles and strips) and points of the visible actors
+    # at the last render.
+    n_triangles = Int(0)
+    n_points = Int(0)
+
+    # Number of renders in each bin of `HISTOGRAM_EDGES`.
+    histogram = List(Int)
+
+    # Rolling statistics.
+    mean_time = Property(Float, depends_on='n_renders')
+    p50_time = Property(Float, depends_on='n_renders')
+    p95_time = Property(Float, depends_on='n_renders')
+    max_time = Property(Float, depends_on='n_renders')
+    renders_per_second = Property(Float, depends_on='n_renders')
+
+    ######################################################################
+    # `object` interface.
+    ######################################################################
+    def __init__(self, **traits):
+        # The buffers must exist when `window` is set by the traits.
+        self._start = None
+        self._reset_window()
+        super(RenderStats, self).__init__(**traits)
+        self.histogram = [0]*(len(HISTOGRAM_EDGES) + 1)
+
+    ######################################################################
+    # `RenderStats` interface.
+    ######################################################################
+    def start(self):
+        """Marks the start of a render."""
+        self._start = clock()
+
+    def end(self, renderer=None):
+        """Marks the end of a render started with `start`.  The
+        primitives of the given VTK renderer are counted if
+        `count_primitives` is set."""
+        if self._start is None:
+            return
+        now = clock()
+        dt = now - self._start
+        self._start = None
+        if renderer is not None and self.count_primitives:
+            self.n_triangles, self.n_points = self._count(renderer)
+        self.record(dt, now)
+
+    def record(self, dt, timestamp=None):
+        """Records a render that took `dt` seconds."""
+        if timestamp is None:
+            timestamp = clock()
+        self._times.append(dt)
+        self._stamps.append(timestamp)
+        ms = dt*1e3
+        for i, edge in enumerate(HISTOGRAM_EDGES):
+            if ms < edge:
+                break
+        else:
+            i = len(HISTOGRAM_EDGES)
+        self.histogram[i] += 1
+        self.last_time = dt
+        self.n_renders += 1
+
+    def suppressed(self):
+        """Records a render request that was ignored."""
+        self.n_suppressed += 1
+
+    def reset(self):
+        """Clears all the statistics."""
+        self._reset_window()
+        self.histogram = [0]*(len(HISTOGRAM_EDGES) + 1)
+        self.set(n_suppressed=0, last_time=0.0, n_triangles=0,
+                 n_points=0)
+        self.n_renders = 0
+
+    def to_dict(self):
+        """Returns the statistics as a dictionary."""
+        return dict(n_renders=self.n_renders,
+                    n_suppressed=self.n_suppressed,
+                    last_time=self.last_time,
+                    mean_time=self.mean_time, p50_time=self.p50_time,
+                    p95_time=self.p95_time, max_time=self.max_time,
+                    renders_per_second=self.renders_per_second,
+                    n_triangles=self.n_triangles, n_points=self.n_points,
+                    histogram=zip(HISTOGRAM_EDGES + (None,),
+                                  self.histogram))
+
+    ######################################################################
+    # Non-public interface.
+    ######################################################################
+    def _reset_window(self):
+        self._times = deque(maxlen=self.window)
+        self._stamps = deque(maxlen=self.window)
+
+    def _window_changed(self, value):
+        self._times = deque(self._times, maxlen=value)
+        self._stamps = deque(self._stamps, maxlen=value)
+
+    def _count(self, renderer):
+        """Returns the number of polygons and points of the visible
+        actors of a VTK renderer."""
+        n_tri = n_pts = 0
+        props = renderer.GetViewProps()
+        props.InitTraversal()
+        for i in range(props.GetNumberOfItems()):
+            prop = props.GetNextProp()
+            if not prop.GetVisibility() or not prop.IsA('vtkActor'):
+                continue
+            mapper = prop.GetMapper()
+            if mapper is None:
+                continue
+            data = mapper.GetInput()
+            if data is None:
+                continue
+            n_pts += data.GetNumberOfPoints()
+            if data.IsA('vtkPolyData'):
+                n_tri += data.GetNumberOfPolys() + data.GetNumberOfStrips()
+        return n_tri, n_pts
+
+    def _get_mean_time(self):
+        if len(self._times) == 0:
+            return 0.0
+        return sum(self._times)/len(self._times)
+
+    def _get_p50_time(self):
+        return percentile(self._times, 50)
+
+    def _get_p95_time(self):
+        return percentile(self._times, 95)
+
+    def _get_max_time(self):
+        if len(self._times) == 0:
+            return 0.0
+        return max(self._times)
+
+    def _get_renders_per_second(self):
+        stamps = self._stamps
+        if len(stamps) < 2 or stamps[-1] <= stamps[0]:
+            return 0.0
+        return (len(stamps) - 1)/(stamps[-1] - stamps[0])
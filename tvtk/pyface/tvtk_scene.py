@@ -19,9 +19,10 @@ from tvtk import messenger
 from tvtk.tvtk_base import vtk_color_trait
 
 from traits.api import HasPrivateTraits, HasTraits, Any, Int, \
-     Property, Instance, Event, Range, Bool, Trait, Str
+     Property, Instance, Event, Range, Bool, Trait, Str, List
 
 from tvtk.pyface import light_manager
+from tvtk.pyface.render_stats import RenderStats
 
 VTK_VER = tvtk.Version().vtk_version
 
@@ -134,6 +135,10 @@ class TVTKScene(HasPrivateTraits):
     # Is the scene busy or not.
     busy = Property(Bool, record=False)
 
+    # Statistics of the renders of this scene (frame times, render
+    # rate, primitives drawn and suppressed renders).
+    render_stats = Instance(RenderStats, (), record=False)
+
     ########################################
     # Events
 
@@ -177,6 +182,7 @@ class TVTKScene(HasPrivateTraits):
     # Cached last camera state.
     _last_camera_state = Any(transient=True)
     _camera_observer_id = Int(transient=True)
+    _render_observer_ids = List(transient=True)
     _script_id = Str(transient=True)
 
     # The renderer instance.
@@ -209,7 +215,8 @@ class TVTKScene(HasPrivateTraits):
         for x in ['control', '_renwin', '_interactor', '_camera',
                   '_busy_count', '__sync_trait__', 'recorder',
                   '_last_camera_state', '_camera_observer_id',
-                  '_script_id', '__traits_listener__']:
+                  '_render_observer_ids',
+                  '_script_id', '__traits_listener__', 'render_stats']:
             d.pop(x, None)
         # Additionally pickle these.
         d['camera'] = self.camera
@@ -234,6 +241,8 @@ class TVTKScene(HasPrivateTraits):
         `disable_render` trait is set to True."""
         if not self.disable_render:
             self._renwin.render()
+        else:
+            self.render_stats.suppressed()
 
     def add_actors(self, actors):
         """ Adds a single actor or a tuple or list of actors to the
@@ -839,6 +848,33 @@ class TVTKScene(HasPrivateTraits):
         self._renderer.reset_camera()
         self.render()
 
+    def _renwin_changed(self, old, new):
+        """Times the renders of the render window, including those
+        not requested through `render`."""
+        if old is not None:
+            for id in self._render_observer_ids:
+                old.remove_observer(id)
+            o_vtk = tvtk.to_vtk(old)
+            messenger.disconnect(o_vtk, 'StartEvent', self._on_render_start)
+            messenger.disconnect(o_vtk, 'EndEvent', self._on_render_end)
+        self._render_observer_ids = []
+        if new is not None:
+            self._render_observer_ids = [
+                new.add_observer('StartEvent', messenger.send),
+                new.add_observer('EndEvent', messenger.send)]
+            n_vtk = tvtk.to_vtk(new)
+            messenger.connect(n_vtk, 'StartEvent', self._on_render_start)
+            messenger.connect(n_vtk, 'EndEvent', self._on_render_end)
+
+    def _on_render_start(self, vtk_obj=None, event=None):
+        self.render_stats.start()
+
+    def _on_render_end(self, vtk_obj=None, event=None):
+        renderer = self._renderer
+        if renderer is not None:
+            renderer = tvtk.to_vtk(renderer)
+        self.render_stats.end(renderer)
+
     def _disable_render_changed(self, val):
         if not val and self._renwin is not None:
             self.render()
@@ -0,0 +1,85 @@
+"""Tests for the render statistics of the tvtk scenes."""
+
+import unittest
+
+from tvtk.api import tvtk
+from tvtk.common import percentile, format_table
+from tvtk.pyface.render_stats import RenderStats, HISTOGRAM_EDGES
+
+
+class TestRenderStats(unittest.TestCase):
+
+    def test_percentile(self):
+        self.assertEqual(percentile([], 50), 0.0)
+        values = range(1, 101)
+        self.assertEqual(percentile(values, 0), 1)
+        self.assertEqual(percentile(values, 50), 50)
+        self.assertEqual(percentile(values, 95), 95)
+        self.assertEqual(percentile(values, 100), 100)
+        self.assertEqual(percentile([3.0], 50), 3.0)
+
+    def test_format_table(self):
+        t = format_table(('Name', 'N'), [('a', '1'), ('bcd', '10')])
+        self.assertEqual(t.splitlines(),
+                         ['Name   N', '--------', 'a      1', 'bcd   10'])
+
+    def test_record(self):
+        s = RenderStats()
+        for i in range(10):
+            s.record(0.001*(i + 1), timestamp=0.1*i)
+        self.assertEqual(s.n_renders, 10)
+        self.assertAlmostEqual(s.max_time, 0.01)
+        self.assertAlmostEqual(s.mean_time, 0.0055)
+        self.assertAlmostEqual(s.p95_time, 0.01)
+        self.assertAlmostEqual(s.renders_per_second, 10.0)
+        self.assertEqual(sum(s.histogram), 10)
+        self.assertEqual(len(s.histogram), len(HISTOGRAM_EDGES) + 1)
+        # A very slow frame lands in the last bin.
+        s.record(10.0)
+        self.assertEqual(s.histogram[-1], 1)
+
+        s.suppressed()
+        self.assertEqual(s.n_suppressed, 1)
+        d = s.to_dict()
+        self.assertEqual(d['n_renders'], 11)
+        self.assertEqual(d['n_suppressed'], 1)
+
+        s.reset()
+        self.assertEqual(s.n_renders, 0)
+        self.assertEqual(s.n_suppressed, 0)
+        self.assertEqual(sum(s.histogram), 0)
+        self.assertEqual(s.max_time, 0.0)
+
+    def test_window(self):
+        s = RenderStats(window=5)
+        self.assertEqual(s._times.maxlen, 5)
+        for i in range(10):
+            s.record(float(i))
+        self.assertEqual(s.max_time, 9.0)
+        self.assertEqual(s.mean_time, 7.0)
+        s.window = 2
+        self.assertEqual(s.mean_time, 8.5)
+        # The histogram covers every render.
+        self.assertEqual(sum(s.histogram), 10)
+
+    def test_count(self):
+        s = RenderStats()
+        cs = tvtk.ConeSource(resolution=8)
+        m = tvtk.PolyDataMapper(input=cs.output)
+        a = tvtk.Actor(mapper=m)
+        r = tvtk.Renderer()
+        r.add_actor(a)
+        cs.update()
+        s.start()
+        s.end(tvtk.to_vtk(r))
+        self.assertEqual(s.n_renders, 1)
+        self.assertEqual(s.n_points, cs.output.number_of_points)
+        self.assertEqual(s.n_triangles, cs.output.number_of_polys)
+        a.visibility = False
+        s.start()
+        s.end(tvtk.to_vtk(r))
+        self.assertEqual(s.n_points, 0)
+
+
+if __name__ == '__main__':
+    unittest.main()